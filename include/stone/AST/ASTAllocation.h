@@ -1,14 +1,71 @@
 #ifndef STONE_AST_ASTALLOCATION_H
 #define STONE_AST_ASTALLOCATION_H
 
+#include "stone/Basic/Memory.h"
+#include "stone/Basic/MemoryCage.h"
+
+#include "llvm/Support/Allocator.h"
+
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 namespace stone {
 
 class ASTContext;
+
+/// What an allocation in the ASTContext is for. Only used to break down the
+/// memory statistics.
+enum class ASTAllocationKind : uint8_t {
+  Decl,
+  Expr,
+  Stmt,
+  Type,
+  Identifier,
+  Other,
+};
+
+/// The allocator behind the ASTContext arenas. With compressed references,
+/// its slabs come from the memory cage of the ASTContext.
+#ifdef STONE_COMPRESSED_AST_REFS
+using ASTArenaAllocator = llvm::BumpPtrAllocatorImpl<MemoryCageSlabAllocator>;
+#else
+using ASTArenaAllocator = llvm::BumpPtrAllocator;
+#endif
+
+/// A reference from an AST node to another node of the same ASTContext.
+///
+/// When stone is configured with STONE_ENABLE_COMPRESSED_AST_REFS, the
+/// reference is a 32-bit offset into the memory cage of the ASTContext, and
+/// decompressing it needs the address of the node that holds it. Otherwise
+/// it is a plain pointer and the holder is ignored.
+template <typename T> class ASTRef final {
+#ifdef STONE_COMPRESSED_AST_REFS
+  uint32_t offset = 0;
+
+public:
+  ASTRef() = default;
+  ASTRef(T *ptr) : offset(MemoryCage::Compress(ptr)) {}
+
+  T *Get(const void *holder) const {
+    return static_cast<T *>(MemoryCage::Decompress(holder, offset));
+  }
+  bool IsNull() const { return offset == 0; }
+#else
+  T *ptr = nullptr;
+
+public:
+  ASTRef() = default;
+  ASTRef(T *ptr) : ptr(ptr) {}
+
+  T *Get(const void *holder) const { return ptr; }
+  bool IsNull() const { return ptr == nullptr; }
+#endif
+};
+
 void *AllocateInASTContext(size_t bytes, const ASTContext &ctx,
-                           unsigned alignment);
+                           MemoryAllocationArena arena, unsigned alignment,
+                           ASTAllocationKind kind);
 
 /// Types inheriting from this class are intended to be allocated in an
 /// \c ASTContext allocator; you cannot allocate them by using a normal \c
@@ -16,8 +73,11 @@ void *AllocateInASTContext(size_t bytes, const ASTContext &ctx,
 /// \c new.
 ///
 /// The template parameter is a type with the desired alignment. It is usually,
-/// but not always, the type that is inheriting \c ASTAllocated.
-template <typename AlignTy> class ASTAllocation {
+/// but not always, the type that is inheriting \c ASTAllocated. \p Kind is the
+/// category the allocations are counted under.
+template <typename AlignTy,
+          ASTAllocationKind Kind = ASTAllocationKind::Other>
+class ASTAllocation {
 public:
   // Make vanilla new/delete illegal.
   void *operator new(size_t bytes) throw() = delete;
@@ -25,9 +85,11 @@ public:
 
   // Only allow allocation using the allocator in MemoryContext
   // or by doing a placement new.
-  void *operator new(size_t bytes, const ASTContext &ctx,
-                     unsigned alignment = alignof(AlignTy)) {
-    return stone::AllocateInASTContext(bytes, ctx, alignment);
+  void *
+  operator new(size_t bytes, const ASTContext &ctx,
+               MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent,
+               unsigned alignment = alignof(AlignTy)) {
+    return stone::AllocateInASTContext(bytes, ctx, arena, alignment, Kind);
   }
   void *operator new(size_t bytes, void *mem) throw() {
     assert(mem && "placement new into failed allocation");
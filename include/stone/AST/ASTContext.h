@@ -3,12 +3,17 @@
 
 #include "stone/AST/Builtin.h"
 #include "stone/AST/DeclName.h"
+#include "stone/AST/Evaluator.h"
 #include "stone/AST/Identifier.h"
 #include "stone/AST/Import.h"
+#include "stone/AST/ImportCache.h"
 #include "stone/AST/LangABI.h"
 #include "stone/AST/SearchPath.h"
+#include "stone/AST/SubstitutionMap.h"
 #include "stone/AST/Type.h"
 #include "stone/AST/TypeCheckerOptions.h"
+#include "stone/AST/Types.h"
+#include "stone/AST/Visibility.h"
 #include "stone/Basic/LangOptions.h"
 #include "stone/Basic/Memory.h"
 #include "stone/Basic/SrcMgr.h"
@@ -52,15 +57,19 @@
 #include <vector>
 
 namespace stone {
+class AvailabilityContext;
 class DiagnosticEngine;
 class BlockExpr;
 class LangABI;
 class Decl;
+class InterfaceDecl;
+class NominalTypeDecl;
 class ConstructorDecl;
 class MethodDecl;
 class RecordDecl;
 class Expr;
 class MangleContext;
+class ValueDecl;
 class Module;
 class Stmt;
 class ASTContext;
@@ -74,6 +83,15 @@ class SwitchStmt;
 class Expr;
 class StatsReporter;
 
+/// The compilation phase that AST allocations are attributed to in the
+/// memory statistics.
+enum class ASTAllocationPhase : uint8_t {
+  None = 0,
+  Parse,
+  Sema,
+  CodeGen,
+};
+
 /// Look up option used in \c GetRealModuleName when module aliasing is applied.
 enum class ModuleAliasLookupOption {
   AlwaysRealName,
@@ -82,6 +100,8 @@ enum class ModuleAliasLookupOption {
 };
 
 class ASTContext final {
+  friend class TemporaryArenaScope;
+  friend class SubstitutionMap;
 
   /// The search path options
   const SearchPathOptions &searchPathOpts;
@@ -92,21 +112,77 @@ class ASTContext final {
 
   TypeCheckerOptions &typeCheckerOpts;
 
-  Builtin builtin;
-
   ClangImporter &clangImporter;
 
-  mutable llvm::BumpPtrAllocator allocator;
+#ifdef STONE_COMPRESSED_AST_REFS
+  /// The address space every arena allocates from, so that AST nodes can
+  /// refer to each other through 32-bit offsets. It must outlive every
+  /// member that touches arena memory when it is destroyed.
+  MemoryCagePtr cage;
+#endif
+
+  mutable ASTArenaAllocator allocator;
+
+  /// The temporary arenas, one for each nesting depth of TemporaryArenaScope.
+  /// An arena is reset, not freed, when its scope ends, so the next scope at
+  /// the same depth reuses it and the slab it kept.
+  mutable llvm::SmallVector<std::unique_ptr<ASTArenaAllocator>, 4>
+      temporaryArenas;
+
+  /// The number of active TemporaryArenaScopes; the innermost one allocates
+  /// from temporaryArenas[numActiveTemporaryArenas - 1].
+  mutable unsigned numActiveTemporaryArenas = 0;
 
   using IdentifierTable =
-      llvm::StringMap<Identifier::Aligner, llvm::BumpPtrAllocator &>;
+      llvm::StringMap<Identifier::Aligner, ASTArenaAllocator &>;
   mutable IdentifierTable identifierTable;
 
   mutable DeclNameTable declNames;
 
+  /// The transitive imports of modules, computed on demand.
+  mutable ImportCache importCache;
+
+  /// The effective visibility of decls and types, computed on demand.
+  mutable VisibilityCache visibilityCache;
+
   /// All builtin types will be stored here.
   mutable llvm::SmallVector<Type *, 0> builtinTypes;
 
+  /// The uniquing tables for structural types. Each structural type is created
+  /// once, so two types with the same structure are the same node.
+  mutable llvm::FoldingSet<FunType> funTypes;
+  mutable llvm::FoldingSet<PointerType> pointerTypes;
+  mutable llvm::FoldingSet<ReferenceType> referenceTypes;
+  mutable llvm::DenseMap<std::pair<TypeBase *, unsigned>, QualifiedType *>
+      qualifiedTypes;
+
+  /// The uniqued substitution maps.
+  mutable llvm::FoldingSet<SubstitutionMap::Storage> substitutionMaps;
+
+  /// Whether a canonical type conforms to an interface, for every pair asked
+  /// about so far.
+  mutable llvm::DenseMap<std::pair<TypeBase *, InterfaceDecl *>, bool>
+      conformances;
+
+  /// The generation of every conformance table that is still current.
+  unsigned conformanceGeneration = 0;
+
+  /// The result of each substitution done so far.
+  mutable llvm::DenseMap<std::pair<TypeBase *, SubstitutionMap>, TypeBase *>
+      substitutedTypes;
+
+  /// The mangled name of each decl asked about so far, allocated in this
+  /// context.
+  mutable llvm::DenseMap<const ValueDecl *, llvm::StringRef> mangledNames;
+
+  /// The availability each decl is annotated with, allocated in this
+  /// context. Decls do not carry attributes yet, so annotations live here.
+  llvm::DenseMap<const Decl *, const AvailabilityContext *>
+      annotatedAvailability;
+
+  /// The type each join adds its members to.
+  llvm::DenseMap<const DeclContext *, NominalTypeDecl *> joinedTypes;
+
   /// The standard library module.
   mutable ModuleDecl *stdlibModule = nullptr;
 
@@ -134,6 +210,16 @@ class ASTContext final {
 
   StatsReporter *stats;
 
+  /// The phase new allocations are counted under.
+  ASTAllocationPhase allocationPhase = ASTAllocationPhase::None;
+
+  /// The builtin types. Declared after the arenas and the stats reporter,
+  /// which creating them uses.
+  Builtin builtin;
+
+  /// Answers semantic requests and remembers the answers.
+  mutable Evaluator evaluator;
+
   /// OutputBackend for writing outputs.
   // llvm::IntrusiveRefCntPtr<llvm::vfs::OutputBackend> outputBackend;
 public:
@@ -170,12 +256,28 @@ public:
 
   DeclNameTable &GetDeclNameTable() { return declNames; }
 
+  /// \return the uniqued compound name \p nameBase(\p argumentNames).
+  DeclName GetCompoundName(DeclNameBase nameBase,
+                           llvm::ArrayRef<Identifier> argumentNames) const {
+    return declNames.GetCompoundName(nameBase, argumentNames);
+  }
+
+  /// \return the uniqued special name of kind \p kind with \p nameBase.
+  DeclName GetSpecialName(DeclNameKind kind, DeclNameBase nameBase) const {
+    return declNames.GetSpecialName(kind, nameBase);
+  }
+
   DiagnosticEngine &GetDiags() { return de; }
   ///
   LangABI *GetLangABI() const;
   //
   SrcMgr &GetSrcMgr() { return de.GetSrcMgr(); }
 
+  ImportCache &GetImportCache() const { return importCache; }
+
+  VisibilityCache &GetVisibilityCache() const { return visibilityCache; }
+  Evaluator &GetEvaluator() const { return evaluator; }
+
   LangOptions &GetLangOptions() { return langOpts; }
 
   TypeCheckerOptions &GetTypeCheckerOptions() { return typeCheckerOpts; }
@@ -184,6 +286,9 @@ public:
   /// Set a new stats reporter.
   void SetStats(StatsReporter *inputStats) { stats = inputStats; }
 
+  ASTAllocationPhase GetAllocationPhase() const { return allocationPhase; }
+  void SetAllocationPhase(ASTAllocationPhase phase) { allocationPhase = phase; }
+
 public:
   //==Module stuff==//
   // Module *GetModule(UsingPath::Module modulePath);
@@ -211,9 +316,37 @@ public:
   /// in this context.
   void AddLoadedModule(ModuleDecl *mod);
 
+  /// Map the serialized module at \p path and register it as a loaded
+  /// module. Its decls are only deserialized when they are looked up.
+  /// \return the module, or nullptr after diagnosing an error.
+  ModuleDecl *LoadSerializedModule(llvm::StringRef path);
+
   /// If \p T is null pointer, assume the target in ASTContext.
   MangleContext *CreateMangleContext(const clang::TargetInfo *T = nullptr);
 
+  /// \return the mangled symbol name of \p decl. Each decl is mangled once;
+  /// later calls are a lookup.
+  llvm::StringRef GetMangledName(ValueDecl *decl) const;
+
+  /// Record that \p decl is annotated as available in \p available. Do this
+  /// before the availability of any context inside \p decl is asked for:
+  /// DeclContext::GetAvailabilityContext remembers its answer.
+  void SetAnnotatedAvailability(const Decl *decl,
+                                const AvailabilityContext &available);
+
+  /// \return the availability \p decl is annotated with, or null.
+  const AvailabilityContext *GetAnnotatedAvailability(const Decl *decl) const;
+
+  /// Record that \p join adds its members to \p nominal.
+  void SetJoinedType(const DeclContext *join, NominalTypeDecl *nominal) {
+    joinedTypes[join] = nominal;
+  }
+
+  /// \return the type \p join adds its members to, or null.
+  NominalTypeDecl *GetJoinedType(const DeclContext *join) const {
+    return joinedTypes.lookup(join);
+  }
+
   Identifier
   GetRealModuleName(Identifier key,
                     ModuleAliasLookupOption option =
@@ -245,50 +378,127 @@ public:
   void ClearStoneQual(Type *ty);
 
 public:
-  /// Allocate memory from the ASTContext bump pointer.
-  void *AllocateMemory(size_t bytes, unsigned alignment = 8) const {
+  //==Uniqued types==//
+
+  /// \return the unique function type with this signature.
+  FunType *GetFunType(Type returnType, llvm::ArrayRef<Type> paramTypes) const;
+
+  /// \return the unique raw pointer to \p pointeeType.
+  RawType *GetRawType(Type pointeeType) const;
+
+  /// \return the unique move pointer to \p pointeeType.
+  MoveType *GetMoveType(Type pointeeType) const;
+
+  /// \return the unique reference to \p referentType.
+  RefType *GetRefType(Type referentType) const;
+
+  /// \return \p baseType with \p quals added. Qualifiers already on
+  /// \p baseType are merged, and \p baseType itself is returned when there is
+  /// nothing to add.
+  Type GetQualifiedType(Type baseType, QualSpecs quals) const;
+
+  /// \return true if \p type conforms to \p interface. The answer for each
+  /// canonical type is remembered until an interface is added to a type.
+  bool ConformsTo(Type type, InterfaceDecl *interface) const;
+
+  /// Forget every remembered conformance answer and make every conformance
+  /// table stale. Called whenever an interface is added anywhere, because a
+  /// table includes what the interfaces it names inherit.
+  void InvalidateConformances() {
+    ++conformanceGeneration;
+    conformances.clear();
+  }
+
+  /// Bumped by InvalidateConformances. A conformance table built in an older
+  /// generation is rebuilt.
+  unsigned GetConformanceGeneration() const { return conformanceGeneration; }
+
+  /// \return \p type with the parameters of \p subs replaced. Each
+  /// (type, map) pair is substituted once; later calls are a lookup.
+  Type GetSubstitutedType(Type type, SubstitutionMap subs) const;
+
+private:
+  template <typename T>
+  T *GetPointerType(TypeKind kind, Type pointeeType) const;
+
+public:
+  /// Allocate memory from the ASTContext bump pointer. Temporary allocations
+  /// go to the innermost TemporaryArenaScope and are freed when it ends.
+  void *AllocateMemory(
+      size_t bytes, unsigned alignment = 8,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent,
+      ASTAllocationKind kind = ASTAllocationKind::Other) const {
     if (bytes == 0) {
       return nullptr;
     }
-    if (langOpts.useMalloc) {
+    if (stats) {
+      RecordAllocation(bytes, arena, kind);
+    }
+#ifndef STONE_COMPRESSED_AST_REFS
+    // Compressed references need every node in the cage. Temporary memory
+    // is never freed one allocation at a time, so it stays in its arena.
+    if (langOpts.useMalloc && arena == MemoryAllocationArena::Stoneanent) {
       return stone::AlignedAlloc(bytes, alignment);
     }
-    // TODO:
-    //  if (arena == MAllocationArena::Stoneanent && Stats)
-    //  Stats->GetMemoryCounters().NumMemoryBytesAllocated += bytes;
-    return GetAllocator().Allocate(bytes, alignment);
+#endif
+    return GetAllocator(arena).Allocate(bytes, alignment);
   }
 
-  template <typename T> T *AllocateMemory(size_t num = 1) const {
-    return static_cast<T *>(AllocateMemory(num * sizeof(T), alignof(T)));
+  template <typename T>
+  T *AllocateMemory(
+      size_t num = 1,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    return static_cast<T *>(
+        AllocateMemory(num * sizeof(T), alignof(T), arena));
   }
 
   ///
   void Deallocate(void *Ptr) const {}
 
-  /// Memory allocator
-  llvm::BumpPtrAllocator &GetAllocator() const;
+  /// Memory allocator for \p arena. There must be an active
+  /// TemporaryArenaScope to get the temporary one.
+  ASTArenaAllocator &GetAllocator(
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const;
 
   /// The total amount of memory used
   size_t GetTotalMemoryAllocated() const {
     return GetAllocator().getTotalMemory();
   }
 
+  /// The memory held by the temporary arenas, including the slabs they keep
+  /// for reuse between scopes.
+  size_t GetTemporaryMemoryAllocated() const;
+
+  /// Whether a TemporaryArenaScope is active.
+  bool HasTemporaryArena() const { return numActiveTemporaryArenas != 0; }
+
+private:
+  /// Count \p bytes into the AST memory statistics.
+  void RecordAllocation(size_t bytes, MemoryAllocationArena arena,
+                        ASTAllocationKind kind) const;
+
 public:
-  template <typename T> T *Allocate() const {
-    T *res = (T *)AllocateMemory(sizeof(T), alignof(T));
+  template <typename T>
+  T *Allocate(
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    T *res = (T *)AllocateMemory(sizeof(T), alignof(T), arena);
     new (res) T();
     return res;
   }
 
   template <typename T>
-  MutableArrayRef<T> AllocateUninitialized(unsigned NumElts) const {
-    T *Data = (T *)AllocateMemory(sizeof(T) * NumElts, alignof(T));
+  MutableArrayRef<T> AllocateUninitialized(
+      unsigned NumElts,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    T *Data = (T *)AllocateMemory(sizeof(T) * NumElts, alignof(T), arena);
     return {Data, NumElts};
   }
 
-  template <typename T> MutableArrayRef<T> Allocate(unsigned numElts) const {
-    T *res = (T *)AllocateMemory(sizeof(T) * numElts, alignof(T));
+  template <typename T>
+  MutableArrayRef<T>
+  Allocate(unsigned numElts,
+           MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    T *res = (T *)AllocateMemory(sizeof(T) * numElts, alignof(T), arena);
     for (unsigned i = 0; i != numElts; ++i)
       new (res + i) T();
     return {res, numElts};
@@ -296,56 +506,93 @@ public:
 
   /// Allocate a copy of the specified object.
   template <typename T>
-  typename std::remove_reference<T>::type *AllocateObjectCopy(T &&t) const {
+  typename std::remove_reference<T>::type *AllocateObjectCopy(
+      T &&t,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
     // This function cannot be named AllocateCopy because it would always win
     // overload resolution over the AllocateCopy(ArrayRef<T>).
     using TNoRef = typename std::remove_reference<T>::type;
-    TNoRef *res = (TNoRef *)AllocateMemory(sizeof(TNoRef), alignof(TNoRef));
+    TNoRef *res =
+        (TNoRef *)AllocateMemory(sizeof(TNoRef), alignof(TNoRef), arena);
     new (res) TNoRef(std::forward<T>(t));
     return res;
   }
 
-  template <typename T, typename It> T *AllocateCopy(It start, It end) const {
-    T *res = (T *)AllocateMemory(sizeof(T) * (end - start), alignof(T));
+  template <typename T, typename It>
+  T *AllocateCopy(
+      It start, It end,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    T *res = (T *)AllocateMemory(sizeof(T) * (end - start), alignof(T), arena);
     for (unsigned i = 0; start != end; ++start, ++i)
       new (res + i) T(*start);
     return res;
   }
 
   template <typename T, size_t N>
-  MutableArrayRef<T> AllocateCopy(T (&array)[N]) const {
-    return MutableArrayRef<T>(AllocateCopy<T>(array, array + N), N);
+  MutableArrayRef<T> AllocateCopy(
+      T (&array)[N],
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    return MutableArrayRef<T>(AllocateCopy<T>(array, array + N, arena), N);
   }
 
   template <typename T>
-  MutableArrayRef<T> AllocateCopy(ArrayRef<T> array) const {
-    return MutableArrayRef<T>(AllocateCopy<T>(array.begin(), array.end()),
-                              array.size());
+  MutableArrayRef<T> AllocateCopy(
+      ArrayRef<T> array,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    return MutableArrayRef<T>(
+        AllocateCopy<T>(array.begin(), array.end(), arena), array.size());
   }
 
   template <typename T>
-  ArrayRef<T> AllocateCopy(const SmallVectorImpl<T> &vec) const {
-    return AllocateCopy(ArrayRef<T>(vec));
+  ArrayRef<T> AllocateCopy(
+      const SmallVectorImpl<T> &vec,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    return AllocateCopy(ArrayRef<T>(vec), arena);
   }
 
   template <typename T>
-  MutableArrayRef<T> AllocateCopy(SmallVectorImpl<T> &vec) const {
-    return AllocateCopy(MutableArrayRef<T>(vec));
+  MutableArrayRef<T> AllocateCopy(
+      SmallVectorImpl<T> &vec,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
+    return AllocateCopy(MutableArrayRef<T>(vec), arena);
   }
 
-  StringRef AllocateCopy(StringRef Str) const {
+  StringRef AllocateCopy(
+      StringRef Str,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
     ArrayRef<char> Result =
-        AllocateCopy(llvm::ArrayRef(Str.data(), Str.size()));
+        AllocateCopy(llvm::ArrayRef(Str.data(), Str.size()), arena);
     return StringRef(Result.data(), Result.size());
   }
 
   template <typename T, typename Vector, typename Set>
-  MutableArrayRef<T>
-  AllocateCopy(llvm::SetVector<T, Vector, Set> setVector) const {
+  MutableArrayRef<T> AllocateCopy(
+      llvm::SetVector<T, Vector, Set> setVector,
+      MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent) const {
     return MutableArrayRef<T>(
-        AllocateCopy<T>(setVector.begin(), setVector.end()), setVector.size());
+        AllocateCopy<T>(setVector.begin(), setVector.end(), arena),
+        setVector.size());
   }
 };
+
+/// Opens a temporary arena for the lifetime of the scope. Scratch data that
+/// does not outlive a type-checking request or a function body, such as
+/// candidate lists, is allocated with MemoryAllocationArena::Temporary and
+/// released in one go when the scope ends. Scopes nest; allocations go to
+/// the innermost one.
+///
+/// Uniqued types are always permanent: the uniquing tables and the cached
+/// canonical types would otherwise point into freed memory.
+class TemporaryArenaScope final {
+  const ASTContext &astContext;
+
+public:
+  explicit TemporaryArenaScope(const ASTContext &astContext);
+  ~TemporaryArenaScope();
+
+  TemporaryArenaScope(const TemporaryArenaScope &) = delete;
+  TemporaryArenaScope &operator=(const TemporaryArenaScope &) = delete;
+};
 } // namespace stone
 
 #endif
\ No newline at end of file
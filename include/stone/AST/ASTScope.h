@@ -4,14 +4,18 @@
 #include "stone/AST/ASTAllocation.h"
 #include "stone/AST/Decl.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/STLExtras.h"
-#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/TinyPtrVector.h"
 #include <optional>
 
 namespace stone {
 class Decl;
+class SrcMgr;
+class ValueDecl;
 enum class ASTScopeKind : uint8 {
   None = 0,
   File,
@@ -32,9 +36,25 @@ class ASTScope : public ASTAllocation<ASTScope> {
   DiagnosticEngine &diags;
   ASTScope *parent = nullptr;
 
-  using DeclSet = llvm::SmallPtrSet<Decl *, 32>;
+  /// The decls of this scope, in the order they were added, so that lookups
+  /// return them in a deterministic order.
+  using DeclSet = llvm::SmallSetVector<Decl *, 32>;
   DeclSet scopeDecls;
 
+  /// Bumped whenever a decl is added or removed, so that lookup results
+  /// memoized from this scope or a scope under it can tell they are stale.
+  unsigned generation = 0;
+
+  /// The source covered by this scope.
+  SrcRange srcRange;
+
+  /// The named value decls of this scope, keyed by base name. Built from
+  /// scopeDecls on the first lookup into the scope.
+  using LookupTable =
+      llvm::DenseMap<DeclNameBase, llvm::TinyPtrVector<ValueDecl *>>;
+  LookupTable lookupTable;
+  bool hasLookupTable = false;
+
 public:
   ASTScope(ASTScopeKind kind, DiagnosticEngine &diags,
            ASTScope *parent = nullptr);
@@ -44,8 +64,40 @@ public:
   ASTScope *GetParent() { return parent; }
   const char *GetName() { return ASTScope::GetName(GetKind()); }
 
-  void AddDecl(Decl *d) { scopeDecls.insert(d); }
-  void RemoveDecl(Decl *d) { scopeDecls.erase(d); }
+  void AddDecl(Decl *d) {
+    if (scopeDecls.insert(d)) {
+      hasLookupTable = false;
+      ++generation;
+    }
+  }
+  void RemoveDecl(Decl *d) {
+    if (scopeDecls.remove(d)) {
+      hasLookupTable = false;
+      ++generation;
+    }
+  }
+
+  unsigned GetGeneration() const { return generation; }
+
+  /// \return the sum of the generations of this scope and its parents. It
+  /// changes whenever a decl visible from this scope is added or removed.
+  unsigned GetLookupGeneration() const;
+
+  SrcRange GetSrcRange() const { return srcRange; }
+  void SetSrcRange(SrcRange range) { srcRange = range; }
+
+  llvm::ArrayRef<ASTScope *> GetChildren() const { return storedChildren; }
+
+  /// Add \p child, keeping the children sorted by source range. Children
+  /// must not overlap.
+  void AddChild(ASTScope *child, const SrcMgr &sm);
+
+  /// \return the innermost scope under this one that contains \p loc, or this
+  /// scope if no child does.
+  ASTScope *FindInnermostScope(SrcLoc loc, const SrcMgr &sm);
+
+  /// \return the value decls named \p name declared directly in this scope.
+  llvm::ArrayRef<ValueDecl *> LookupLocal(DeclNameBase name);
 
 protected:
   using Children = SmallVector<ASTScope *, 4>;
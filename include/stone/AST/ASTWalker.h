@@ -36,6 +36,7 @@ public:
     void *Ptr = nullptr;
 
   public:
+    ParentASTNode() : parentKind(ASTDescription::Module) {}
     ParentASTNode(Module *M) : parentKind(ASTDescription::Module), Ptr(M) {}
     ParentASTNode(Decl *D) : parentKind(ASTDescription::Decl), Ptr(D) {}
     ParentASTNode(Stmt *S) : parentKind(ASTDescription::Stmt), Ptr(S) {}
@@ -328,12 +328,12 @@ public:
   /// has no availability annotation.
   static std::optional<AvailabilityContext>
   annotatedAvailableRange(const Decl *D, ASTContext &C);
-
-  static AvailabilityContext
-  annotatedAvailableRangeForAttr(const SpecializeAttribute *attr,
-                                 ASTContext &ctx);
 };
 
+/// Check that \p D is not annotated as available where its enclosing
+/// context is not.
+void CheckAvailability(Decl *D);
+
 } // end namespace stone
 
 #endif
\ No newline at end of file
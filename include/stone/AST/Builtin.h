@@ -3,6 +3,7 @@
 
 #include "stone/AST/Identifier.h"
 #include "stone/AST/Type.h"
+#include "stone/AST/TypeKind.h"
 
 namespace stone {
 
@@ -35,6 +36,9 @@ struct Builtin final {
 
   Type GetType(llvm::StringRef name);
 
+  /// \return the builtin type of \p kind, or a null type if there is none.
+  Type GetType(TypeKind kind) const;
+
   // Declare the set of builtin identifiers.
 #define BUILTIN_IDENTIFIER_WITH_NAME(Name, IdStr)                              \
   Identifier Builtin##Name##Identifier;
@@ -0,0 +1,60 @@
+#ifndef STONE_AST_CONFORMANCETABLE_H
+#define STONE_AST_CONFORMANCETABLE_H
+
+#include "stone/AST/ASTAllocation.h"
+
+#include "llvm/ADT/DenseMap.h"
+
+namespace stone {
+
+class DeclContext;
+class InterfaceDecl;
+class NominalTypeDecl;
+
+/// How a nominal type comes to conform to an interface.
+struct ConformanceEntry final {
+  InterfaceDecl *interface = nullptr;
+
+  /// The type, superclass or join whose inheritance clause names the
+  /// interface, or that names the interface that implies it.
+  DeclContext *declaredIn = nullptr;
+
+  /// The interface that inherits this one, or null if the interface is named
+  /// directly.
+  InterfaceDecl *impliedBy = nullptr;
+
+  bool IsImplied() const { return impliedBy != nullptr; }
+};
+
+/// A hashed table of every interface a nominal type conforms to, keyed by
+/// interface. NominalTypeDecl builds it on the first conformance query:
+/// the interfaces the type names, then those its superclasses name for a
+/// class, then everything those interfaces inherit.
+class ConformanceTable final : public ASTAllocation<ConformanceTable> {
+  llvm::DenseMap<InterfaceDecl *, ConformanceEntry> entries;
+
+  /// The conformance generation of the ASTContext when the table was last
+  /// built.
+  unsigned generation;
+
+public:
+  ConformanceTable(const ConformanceTable &) = delete;
+  ConformanceTable &operator=(const ConformanceTable &) = delete;
+
+public:
+  explicit ConformanceTable(unsigned generation) : generation(generation) {}
+
+public:
+  unsigned GetGeneration() const { return generation; }
+
+  /// Fill the table for \p nominal, dropping earlier entries.
+  void Build(NominalTypeDecl &nominal, unsigned newGeneration);
+
+  /// \return how the type conforms to \p interface, or null if it does not.
+  const ConformanceEntry *Find(InterfaceDecl *interface) const;
+
+  size_t GetNumConformances() const { return entries.size(); }
+};
+
+} // namespace stone
+#endif
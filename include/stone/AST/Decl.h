@@ -21,11 +21,12 @@
 #include "stone/Basic/Memory.h"
 #include "stone/Basic/SrcLoc.h"
 
-// #include "stone/AST/Redeclarable.h"
+#include "stone/AST/Redeclarable.h"
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/PointerUnion.h"
+#include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Casting.h"
@@ -55,10 +56,15 @@ class ValueDecl;
 class VarDecl;
 struct ASTNode;
 class Type;
+class NominalType;
 class Expr;
 class ConstructorDecl;
 class DestructorDecl;
 class AliasDecl;
+class MemberTable;
+class ConformanceTable;
+class VirtualTable;
+struct ConformanceEntry;
 class ArchetypeKind;
 class ASTPrinter;
 class ASTWalker;
@@ -79,9 +85,16 @@ enum PointerTypeKind : unsigned {
 
 // Introduces a name and associates it with a type such as:
 // int x where x is the declaration, int is the type.
-class alignas(1 << DeclAlignInBits) Decl : public ASTAllocation<Decl> {
+class alignas(1 << DeclAlignInBits) Decl
+    : public ASTAllocation<Decl, ASTAllocationKind::Decl> {
 
   DeclKind kind;
+
+  /// The next declaration in the list of declarations within this
+  /// member context. Kept next to the kind so that a compressed reference
+  /// fills its padding.
+  ASTRef<Decl> nextDecl;
+
   SrcLoc kindLoc;
 
   DeclName name;
@@ -149,7 +162,7 @@ protected:
                           IsTopLevelGlobal : 1);
 
     STONE_INLINE_BITFIELD(
-        FunctionDecl, ValueDecl, 1,
+        FunctionDecl, ValueDecl, 1 + 1,
         /// \see AbstractFunctionDecl::BodyKind
         // BodyKind : 3,
 
@@ -165,7 +178,10 @@ protected:
         /// Whether we are overridden later.
         // Overridden : 1,
 
-        IsMember : 1
+        IsMember : 1,
+
+        /// Whether calls dispatch through the virtual table.
+        IsVirtual : 1
 
         /// Whether this member's body consists of a single expression.
         // HasSingleExpressionBody : 1,
@@ -263,10 +279,6 @@ protected:
   // Storage for the declaration attributes.
   // DeclModifierList Modifiers;
 
-  /// The next declaration in the list of declarations within this
-  /// member context.
-  Decl *nextDecl = nullptr;
-
 public:
   Decl() = delete;
   Decl(const Decl &) = delete;
@@ -297,6 +309,10 @@ public:
 
 public:
   DeclKind GetKind() const { return kind; }
+
+  /// The next declaration in the same DeclContext.
+  Decl *GetNextDecl() const { return nextDecl.Get(this); }
+
   SrcLoc GetKindLoc() const { return kindLoc; }
   void SetKindLoc(SrcLoc loc) { kindLoc = loc; }
 
@@ -362,6 +378,9 @@ protected:
   template <typename DeclTy> friend class Redeclarable;
 
 public:
+  /// Walk this decl and, for functions, its body.
+  ///
+  /// \returns true if the walk was aborted.
   bool Walk(ASTWalker &walker);
 
 public:
@@ -381,7 +400,7 @@ public:
 class ValueDecl : public Decl {
 
   Type type;
-  VisibilityLevel visibilityKind;
+  VisibilityLevel visibilityKind = VisibilityLevel::None;
 
 public:
   ValueDecl(DeclKind kind, DeclName name, SrcLoc nameLoc, Type type,
@@ -527,6 +546,8 @@ class AliasDecl : public TemplateTypeDecl {
   TypeLoc underlyingTy;
 
 public:
+  TypeLoc &GetUnderlyingTypeLoc() { return underlyingTy; }
+  Type GetUnderlyingType() const { return underlyingTy.GetType(); }
 };
 
 class LabelDecl : public Decl {
@@ -553,14 +574,14 @@ class TypeParamDecl : public TypeDecl {};
 // This is really your function prototye
 // This should be TypeDecl
 class FunctionDecl : public TemplateContext,
-                     public ValueDecl
-/*, public Redeclarable<FunctionDecl>*/ {
+                     public ValueDecl,
+                     public Redeclarable<FunctionDecl> {
 
   // TypeLoc returnType;
 
   /// This enum member is active if GetBodyKind() is BodyKind::Parsed or
   /// BodyKind::TypeChecked.
-  BraceStmt *body;
+  BraceStmt *body = nullptr;
 
   StorageSpecKind storageSpecKind;
 
@@ -611,6 +632,10 @@ public:
 
   bool IsMember() { return Bits.FunctionDecl.IsMember; }
 
+  bool IsVirtual() const { return Bits.FunctionDecl.IsVirtual; }
+  /// Mark this function virtual, making the layout of its class stale.
+  void SetVirtual(bool isVirtual = true);
+
   // DeclNameLoc GetSpecialNameLoc() { return specialNameLoc; }
   //  void SetReturnType(TypeDecl* tyDecl);
 
@@ -712,30 +737,139 @@ public:
 };
 
 class NominalTypeDecl : public TemplateTypeDecl {
+  /// The table for qualified lookup into this type. It is only built on the
+  /// first lookup, so types that nobody looks into never pay for it.
+  MemberTable *memberTable = nullptr;
+
+  /// Bumped when the members change in a way the table cannot follow
+  /// incrementally. A table from an older generation is rebuilt.
+  unsigned memberGeneration = 0;
+
+  /// The joins whose members are also members of this type.
+  llvm::TinyPtrVector<DeclContext *> joins;
+
+  /// The interfaces named in the inheritance clauses of this type and its
+  /// joins, with the context that names each.
+  llvm::SmallVector<std::pair<InterfaceDecl *, DeclContext *>, 2>
+      inheritedInterfaces;
+
+  /// Every interface this type conforms to, built on the first query and
+  /// rebuilt when the conformance generation of the ASTContext moves on.
+  ConformanceTable *conformanceTable = nullptr;
+
+  /// The type this decl declares, created on first use.
+  NominalType *declaredType = nullptr;
+
+public:
+  /// \return the type this decl declares. There is one per decl.
+  NominalType *GetDeclaredType();
+
+  /// Add \p member to this type. Members declared in a join are chained in
+  /// the join and only registered here.
+  void AddMember(Decl *member);
+
+  /// Make the members of \p join members of this type.
+  void AddJoin(DeclContext *join);
+  llvm::ArrayRef<DeclContext *> GetJoins() const { return joins; }
+
+  /// Force the member table to be rebuilt on the next lookup.
+  void InvalidateMemberTable() { ++memberGeneration; }
+
+  /// \return the members of this type and its joins named \p name.
+  llvm::ArrayRef<ValueDecl *> LookupDirect(DeclNameBase name);
+
+  /// Record that \p declaredIn, this type or one of its joins, names
+  /// \p interface in its inheritance clause.
+  void AddInheritedInterface(InterfaceDecl *interface, DeclContext *declaredIn);
+
+  llvm::ArrayRef<std::pair<InterfaceDecl *, DeclContext *>>
+  GetInheritedInterfaces() const {
+    return inheritedInterfaces;
+  }
+
+  /// \return how this type conforms to \p interface, directly or through an
+  /// interface that inherits it, or null if it does not.
+  const ConformanceEntry *LookupConformance(InterfaceDecl *interface);
+
+private:
+  /// \return a member table that reflects the current members.
+  MemberTable &GetMemberTable();
+
+  /// \return a conformance table that reflects the current interfaces.
+  ConformanceTable &GetConformanceTable();
+
+protected:
+  NominalTypeDecl(DeclKind kind, Identifier name, SrcLoc nameLoc,
+                  DeclContext *parent)
+      : TemplateTypeDecl(kind, parent, name, nameLoc, Type()) {}
+
 public:
-  static bool classof(const Decl *d) { return true; }
+  static bool classof(const Decl *d) {
+    return d->GetKind() >= DeclKind::FirstNominalTypeDecl &&
+           d->GetKind() <= DeclKind::LastNominalTypeDecl;
+  }
 };
 
 class StructDecl final : public NominalTypeDecl {
+  StructDecl(Identifier name, SrcLoc nameLoc, DeclContext *parent)
+      : NominalTypeDecl(DeclKind::Struct, name, nameLoc, parent) {}
+
 public:
   static bool classof(const Decl *d) {
     return d->GetKind() == DeclKind::Struct;
   }
 
-public:
-  void AddMember(Decl *d);
-
 public:
   static StructDecl *Create(DeclName name, SrcLoc loc, ASTContext &astContext,
                             DeclContext *parent = nullptr);
 };
 
 class ClassDecl final : public NominalTypeDecl {
+  /// The class this one inherits from, or null for a root class.
+  ClassDecl *superclass = nullptr;
+
+  /// The virtual function layout, built on first use and rebuilt when it is
+  /// stale.
+  VirtualTable *virtualTable = nullptr;
+
+  /// Bumped when the superclass, the members or their virtuality change. A
+  /// layout from an older generation is rebuilt.
+  unsigned virtualGeneration = 0;
+
+  ClassDecl(Identifier name, SrcLoc nameLoc, DeclContext *parent)
+      : NominalTypeDecl(DeclKind::Class, name, nameLoc, parent) {}
+
+public:
+  ClassDecl *GetSuperclass() const { return superclass; }
+
+  /// Make \p inputSuperclass the class this one inherits from.
+  ///
+  /// \return false, leaving the superclass unchanged, if \p inputSuperclass
+  /// is this class or inherits from it. The caller diagnoses the cycle.
+  bool SetSuperclass(ClassDecl *inputSuperclass);
+
+  /// \return true if this class is \p other or inherits from it.
+  bool IsSubclassOf(const ClassDecl *other) const;
+
+  /// Force the virtual function layout to be rebuilt on the next use.
+  void InvalidateVirtualTable() { ++virtualGeneration; }
+
+  /// \return the virtual function layout, building it, and the layouts of
+  /// the superclasses, when it is missing or stale.
+  const VirtualTable &GetVirtualTable();
+
 public:
   static bool classof(const Decl *D) { return D->GetKind() == DeclKind::Class; }
+
+public:
+  static ClassDecl *Create(DeclName name, SrcLoc loc, ASTContext &astContext,
+                           DeclContext *parent = nullptr);
 };
 
 class InterfaceDecl final : public NominalTypeDecl {
+  InterfaceDecl(Identifier name, SrcLoc nameLoc, DeclContext *parent)
+      : NominalTypeDecl(DeclKind::Interface, name, nameLoc, parent) {}
+
 public:
   static bool classof(const Decl *d) {
     return d->GetKind() == DeclKind::Interface;
@@ -747,6 +881,9 @@ public:
 };
 
 class EnumDecl final : public NominalTypeDecl {
+  EnumDecl(Identifier name, SrcLoc nameLoc, DeclContext *parent)
+      : NominalTypeDecl(DeclKind::Enum, name, nameLoc, parent) {}
+
 public:
   static bool classof(const Decl *d) { return d->GetKind() == DeclKind::Enum; }
 
@@ -0,0 +1,144 @@
+#ifndef STONE_AST_DECLCHUNKLIST_H
+#define STONE_AST_DECLCHUNKLIST_H
+
+#include "stone/AST/ASTAllocation.h"
+#include "stone/AST/DeclKind.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Casting.h"
+
+#include <iterator>
+
+namespace stone {
+
+class ASTContext;
+class Decl;
+
+/// The members of a DeclContext, grouped by DeclKind. The decls of each kind
+/// are kept in source order in contiguous arena chunks, so a pass that only
+/// wants some kinds reads those chunks and never touches the other decls.
+class DeclChunkList final : public ASTAllocation<DeclChunkList> {
+public:
+  /// A run of decls of one kind. The decls follow the header in memory.
+  struct Chunk final {
+    Chunk *next = nullptr;
+    unsigned size = 0;
+    unsigned capacity;
+
+    explicit Chunk(unsigned capacity) : capacity(capacity) {}
+
+    Decl **GetDecls() { return reinterpret_cast<Decl **>(this + 1); }
+    Decl *const *GetDecls() const {
+      return reinterpret_cast<Decl *const *>(this + 1);
+    }
+  };
+
+  /// The chunks of one kind.
+  struct KindChunks final {
+    DeclKind kind;
+    Chunk *firstChunk;
+    Chunk *lastChunk;
+  };
+
+private:
+  /// Only the kinds that have members, sorted by kind. A context holds few
+  /// kinds, so this stays small where a slot per DeclKind would not.
+  llvm::SmallVector<KindChunks, 2> kinds;
+
+public:
+  /// Append \p decl to the decls of its kind.
+  void AddDecl(Decl *decl, ASTContext &astContext);
+
+  /// \return the chunks of the kinds in [\p first, \p last] that have
+  /// members, in kind order.
+  llvm::ArrayRef<KindChunks> GetKinds(DeclKind first, DeclKind last) const;
+
+  /// \return the first chunk of \p kind, or null if it has no members.
+  const Chunk *GetFirstChunk(DeclKind kind) const {
+    auto found = GetKinds(kind, kind);
+    return found.empty() ? nullptr : found.front().firstChunk;
+  }
+};
+
+/// The decls of a DeclChunkList whose kind is in [first, last], kind by kind
+/// and in source order within a kind.
+template <typename DeclTy = Decl> class DeclKindRange final {
+  const DeclChunkList *list;
+  DeclKind first;
+  DeclKind last;
+
+public:
+  class iterator final {
+    const DeclChunkList::KindChunks *nextKind = nullptr;
+    const DeclChunkList::KindChunks *endKind = nullptr;
+    const DeclChunkList::Chunk *chunk = nullptr;
+    unsigned index = 0;
+
+    /// Move to the next decl if the current position is past a chunk.
+    void Settle() {
+      while (true) {
+        if (chunk && index < chunk->size) {
+          return;
+        }
+        index = 0;
+        if (chunk && chunk->next) {
+          chunk = chunk->next;
+          continue;
+        }
+        if (nextKind == endKind) {
+          chunk = nullptr;
+          return;
+        }
+        chunk = (nextKind++)->firstChunk;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = DeclTy *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type;
+    using reference = value_type;
+
+    iterator() = default;
+    explicit iterator(llvm::ArrayRef<DeclChunkList::KindChunks> kinds)
+        : nextKind(kinds.begin()), endKind(kinds.end()) {
+      Settle();
+    }
+
+    DeclTy *operator*() const {
+      return llvm::cast<DeclTy>(chunk->GetDecls()[index]);
+    }
+    iterator &operator++() {
+      ++index;
+      Settle();
+      return *this;
+    }
+    iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+    bool operator==(const iterator &other) const {
+      return chunk == other.chunk && index == other.index;
+    }
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+  };
+
+public:
+  DeclKindRange(const DeclChunkList *list, DeclKind first, DeclKind last)
+      : list(list), first(first), last(last) {}
+
+  iterator begin() const {
+    if (!list) {
+      return iterator();
+    }
+    return iterator(list->GetKinds(first, last));
+  }
+  iterator end() const { return iterator(); }
+  bool empty() const { return begin() == end(); }
+};
+
+} // namespace stone
+#endif
@@ -3,6 +3,7 @@
 
 #include <type_traits>
 
+#include "stone/AST/DeclChunkList.h"
 #include "stone/AST/DeclKind.h"
 #include "stone/AST/Identifier.h"
 #include "stone/AST/Type.h"
@@ -26,10 +27,12 @@ namespace stone {
 class ASTContext;
 class CanType;
 class Decl;
+class AvailabilityContext;
 class DeclContext;
 class EnumDecl;
 class ExtensionDecl;
 class Expr;
+class FunctionDecl;
 class InterfaceDecl;
 class SourceFile;
 class Type;
@@ -99,6 +102,15 @@ protected:
   /// another pointer.
   mutable Decl *lastDecl = nullptr;
 
+  /// The availability inferred for this context, computed on first use.
+  mutable const AvailabilityContext *availability = nullptr;
+
+  /// The members again, grouped by kind. Created with the first member.
+  DeclChunkList *declChunks = nullptr;
+
+  /// Record \p decl in the kind-grouped members only.
+  void AddDeclToChunks(Decl *decl);
+
   /// Build up a chain of declarations.
   ///
   /// \returns the first/last pair of declarations.
@@ -159,6 +171,43 @@ public:
 
   bool IsTypeContext() const;
 
+  /// \return the type whose members are declared in this context: the type
+  /// itself or, for a join, the type it adds to. Null for other contexts.
+  NominalTypeDecl *GetSelfNominalTypeDecl() const;
+
+  /// Append \p decl to the declarations of this context.
+  void AddDecl(Decl *decl);
+
+  /// The first declaration in this context. The others follow it through
+  /// Decl::GetNextDecl.
+  Decl *GetFirstDecl() const { return firstDecl; }
+
+  /// The members of kind \p kind, in source order. Members of other kinds
+  /// are not touched.
+  DeclKindRange<> GetDecls(DeclKind kind) const {
+    return {declChunks, kind, kind};
+  }
+
+  /// The members whose kind is in [\p first, \p last], grouped by kind.
+  template <typename DeclTy = Decl>
+  DeclKindRange<DeclTy> GetDecls(DeclKind first, DeclKind last) const {
+    return {declChunks, first, last};
+  }
+
+  DeclKindRange<FunctionDecl> GetFunctionDecls() const {
+    return GetDecls<FunctionDecl>(DeclKind::FirstFunctionDecl,
+                                  DeclKind::LastFunctionDecl);
+  }
+  DeclKindRange<NominalTypeDecl> GetNominalTypeDecls() const {
+    return GetDecls<NominalTypeDecl>(DeclKind::FirstNominalTypeDecl,
+                                     DeclKind::LastNominalTypeDecl);
+  }
+
+  /// What code in this context may assume about its runtime: the deployment
+  /// target, narrowed by the annotated availability of each enclosing decl.
+  /// Computed once; a context that narrows nothing shares its parent's.
+  const AvailabilityContext &GetAvailabilityContext() const;
+
   /// If this DeclContext is an enum, or an extension on an enum, return the
   /// EnumDecl, otherwise return null.
   // EnumDecl *GetThisEnumDecl() const;
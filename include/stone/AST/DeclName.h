@@ -58,19 +58,23 @@ public:
   }
 };
 
-/// Represents a compound declaration name.
+/// Represents a compound declaration name, or a special name such as a
+/// constructor or an operator. Either is allocated by the DeclNameTable.
 struct alignas(Identifier) CompoundDeclName final
     : llvm::FoldingSetNode,
       private llvm::TrailingObjects<CompoundDeclName, Identifier> {
 
   friend TrailingObjects;
   friend class DeclName;
+  friend class DeclNameTable;
 
-  size_t NumArgs;
   DeclNameBase nameBase;
+  DeclNameKind kind;
+  size_t NumArgs;
 
-  explicit CompoundDeclName(DeclNameBase nameBase, size_t NumArgs)
-      : nameBase(nameBase), NumArgs(NumArgs) {}
+  explicit CompoundDeclName(DeclNameBase nameBase, DeclNameKind kind,
+                            size_t NumArgs)
+      : nameBase(nameBase), kind(kind), NumArgs(NumArgs) {}
 
   llvm::ArrayRef<Identifier> getArgumentNames() const {
     return {getTrailingObjects<Identifier>(), NumArgs};
@@ -81,36 +85,37 @@ struct alignas(Identifier) CompoundDeclName final
 
   /// Uniquing for the ASTContext.
   static void Profile(llvm::FoldingSetNodeID &id, DeclNameBase nameBase,
-                      ArrayRef<Identifier> argumentNames);
+                      DeclNameKind kind, ArrayRef<Identifier> argumentNames);
 
   void Profile(llvm::FoldingSetNodeID &id) {
-    Profile(id, nameBase, getArgumentNames());
+    Profile(id, nameBase, kind, getArgumentNames());
   }
 };
 
+/// A declaration name. A basic name is stored inline; compound and special
+/// names point into the DeclNameTable, which also records their kind. The
+/// kind is thus part of the opaque value, and a name survives a round trip
+/// through it.
 class DeclName {
-  friend class ASTContext;
-  DeclNameKind kind;
+  friend class DeclNameTable;
 
   /// Either a single identifier piece stored inline, or a reference to a
-  /// compound declaration name.
+  /// compound or special declaration name.
   llvm::PointerUnion<DeclNameBase, CompoundDeclName *> nameBaseOrCompound;
 
   explicit DeclName(void *opaquePtr)
       : nameBaseOrCompound(
             decltype(nameBaseOrCompound)::getFromOpaqueValue(opaquePtr)) {}
 
+  /// Only the DeclNameTable hands out compound and special names.
+  explicit DeclName(CompoundDeclName *compound)
+      : nameBaseOrCompound(compound) {}
+
 public:
   DeclName() : nameBaseOrCompound(DeclNameBase()) {}
 
   DeclName(Identifier basicName)
-      : DeclName(DeclNameKind::Basic, DeclNameBase(basicName)) {}
-
-  DeclName(CompoundDeclName *compound)
-      : kind(DeclNameKind::Compound), nameBaseOrCompound(compound) {}
-
-  DeclName(DeclNameKind kind, DeclNameBase basicName)
-      : kind(kind), nameBaseOrCompound(basicName) {}
+      : nameBaseOrCompound(DeclNameBase(basicName)) {}
 
   DeclNameBase GetDeclNameBase() const {
     if (auto compound = nameBaseOrCompound.dyn_cast<CompoundDeclName *>()) {
@@ -127,16 +132,46 @@ public:
     return declNameBase.GetIdentifier();
   }
 
-  DeclNameKind GetKind() const { return kind; }
+  DeclNameKind GetKind() const {
+    if (auto compound = nameBaseOrCompound.dyn_cast<CompoundDeclName *>()) {
+      return compound->kind;
+    }
+    return DeclNameKind::Basic;
+  }
   bool IsBasic() const { return GetKind() == DeclNameKind::Basic; }
-  bool IsSpecial() const { return GetKind() != DeclNameKind::Basic; }
+  bool IsSpecial() const {
+    auto kind = GetKind();
+    return kind != DeclNameKind::Basic && kind != DeclNameKind::Compound;
+  }
+  bool IsCompound() const { return GetKind() == DeclNameKind::Compound; }
+
+  /// The argument labels of a compound name; empty otherwise.
+  llvm::ArrayRef<Identifier> GetArgumentNames() const {
+    if (auto compound = nameBaseOrCompound.dyn_cast<CompoundDeclName *>()) {
+      return compound->getArgumentNames();
+    }
+    return {};
+  }
+
+  /// Compound and special names are uniqued by the DeclNameTable, so two
+  /// names are equal exactly when their pointers are.
+  bool operator==(DeclName other) const {
+    return nameBaseOrCompound == other.nameBaseOrCompound;
+  }
+  bool operator!=(DeclName other) const { return !(*this == other); }
+
+  void *GetOpaqueValue() const { return nameBaseOrCompound.getOpaqueValue(); }
+  static DeclName GetFromOpaqueValue(void *opaquePtr) {
+    return DeclName(opaquePtr);
+  }
 
   // public:
   void Print(ColorStream &os, const PrintingPolicy *policy = nullptr) const;
   void Dump() const;
 
 public:
-  int Compare(DeclName other);
+  /// Order names by base name text and then by argument labels.
+  int Compare(DeclName other) const;
 };
 
 // class DeclNameLoc final {
@@ -146,10 +181,34 @@ public:
 //   DeclNameLoc(DeclName name) : name(name) {}
 // };
 
-// Take a look at name look
+/// Uniques the compound and special names of an ASTContext. Each (base name,
+/// kind, argument labels) triple is allocated once, so DeclName can compare
+/// and hash these names as pointers.
 class DeclNameTable final {
+  const ASTContext &astContext;
+  llvm::FoldingSet<CompoundDeclName> compoundNames;
+
+public:
+  explicit DeclNameTable(const ASTContext &astContext)
+      : astContext(astContext) {}
+
+  DeclNameTable(const DeclNameTable &) = delete;
+  DeclNameTable &operator=(const DeclNameTable &) = delete;
+
 public:
-  DeclNameTable() {}
+  /// \return the compound name with \p nameBase and \p argumentNames.
+  DeclName GetCompoundName(DeclNameBase nameBase,
+                           llvm::ArrayRef<Identifier> argumentNames);
+
+  /// \return the special name of kind \p kind, such as an operator, with
+  /// \p nameBase.
+  DeclName GetSpecialName(DeclNameKind kind, DeclNameBase nameBase);
+
+  size_t GetNumCompoundNames() const { return compoundNames.size(); }
+
+private:
+  DeclName GetName(DeclNameBase nameBase, DeclNameKind kind,
+                   llvm::ArrayRef<Identifier> argumentNames);
 };
 
 } // namespace stone
@@ -176,6 +235,24 @@ template <> struct DenseMapInfo<stone::DeclNameBase> {
   }
 };
 
+// DeclNames hash just like pointers.
+template <> struct DenseMapInfo<stone::DeclName> {
+  static stone::DeclName getEmptyKey() {
+    return stone::DeclName::GetFromOpaqueValue(
+        DenseMapInfo<void *>::getEmptyKey());
+  }
+  static stone::DeclName getTombstoneKey() {
+    return stone::DeclName::GetFromOpaqueValue(
+        DenseMapInfo<void *>::getTombstoneKey());
+  }
+  static unsigned getHashValue(stone::DeclName Val) {
+    return DenseMapInfo<void *>::getHashValue(Val.GetOpaqueValue());
+  }
+  static bool isEqual(stone::DeclName LHS, stone::DeclName RHS) {
+    return LHS == RHS;
+  }
+};
+
 // A DeclBaseName is "pointer like".
 template <typename T> struct PointerLikeTypeTraits;
 template <> struct PointerLikeTypeTraits<stone::DeclNameBase> {
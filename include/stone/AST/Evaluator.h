@@ -0,0 +1,182 @@
+#ifndef STONE_AST_EVALUATOR_H
+#define STONE_AST_EVALUATOR_H
+
+#include "stone/Basic/Basic.h"
+#include "stone/Basic/SrcLoc.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace stone {
+
+class ASTContext;
+class Evaluator;
+
+enum class RequestKind : uint8 {
+#define REQUEST(ID) ID,
+#define LAST_REQUEST(ID) Last_Request = ID,
+#include "stone/AST/RequestKind.def"
+};
+
+llvm::StringRef GetRequestKindName(RequestKind kind);
+
+/// A request about one AST node. A request class derives from this and adds
+///
+///   static constexpr RequestKind kind;
+///   OutputType Evaluate(Evaluator &evaluator) const;
+///
+/// Requests are asked through Evaluator::operator(), never evaluated
+/// directly, so that each is answered once and cycles are caught.
+template <typename Derived, typename Output, typename Subject>
+class SimpleRequest {
+  Subject *subject;
+
+public:
+  using OutputType = Output;
+
+  explicit SimpleRequest(Subject *subject) : subject(subject) {}
+
+public:
+  Subject *GetSubject() const { return subject; }
+
+  /// Where a cycle through this request is diagnosed.
+  SrcLoc GetLoc() const { return subject->GetNameLoc(); }
+
+  /// The answer given to a request that depends on itself.
+  Output GetCycleResult() const { return Output(); }
+};
+
+/// Answers requests on demand and remembers each answer, so semantic work is
+/// only done for what is asked about and only once.
+///
+/// While a request is evaluated, every request it asks is recorded as its
+/// dependency. A request that asks itself, directly or not, is diagnosed as
+/// a cycle and gets its cycle result instead.
+class Evaluator final {
+public:
+  /// Identifies one request: its kind and its subject.
+  using RequestKey = std::pair<unsigned, const void *>;
+
+  /// What was done for the requests of one kind.
+  struct RequestCounters final {
+    unsigned evaluations = 0;
+    unsigned cacheHits = 0;
+    /// Time spent evaluating, including the requests asked on the way.
+    uint64_t nanos = 0;
+  };
+
+private:
+  static constexpr unsigned NumRequestKinds =
+      static_cast<unsigned>(RequestKind::Last_Request) + 1;
+
+  struct RequestCacheBase {
+    virtual ~RequestCacheBase() = default;
+  };
+  template <typename Request> struct RequestCache final : RequestCacheBase {
+    llvm::DenseMap<const void *, typename Request::OutputType> results;
+  };
+
+  struct ActiveRequest final {
+    RequestKey key;
+    SrcLoc loc;
+  };
+
+  ASTContext &astContext;
+
+  /// The answers, one cache per request kind, created on first use.
+  std::unique_ptr<RequestCacheBase> caches[NumRequestKinds];
+
+  /// The requests being evaluated, outermost first.
+  llvm::SmallVector<ActiveRequest, 8> activeRequests;
+  llvm::DenseSet<RequestKey> activeKeys;
+
+  /// The requests each evaluated request asked.
+  llvm::DenseMap<RequestKey, llvm::SmallVector<RequestKey, 2>> dependencies;
+
+  RequestCounters counters[NumRequestKinds];
+
+public:
+  explicit Evaluator(ASTContext &astContext) : astContext(astContext) {}
+  Evaluator(const Evaluator &) = delete;
+  Evaluator &operator=(const Evaluator &) = delete;
+
+public:
+  /// \return the answer to \p request, evaluating it the first time.
+  template <typename Request>
+  typename Request::OutputType operator()(const Request &request) {
+    RequestKey key(static_cast<unsigned>(Request::kind), request.GetSubject());
+    RecordDependency(key);
+
+    auto &results = GetCache<Request>().results;
+    auto found = results.find(key.second);
+    if (found != results.end()) {
+      NoteCacheHit(key);
+      return found->second;
+    }
+    if (!BeginRequest(key, request.GetLoc())) {
+      return request.GetCycleResult();
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto result = request.Evaluate(*this);
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    EndRequest(key, nanos);
+    results[key.second] = result;
+    return result;
+  }
+
+  /// Forget the answer to \p request, so the next ask evaluates it again.
+  template <typename Request> void ClearCachedResult(const Request &request) {
+    GetCache<Request>().results.erase(request.GetSubject());
+  }
+
+  /// The requests that \p request asked when it was evaluated.
+  template <typename Request>
+  llvm::ArrayRef<RequestKey> GetDependencies(const Request &request) const {
+    auto found = dependencies.find(
+        RequestKey(static_cast<unsigned>(Request::kind), request.GetSubject()));
+    if (found == dependencies.end()) {
+      return {};
+    }
+    return found->second;
+  }
+
+  const RequestCounters &GetCounters(RequestKind kind) const {
+    return counters[static_cast<unsigned>(kind)];
+  }
+
+  /// Print the counters of every request kind that was asked.
+  void PrintCounters(llvm::raw_ostream &os) const;
+
+private:
+  template <typename Request> RequestCache<Request> &GetCache() {
+    auto &cache = caches[static_cast<unsigned>(Request::kind)];
+    if (!cache) {
+      cache = std::make_unique<RequestCache<Request>>();
+    }
+    return static_cast<RequestCache<Request> &>(*cache);
+  }
+
+  void RecordDependency(RequestKey key);
+  void NoteCacheHit(RequestKey key);
+
+  /// \return false after diagnosing a cycle if \p key is already active.
+  bool BeginRequest(RequestKey key, SrcLoc loc);
+  void EndRequest(RequestKey key, uint64_t nanos);
+};
+
+} // namespace stone
+#endif
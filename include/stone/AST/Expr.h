@@ -9,6 +9,7 @@
 #include <type_traits>
 #include <utility>
 
+#include "stone/AST/ASTAllocation.h"
 #include "stone/AST/ASTWalker.h"
 #include "stone/AST/Stmt.h"
 
@@ -23,6 +24,7 @@
 
 namespace stone {
 
+class ASTContext;
 class ASTWalker;
 
 class Expr : public ValueStmt {
@@ -36,6 +38,20 @@ public:
 public:
   Expr(StmtKind kind) : ValueStmt(kind) {}
 
+  // Exprs are allocated like the Stmts they derive from, but their memory is
+  // counted as ASTAllocationKind::Expr.
+  void *
+  operator new(size_t bytes, const ASTContext &astContext,
+               MemoryAllocationArena arena = MemoryAllocationArena::Stoneanent,
+               unsigned alignment = alignof(Expr)) {
+    return stone::AllocateInASTContext(bytes, astContext, arena, alignment,
+                                       ASTAllocationKind::Expr);
+  }
+  void *operator new(size_t bytes, void *mem) throw() {
+    assert(mem && "placement new into failed allocation");
+    return mem;
+  }
+
   // StmtKind kind, Type qualTy, ExprValueKind VK, ExprObjectKind OK
 
   /// This recursively walks the AST rooted at this expression.
@@ -3,9 +3,15 @@
 
 // #include "stone/Basic/Located.h"
 
+#include "stone/AST/Identifier.h"
 #include "stone/Basic/Basic.h"
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/Hashing.h"
+
 namespace stone {
+class ModuleDecl;
 
 // TODO: You may not need this part
 enum class ImportKind : uint8 {
@@ -25,6 +31,30 @@ enum class ImportKind : uint8 {
   Fun,
 };
 
+/// The path of a scoped import inside the imported module, such as
+/// OutputStream in "import type Core.IO.OutputStream". An empty path imports
+/// the whole module.
+using ImportPath = llvm::ArrayRef<Identifier>;
+
+/// A module together with the path it is imported through.
+struct ImportedModule final {
+  ImportPath accessPath;
+  ModuleDecl *importedModule;
+
+  ImportedModule(ModuleDecl *importedModule, ImportPath accessPath = {})
+      : accessPath(accessPath), importedModule(importedModule) {}
+
+  bool IsScoped() const { return !accessPath.empty(); }
+
+  bool operator==(const ImportedModule &other) const {
+    return importedModule == other.importedModule &&
+           accessPath == other.accessPath;
+  }
+  bool operator!=(const ImportedModule &other) const {
+    return !(*this == other);
+  }
+};
+
 class ImportSearchPathBase {
 public:
 };
@@ -35,4 +65,27 @@ public:
 
 } // namespace stone
 
+namespace llvm {
+template <> struct DenseMapInfo<stone::ImportedModule> {
+  using ModuleInfo = DenseMapInfo<stone::ModuleDecl *>;
+
+  static inline stone::ImportedModule getEmptyKey() {
+    return stone::ImportedModule(ModuleInfo::getEmptyKey());
+  }
+  static inline stone::ImportedModule getTombstoneKey() {
+    return stone::ImportedModule(ModuleInfo::getTombstoneKey());
+  }
+  static unsigned getHashValue(const stone::ImportedModule &import) {
+    return llvm::hash_combine(
+        ModuleInfo::getHashValue(import.importedModule),
+        llvm::hash_combine_range(import.accessPath.begin(),
+                                 import.accessPath.end()));
+  }
+  static bool isEqual(const stone::ImportedModule &lhs,
+                      const stone::ImportedModule &rhs) {
+    return lhs == rhs;
+  }
+};
+} // namespace llvm
+
 #endif
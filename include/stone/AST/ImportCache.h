@@ -1,10 +1,102 @@
 #ifndef STONE_AST_IMPORTCACHE_H
 #define STONE_AST_IMPORTCACHE_H
 
+#include "stone/AST/Import.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/TrailingObjects.h"
+
 namespace stone {
+class ASTContext;
+class Decl;
+class ModuleDecl;
+
+/// The modules visible through a list of imports: the imports themselves,
+/// followed by every module they import in turn, each listed once. Sets are
+/// uniqued by their top-level imports and allocated in the ASTContext, so
+/// two files with the same imports share one set.
+class ImportSet final : public llvm::FoldingSetNode,
+                        private llvm::TrailingObjects<ImportSet, ImportedModule> {
+  friend TrailingObjects;
+  friend class ImportCache;
+
+  unsigned numTopLevelImports;
+  unsigned numTransitiveImports;
+
+  ImportSet(llvm::ArrayRef<ImportedModule> topLevelImports,
+            llvm::ArrayRef<ImportedModule> transitiveImports);
+
+public:
+  ImportSet(const ImportSet &) = delete;
+  ImportSet &operator=(const ImportSet &) = delete;
 
-class ImportCache {
 public:
+  llvm::ArrayRef<ImportedModule> GetTopLevelImports() const {
+    return {getTrailingObjects<ImportedModule>(), numTopLevelImports};
+  }
+  llvm::ArrayRef<ImportedModule> GetTransitiveImports() const {
+    return {getTrailingObjects<ImportedModule>() + numTopLevelImports,
+            numTransitiveImports};
+  }
+  llvm::ArrayRef<ImportedModule> GetAllImports() const {
+    return {getTrailingObjects<ImportedModule>(),
+            numTopLevelImports + numTransitiveImports};
+  }
+
+  /// \return true if \p module is in the set, through any path.
+  bool Contains(const ModuleDecl *module) const;
+
+  void Profile(llvm::FoldingSetNodeID &id) const {
+    Profile(id, GetTopLevelImports());
+  }
+  static void Profile(llvm::FoldingSetNodeID &id,
+                      llvm::ArrayRef<ImportedModule> topLevelImports);
+};
+
+/// Memoizes the transitive closure of the import graph, so that visibility
+/// checks during name lookup scan an array instead of walking the graph.
+/// Adding an import to any module drops every memoized set, since the
+/// closure of each module that reaches it changes too.
+class ImportCache final {
+  llvm::FoldingSet<ImportSet> importSets;
+
+  /// The set for each single import, keyed by (module, import path).
+  llvm::DenseMap<ImportedModule, ImportSet *> importSetForImport;
+
+  /// The set for the imports of each module.
+  llvm::DenseMap<const ModuleDecl *, ImportSet *> importSetForModule;
+
+public:
+  ImportCache() = default;
+
+  ImportCache(const ImportCache &) = delete;
+  ImportCache &operator=(const ImportCache &) = delete;
+
+public:
+  /// \return the uniqued set for \p topLevelImports.
+  ImportSet &GetImportSet(const ASTContext &astContext,
+                          llvm::ArrayRef<ImportedModule> topLevelImports);
+
+  /// \return the modules visible through \p import.
+  ImportSet &GetImportSet(const ASTContext &astContext,
+                          ImportedModule import);
+
+  /// \return the modules visible through the imports of \p module.
+  ImportSet &GetImportSet(const ModuleDecl *module);
+
+  /// Forget every set. Called when the import graph changes.
+  void InvalidateImportSets();
+
+  /// \return true if \p importer can see \p imported, either itself or
+  /// through its imports.
+  bool IsImportedBy(const ModuleDecl *imported, const ModuleDecl *importer);
+
+  /// \return true if \p decl is reachable from \p importer: it is declared in
+  /// a module that \p importer imports as a whole, or through a scoped import
+  /// that names it.
+  bool IsVisible(Decl *decl, const ModuleDecl *importer);
 };
 
 } // namespace stone
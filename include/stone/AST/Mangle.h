@@ -2,11 +2,11 @@
 #define STONE_AST_MANGLE_H
 
 #include "stone/AST/Decl.h"
-#include "stone/AST/Global.h"
 #include "stone/AST/LangABI.h"
 #include "stone/AST/Type.h"
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Casting.h"
 
 namespace llvm {
@@ -20,6 +20,7 @@ class ConstructorDecl;
 class DestructorDecl;
 class FunctionDecl;
 class NamedDecl;
+class ValueDecl;
 class VarDecl;
 
 enum class MangleContextKind : uint8 { None = 0, Itanium, Microsoft };
@@ -29,25 +30,37 @@ class MangleContext {
   const MangleContextKind kind;
 
 public:
-  MangleContext(MangleContextKind kind, ASTContext &sc) : kind(kind), sc(sc) {}
+  MangleContext(MangleContextKind kind, ASTContext &sc) : sc(sc), kind(kind) {}
+  virtual ~MangleContext() = default;
 
 public:
+  /// Append the symbol name of \p decl to \p out.
+  virtual void MangleName(ValueDecl *decl,
+                          llvm::SmallVectorImpl<char> &out) = 0;
+
   /// Generates a unique string for an externally visible type for use with TBAA
   /// or type uniquing.
   /// TODO: Extend this to internal types by generating names that are unique
   /// across translation units so it can be used with LTO.
-  // virtual void MangleTypeName(Type T, llvm::raw_ostream & os) = 0;
+  virtual void MangleTypeName(Type T, llvm::SmallVectorImpl<char> &out) = 0;
 
 public:
   ASTContext &GetASTContext() { return sc; }
   MangleContextKind GetKind() { return kind; }
 };
 
+/// Mangles names with the Itanium C++ ABI scheme. Modules, spaces and types
+/// are the components of nested names, and repeated components and types are
+/// replaced by back references into a per-name substitution table.
 class ItaniumMangleContext : public MangleContext {
 
 public:
   ItaniumMangleContext(ASTContext &sc)
       : MangleContext(MangleContextKind::Itanium, sc) {}
+
+public:
+  void MangleName(ValueDecl *decl, llvm::SmallVectorImpl<char> &out) override;
+  void MangleTypeName(Type T, llvm::SmallVectorImpl<char> &out) override;
 };
 
 class MicrosoftMangleContext : public MangleContext {
@@ -1,7 +1,8 @@
 #ifndef STONE_AST_MEMBERTABLE_H
 #define STONE_AST_MEMBERTABLE_H
 
-#include "stone/Foreign/DeclName.h"
+#include "stone/AST/ASTAllocation.h"
+#include "stone/AST/DeclName.h"
 
 // #include "stone/Foreign/ClangImporter.h"
 // #include "stone/AST/NameLookup.h"
@@ -19,6 +20,7 @@
 // #include "stone/Basic/Statistic.h"
 // #include "stone/Basic/STLExtras.h"
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Debug.h"
@@ -34,23 +36,50 @@
 
 namespace stone {
 
-class MemberTable final {
+class Decl;
+class ValueDecl;
 
-  using Entries = llvm::DenseMap<DeclName, llvm::TinyPtrVector<ValueDecl *>>;
+/// A hashed table of the members of a nominal type, keyed by base name.
+/// NominalTypeDecl builds it on the first qualified lookup into the type and
+/// keeps it up to date as members are added.
+class MemberTable final : public ASTAllocation<MemberTable> {
+
+  using Entries =
+      llvm::DenseMap<DeclNameBase, llvm::TinyPtrVector<ValueDecl *>>;
   Entries entries;
 
+  /// The member generation of the type when the table was last built.
+  unsigned generation;
+
 public:
-  MemberTable(const Expr &) = delete;
+  MemberTable(const MemberTable &) = delete;
   MemberTable(MemberTable &&) = delete;
 
   MemberTable &operator=(const MemberTable &) = delete;
   MemberTable &operator=(MemberTable &&) = delete;
 
 public:
-  MemberTable() {}
+  explicit MemberTable(unsigned generation) : generation(generation) {}
 
 public:
+  unsigned GetGeneration() const { return generation; }
+
+  /// Drop every entry so that the table can be rebuilt for \p generation.
+  void Reset(unsigned newGeneration) {
+    entries.clear();
+    generation = newGeneration;
+  }
+
+  /// Add \p member if it is a named value declaration.
   void AddMember(Decl *member);
+
+  /// Add \p member and every declaration chained after it.
+  void AddMembers(Decl *firstMember);
+
+  /// \return the members named \p name, in the order they were added.
+  llvm::ArrayRef<ValueDecl *> Find(DeclNameBase name) const;
+
+  size_t GetNumNames() const { return entries.size(); }
 };
 
 } // namespace stone
@@ -7,11 +7,13 @@
 #include "stone/AST/ASTWalker.h"
 #include "stone/AST/Decl.h"
 #include "stone/AST/Identifier.h"
+#include "stone/AST/Import.h"
 #include "stone/Basic/Basic.h"
 #include "stone/Basic/LLVM.h"
 #include "stone/Basic/List.h"
 #include "stone/Basic/OptionSet.h"
 #include "stone/Basic/Status.h"
+#include "stone/Basic/TokenKind.h"
 
 #include "llvm/ADT/SmallVector.h"
 
@@ -20,6 +22,7 @@ namespace stone {
 class ModuleDecl;
 class SourceFile;
 class ModuleFile;
+class SyntaxTree;
 
 static inline unsigned AlignOfModuleFile();
 
@@ -52,7 +55,7 @@ public:
   ModuleOutputMode moduleOutputMode = ModuleOutputMode::None;
 };
 
-enum class ModuleFileKind : uint8_t { Syntax, Builtin };
+enum class ModuleFileKind : uint8_t { Syntax, Builtin, Serialized };
 
 class ModuleFile : public DeclContext, public ASTAllocation<ModuleFile> {
 private:
@@ -94,6 +97,16 @@ enum class SourceFileKind : uint8_t {
 
 // };
 
+/// A token recorded while parsing a source file. Only the kind and the byte
+/// range are kept so that clients such as syntax coloring and indexing can
+/// walk the token stream in bulk without re-lexing.
+struct ParsedToken final {
+  tok kind;
+  /// The byte offset of the token in its buffer.
+  uint32_t offset;
+  uint32_t length;
+};
+
 // class SourceFileDecl
 class SourceFile final : public ModuleFile {
 public:
@@ -175,6 +188,25 @@ public:
 
   std::vector<Decl *> topLevelDecls;
 
+private:
+  /// The latest top-level function declared under each name.
+  llvm::DenseMap<DeclName, FunctionDecl *> latestFunctionDecls;
+
+  /// The options this file was created with.
+  ParsingOptions parsingOpts;
+
+  /// The tokens consumed by the parser, present only when the file is parsed
+  /// with ParsingFlags::CollectParsedTokens.
+  std::optional<std::vector<ParsedToken>> parsedTokens;
+
+  /// The lossless syntax tree, present only when the file is parsed with
+  /// ParsingFlags::BuildSyntaxTree.
+  SyntaxTree *syntaxTree = nullptr;
+
+  /// The byte ranges of the '#if' clauses that were skipped by the lexer
+  /// because their condition evaluated to false, in source order.
+  std::vector<CharSrcRange> inactiveIfConfigRanges;
+
 public:
   SourceFile(SourceFileKind kind, ModuleDecl &owner,
              std::optional<unsigned> srcID, bool isPrimary = false);
@@ -188,11 +220,10 @@ public:
   bool HasMainFun() { return hasMainFun; }
   void SetHasMainFun(bool status = false) { status = hasMainFun; }
 
-  void AddTopLevelDecl(Decl *d) {
-    // Force decl parsing if we haven't already.
-    //(void)GetTopLevelDecls();
-    topLevelDecls.push_back(d);
-  }
+  /// Append \p d to the top-level decls. A function that was declared
+  /// before in this file, such as through a forward declaration, becomes
+  /// the latest redeclaration of the earlier one.
+  void AddTopLevelDecl(Decl *d);
 
   /// Retrieves an immutable view of the list of top-level decls in this file.
   llvm::ArrayRef<Decl *> GetTopLevelDecls() const;
@@ -219,6 +250,41 @@ public:
   bool HasParsed() { return stages.contains(SourceFile::Flags::Parsed); }
   void ClearParsedState();
 
+  ParsingOptions GetParsingOptions() const { return parsingOpts; }
+  void SetParsingOptions(ParsingOptions opts);
+
+  /// Whether the parser records the tokens it consumes into this file.
+  bool IsCollectingParsedTokens() const { return parsedTokens.has_value(); }
+
+  /// The storage the parser appends tokens to, or \c nullptr if tokens are
+  /// not being collected.
+  std::vector<ParsedToken> *GetParsedTokenStorage() {
+    return parsedTokens ? &*parsedTokens : nullptr;
+  }
+
+  /// Retrieves the tokens collected while parsing, in source order.
+  llvm::ArrayRef<ParsedToken> GetParsedTokens() const {
+    if (!parsedTokens) {
+      return {};
+    }
+    return *parsedTokens;
+  }
+
+  /// Whether the lexer should evaluate '#if' conditions for this file.
+  bool ShouldEvaluatePoundIf() const {
+    return !parsingOpts.contains(ParsingFlags::DisablePoundIfEvaluation);
+  }
+
+  SyntaxTree *GetSyntaxTree() const { return syntaxTree; }
+  void SetSyntaxTree(SyntaxTree *tree) { syntaxTree = tree; }
+
+  void AddInactiveIfConfigRange(CharSrcRange range) {
+    inactiveIfConfigRanges.push_back(range);
+  }
+  llvm::ArrayRef<CharSrcRange> GetInactiveIfConfigRanges() const {
+    return inactiveIfConfigRanges;
+  }
+
   void SetTypeCheckedStage() { stages |= SourceFile::Flags::Parsed; }
   bool HasTypeChecked() {
     return stages.contains(SourceFile::Flags::TypeChecked);
@@ -255,6 +321,9 @@ class ModuleDecl final : public DeclContext,
   /// The ABI name of the module, if it differs from the module name.
   mutable Identifier moduleABIName;
 
+  /// The modules imported by the files of this module.
+  llvm::SmallVector<ImportedModule, 4> imports;
+
 public:
   ModuleDecl(Identifier name, ASTContext &tc, ModuleDecl *parent = nullptr);
 
@@ -270,9 +339,20 @@ public:
     return {files.begin(), files.size()};
   }
   void AddFile(ModuleFile &file);
+
+  /// Record an import made by one of the files of this module. The access
+  /// path is copied into the ASTContext.
+  void AddImport(ImportedModule import);
+  llvm::ArrayRef<ImportedModule> GetImports() const { return imports; }
+
   SourceFile &GetMainSourceFile() const;
   ModuleFile &GetMainFile(ModuleFileKind kind) const;
 
+  /// Add the top-level value decls named \p name to \p results. Decls of
+  /// serialized files are only materialized here.
+  void LookupValue(DeclNameBase name,
+                   llvm::SmallVectorImpl<ValueDecl *> &results);
+
   /// For the main module, retrieves the list of primary source files being
   /// compiled, that is, the files we're generating code for.
   llvm::ArrayRef<SourceFile *> GetPrimarySourceFiles();
@@ -284,7 +364,10 @@ public:
   /// \returns true if this module is the "builtin" module.
   bool IsBuiltin() const;
 
-  bool Walk(ASTWalker &waker);
+  /// Walk the top-level decls of the source files of this module.
+  ///
+  /// \returns true if the walk was aborted.
+  bool Walk(ASTWalker &walker);
 
   /// Retrieve the ABI name of the module, which is used for metadata and
   /// mangling.
@@ -0,0 +1,85 @@
+#ifndef STONE_AST_MODULEFORMAT_H
+#define STONE_AST_MODULEFORMAT_H
+
+#include "llvm/Support/Endian.h"
+
+#include <cstdint>
+
+namespace stone {
+namespace serialization {
+
+/// The layout of a serialized module file. Every integer is little endian
+/// and every table is 4-byte aligned, so that a reader can use the file in
+/// place after mapping it:
+///
+///   ModuleFileHeader
+///   IdentifierEntry[numIdentifiers]
+///   Offset[numTypes]          offsets of the type records
+///   Offset[numDecls]          offsets of the decl records
+///   NameIndexEntry[numNameIndexEntries], sorted by name text
+///   type and decl records
+///   identifier text
+///
+/// Identifiers, types and decls are named by 1-based IDs; 0 stands for none.
+using Offset = llvm::support::ulittle32_t;
+using IdentifierID = uint32_t;
+using TypeID = uint32_t;
+using DeclID = uint32_t;
+
+constexpr char ModuleSignature[4] = {'S', 'T', 'M', 'D'};
+
+/// Bumped when a change makes older files unreadable.
+constexpr uint16_t ModuleVersionMajor = 1;
+/// Bumped for compatible additions.
+constexpr uint16_t ModuleVersionMinor = 0;
+
+struct ModuleFileHeader final {
+  char signature[4];
+  llvm::support::ulittle16_t versionMajor;
+  llvm::support::ulittle16_t versionMinor;
+  llvm::support::ulittle32_t moduleNameID;
+  Offset identifiersOffset;
+  llvm::support::ulittle32_t numIdentifiers;
+  Offset typesOffset;
+  llvm::support::ulittle32_t numTypes;
+  Offset declsOffset;
+  llvm::support::ulittle32_t numDecls;
+  Offset nameIndexOffset;
+  llvm::support::ulittle32_t numNameIndexEntries;
+};
+
+struct IdentifierEntry final {
+  Offset textOffset;
+  llvm::support::ulittle32_t length;
+};
+
+/// Maps a name to one of the decls that have it.
+struct NameIndexEntry final {
+  llvm::support::ulittle32_t nameID;
+  llvm::support::ulittle32_t declID;
+};
+
+/// The first word of a type record: the code in the low byte, the TypeKind
+/// in the next one. The operands follow as 32-bit words:
+///   Builtin    -
+///   Fun        result TypeID, parameter count, parameter TypeIDs
+///   Pointer    pointee TypeID (Raw, Move and Ref)
+///   Qualified  base TypeID, qualifier bits
+enum class TypeCode : uint8_t {
+  Builtin = 0,
+  Fun,
+  Pointer,
+  Qualified,
+};
+
+/// The first word of a decl record: the code in the low byte, the
+/// visibility level in the next one. The name IdentifierID and the TypeID
+/// follow.
+enum class DeclCode : uint8_t {
+  Fun = 0,
+};
+
+} // namespace serialization
+} // namespace stone
+
+#endif
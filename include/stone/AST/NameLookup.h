@@ -1,14 +1,56 @@
 #ifndef STONE_AST_NAMELOOKUP_H
 #define STONE_AST_NAMELOOKUP_H
 
+#include "stone/AST/DeclName.h"
+#include "stone/Basic/SrcLoc.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/TinyPtrVector.h"
+
+#include <utility>
+
 namespace stone {
+class ASTContext;
+class ASTScope;
+class ValueDecl;
 
 /// This is a specifier for the kind of name lookup being performed
 /// by various query methods.
 enum class NameLookupKind { None = 0, Unqualified, Qualified };
 
+/// Unqualified lookup over an ASTScope tree. The result of looking up a name
+/// from a scope is the set of decls of the innermost enclosing scope that
+/// declares it; it is memoized by (scope, name) together with the lookup
+/// generation of the scope, so adding or removing a decl anywhere on the
+/// path to the root invalidates the result.
 class NameLookup final {
+  ASTContext &astContext;
+
+  using CacheKey = std::pair<const ASTScope *, DeclNameBase>;
+  struct CacheEntry final {
+    unsigned generation;
+    llvm::TinyPtrVector<ValueDecl *> results;
+  };
+  llvm::DenseMap<CacheKey, CacheEntry> cache;
+
 public:
+  explicit NameLookup(ASTContext &astContext) : astContext(astContext) {}
+
+  NameLookup(const NameLookup &) = delete;
+  NameLookup &operator=(const NameLookup &) = delete;
+
+public:
+  /// Look up \p name at \p loc, starting from the innermost scope of
+  /// \p rootScope that contains it.
+  llvm::TinyPtrVector<ValueDecl *>
+  LookupUnqualified(DeclNameBase name, SrcLoc loc, ASTScope &rootScope);
+
+  /// Look up \p name in \p scope and then in its parents.
+  llvm::TinyPtrVector<ValueDecl *> LookupUnqualified(DeclNameBase name,
+                                                     ASTScope *scope);
+
+  /// Forget every memoized result.
+  void ClearCache() { cache.clear(); }
 };
 
 } // namespace stone
@@ -0,0 +1,87 @@
+#ifndef STONE_AST_PARALLELASTWALKER_H
+#define STONE_AST_PARALLELASTWALKER_H
+
+#include "stone/AST/ASTWalker.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <memory>
+
+namespace stone {
+class Decl;
+class DeclContext;
+class ModuleDecl;
+
+/// Walks the decls of a module on the LLVM thread pool, for analyses that
+/// only read the AST (indexing, verification, metrics).
+///
+/// The work items are the top-level decls and, for every nominal type, the
+/// functions and nested types declared in it and its joins. A type is walked
+/// without its members, which are walked as items of their own, so every
+/// function body is visited exactly once.
+///
+/// The items are split into chunks of a fixed size in source order, and
+/// idle workers take the next chunk, so one large function does not hold
+/// up the others. Every chunk gets its own walker. Walkers need no locks, and
+/// because chunks do not depend on the thread count, reducing the walkers in
+/// chunk order gives the same answer on any machine.
+///
+/// Nothing in the AST is locked: walkers must not create types, decls or
+/// identifiers, or otherwise allocate in the ASTContext. Queries that fill a
+/// cache on first use write too, so walkers must not ask them either:
+///  - Type::GetCanType and Type::IsEqual;
+///  - DeclContext::GetAvailabilityContext;
+///  - VisibilityCache::GetEffectiveVisibility;
+///  - ASTContext::GetMangledName;
+///  - NominalTypeDecl::LookupDirect and LookupConformance,
+///    ASTContext::ConformsTo and ClassDecl::GetVirtualTable;
+///  - any request of the Evaluator.
+class ParallelASTWalk final {
+  llvm::SmallVector<Decl *, 0> decls;
+  unsigned chunkSize;
+
+public:
+  static constexpr unsigned DefaultChunkSize = 8;
+
+  explicit ParallelASTWalk(ModuleDecl &module,
+                           unsigned chunkSize = DefaultChunkSize);
+
+public:
+  unsigned GetNumDecls() const { return decls.size(); }
+  unsigned GetNumChunks() const;
+  llvm::ArrayRef<Decl *> GetChunk(unsigned index) const;
+
+  /// Walk every chunk with the walker \p getWalker returns for it. Chunks
+  /// run concurrently, so \p getWalker must not return the same walker for
+  /// two chunks.
+  ///
+  /// \returns true if a walker aborted. Chunks that have not started by
+  /// then are skipped.
+  bool Run(llvm::function_ref<ASTWalker &(unsigned chunk)> getWalker);
+
+private:
+  /// Add \p decl and, if it is a type, its members.
+  void AddDecl(Decl *decl);
+  void AddMembers(DeclContext *dc);
+
+public:
+  /// Walk every chunk with a walker made by \p createWalker, and return the
+  /// walkers in chunk order for the caller to reduce.
+  template <typename WalkerTy, typename CreateWalkerFn>
+  llvm::SmallVector<std::unique_ptr<WalkerTy>, 0>
+  Walk(CreateWalkerFn createWalker) {
+    llvm::SmallVector<std::unique_ptr<WalkerTy>, 0> walkers;
+    walkers.reserve(GetNumChunks());
+    for (unsigned index = 0, count = GetNumChunks(); index != count; ++index) {
+      walkers.push_back(createWalker());
+    }
+    Run([&](unsigned chunk) -> ASTWalker & { return *walkers[chunk]; });
+    return walkers;
+  }
+};
+
+} // namespace stone
+
+#endif
@@ -32,6 +32,14 @@ public:
   };
 
 public:
+  /// The qualifier bits, as stored by serialized modules.
+  unsigned GetOpaqueValue() const { return qualSpecs; }
+  static QualSpecs GetFromOpaqueValue(unsigned value) {
+    QualSpecs quals;
+    quals.qualSpecs = value;
+    return quals;
+  }
+
   ///\Has const qualifier
   bool HasConst() const { return qualSpecs & Flags::Const; }
   ///\Has only const qualifier
@@ -8,8 +8,11 @@
 #ifndef STONE_AST_REDECLARABLE_H
 #define STONE_AST_REDECLARABLE_H
 
+#include "stone/AST/ASTAllocation.h"
+
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMapInfo.h"
-#include "llvm/ADT/PointerUnion.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Casting.h"
 
@@ -22,211 +25,103 @@ namespace stone {
 class Decl;
 class ASTContext;
 
-// Some notes on redeclarables:
-//
-//  - Every redeclarable is on a circular linked list.
-//
-//  - Every decl has a pointer to the first element of the chain _and_ a
-//    DeclLink that may point to one of 3 possible states:
-//      - the "previous" (temporal) element in the chain
-//      - the "latest" (temporal) element in the chain
-//      - the "uninitialized-latest" value (when newly-constructed)
-//
-//  - The first element is also often called the canonical element. Every
-//    element has a pointer to it so that "getCanonical" can be fast.
-//
-//  - Most links in the chain point to previous, except the link out of
-//    the first; it points to latest.
-//
-//  - Elements are called "first", "previous", "latest" or
-//    "most-recent" when referring to temporal order: order of addition
-//    to the chain.
-//
-//  - It's easiest to just ignore the implementation of DeclLink when making
-//    sense of the redeclaration chain.
-//
-//  - There's also a "definition" link for several types of
-//    redeclarable, where only one definition should exist at any given
-//    time (and the defn pointer is stored in the decl's "data" which
-//    is copied to every element on the chain when it's changed).
-//
-//    Here is some ASCII art:
-//
-//      "first"                                     "latest"
-//      "canonical"                                 "most recent"
-//      +------------+         first                +--------------+
-//      |            | <--------------------------- |              |
-//      |            |                              |              |
-//      |            |                              |              |
-//      |            |       +--------------+       |              |
-//      |            | first |              |       |              |
-//      |            | <---- |              |       |              |
-//      |            |       |              |       |              |
-//      | @class A   |  link | @interface A |  link | @class A     |
-//      | seen first | <---- | seen second  | <---- | seen third   |
-//      |            |       |              |       |              |
-//      +------------+       +--------------+       +--------------+
-//      | data       | defn  | data         |  defn | data         |
-//      |            | ----> |              | <---- |              |
-//      +------------+       +--------------+       +--------------+
-//        |                     |     ^                  ^
-//        |                     |defn |                  |
-//        | link                +-----+                  |
-//        +-->-------------------------------------------+
-
-/// Provides common interface for the Decls that can be redeclared.
-template <typename DeclTy> class Redeclarable {
-protected:
-  class DeclLink {
-    /// A pointer to a known latest declaration, either statically known or
-    /// generationally updated as decls are added by an external source.
-    using KnownLatest = LazyGenerationalUpdatePtr<const Decl *, Decl *>;
-
-    /// We store a pointer to the ASTContext in the UninitializedLatest
-    /// pointer, but to avoid circular type dependencies when we steal the low
-    /// bits of this pointer, we use a raw void* here.
-    using UninitializedLatest = const void *;
-
-    using Previous = Decl *;
-
-    /// A pointer to either an uninitialized latest declaration (where either
-    /// we've not yet set the previous decl or there isn't one), or to a known
-    /// previous declaration.
-    using NotKnownLatest = llvm::PointerUnion<Previous, UninitializedLatest>;
-
-    mutable llvm::PointerUnion<NotKnownLatest, KnownLatest> Link;
-
-  public:
-    enum PreviousTag { PreviousLink };
-    enum LatestTag { LatestLink };
-
-    DeclLink(LatestTag, const ASTContext &Ctx)
-        : Link(NotKnownLatest(reinterpret_cast<UninitializedLatest>(&Ctx))) {}
-    DeclLink(PreviousTag, DeclTy *D) : Link(NotKnownLatest(Previous(D))) {}
-
-    bool isFirst() const {
-      return Link.is<KnownLatest>() ||
-             // FIXME: 'template' is required on the next line due to an
-             // apparent stone bug.
-             Link.get<NotKnownLatest>().template is<UninitializedLatest>();
-    }
-
-    DeclTy *getPrevious(const DeclTy *D) const {
-      if (Link.is<NotKnownLatest>()) {
-        NotKnownLatest NKL = Link.get<NotKnownLatest>();
-        if (NKL.is<Previous>())
-          return static_cast<DeclTy *>(NKL.get<Previous>());
-
-        // Allocate the generational 'most recent' cache now, if needed.
-        Link = KnownLatest(*reinterpret_cast<const ASTContext *>(
-                               NKL.get<UninitializedLatest>()),
-                           const_cast<DeclTy *>(D));
-      }
-
-      return static_cast<DeclTy *>(Link.get<KnownLatest>().get(D));
-    }
+/// The decls of one redeclaration chain, in the order they were added.
+///
+/// Every decl on the chain points here, so the first and the latest decl are
+/// one load away however long the chain is, and walking the chain reads an
+/// array rather than chasing a link through every decl:
+///
+///      "first"                                     "latest"
+///      +------------+       +--------------+       +--------------+
+///      | fun f();   | prev  | fun f();     | prev  | fun f() {}   |
+///      | seen first | <---- | seen second  | <---- | seen third   |
+///      +------------+       +--------------+       +--------------+
+///            |                     |                      |
+///            +---------------------+----------------------+
+///                                  | chain
+///                                  v
+///                    RedeclChain { #1, #2, #3 }
+///
+/// A decl that was never redeclared has no chain.
+class RedeclChain final : public ASTAllocation<RedeclChain> {
+  llvm::SmallVector<Decl *, 4> decls;
 
-    void setPrevious(DeclTy *D) {
-      assert(!isFirst() && "decl became non-canonical unexpectedly");
-      Link = Previous(D);
-    }
+  explicit RedeclChain(Decl *first) { decls.push_back(first); }
 
-    void setLatest(DeclTy *D) {
-      assert(isFirst() && "decl became canonical unexpectedly");
-      if (Link.is<NotKnownLatest>()) {
-        NotKnownLatest NKL = Link.get<NotKnownLatest>();
-        Link = KnownLatest(*reinterpret_cast<const ASTContext *>(
-                               NKL.get<UninitializedLatest>()),
-                           D);
-      } else {
-        auto Latest = Link.get<KnownLatest>();
-        Latest.set(D);
-        Link = Latest;
-      }
-    }
+public:
+  static RedeclChain *Create(Decl *first, ASTContext &astContext);
 
-    void markIncomplete() { Link.get<KnownLatest>().markIncomplete(); }
+public:
+  Decl *GetFirst() const { return decls.front(); }
+  Decl *GetLatest() const { return decls.back(); }
+  llvm::ArrayRef<Decl *> GetDecls() const { return decls; }
 
-    Decl *getLatestNotUpdated() const {
-      assert(isFirst() && "expected a canonical decl");
-      if (Link.is<NotKnownLatest>())
-        return nullptr;
-      return Link.get<KnownLatest>().getNotUpdated();
-    }
-  };
+  void Add(Decl *decl) { decls.push_back(decl); }
+};
 
-  static DeclLink PreviousDeclLink(DeclTy *D) {
-    return DeclLink(DeclLink::PreviousLink, D);
-  }
+/// Provides common interface for the Decls that can be redeclared.
+/// Redeclarations are only ever added after the latest decl of a chain.
+template <typename DeclTy> class Redeclarable {
+  /// The chain of this decl, or null if it is the only declaration.
+  RedeclChain *chain = nullptr;
 
-  static DeclLink LatestDeclLink(const ASTContext &Ctx) {
-    return DeclLink(DeclLink::LatestLink, Ctx);
-  }
+  /// The declaration added just before this one, or null for the first.
+  DeclTy *previous = nullptr;
 
-  /// Points to the next redeclaration in the chain.
-  ///
-  /// If isFirst() is false, this is a link to the previous declaration
-  /// of this same Decl. If isFirst() is true, this is the first
-  /// declaration and Link points to the latest declaration. For example:
-  ///
-  ///  #1 int f(int x, int y = 1); // <pointer to #3, true>
-  ///  #2 int f(int x = 0, int y); // <pointer to #1, false>
-  ///  #3 int f(int x, int y) { return x + y; } // <pointer to #2, false>
-  ///
-  /// If there is only one declaration, it is <pointer to self, true>
-  DeclLink RedeclLink;
-
-  DeclTy *First;
-
-  DeclTy *getNextRedeclaration() const {
-    return RedeclLink.getPrevious(static_cast<const DeclTy *>(this));
-  }
+  DeclTy *GetSelf() { return static_cast<DeclTy *>(this); }
+  const DeclTy *GetSelf() const { return static_cast<const DeclTy *>(this); }
 
 public:
-  Redeclarable(const ASTContext &Ctx)
-      : RedeclLink(LatestDeclLink(Ctx)), First(static_cast<DeclTy *>(this)) {}
+  Redeclarable() = default;
 
-  /// Return the previous declaration of this declaration or NULL if this
+public:
+  /// Return the previous declaration of this declaration or null if this
   /// is the first declaration.
-  DeclTy *getPreviousDecl() {
-    if (!RedeclLink.isFirst())
-      return getNextRedeclaration();
-    return nullptr;
-  }
-  const DeclTy *getPreviousDecl() const {
-    return const_cast<DeclTy *>(static_cast<const DeclTy *>(this))
-        ->getPreviousDecl();
-  }
-
-  /// Return the first declaration of this declaration or itself if this
-  /// is the only declaration.
-  DeclTy *getFirstDecl() { return First; }
+  DeclTy *GetPreviousRedecl() const { return previous; }
 
   /// Return the first declaration of this declaration or itself if this
   /// is the only declaration.
-  const DeclTy *getFirstDecl() const { return First; }
+  DeclTy *GetFirstRedecl() {
+    return chain ? static_cast<DeclTy *>(chain->GetFirst()) : GetSelf();
+  }
+  const DeclTy *GetFirstRedecl() const {
+    return const_cast<Redeclarable *>(this)->GetFirstRedecl();
+  }
 
   /// True if this is the first declaration in its redeclaration chain.
-  bool isFirstDecl() const { return RedeclLink.isFirst(); }
+  bool IsFirstRedecl() const { return previous == nullptr; }
 
   /// Returns the most recent (re)declaration of this declaration.
-  DeclTy *getMostRecentDecl() { return getFirstDecl()->getNextRedeclaration(); }
-
-  /// Returns the most recent (re)declaration of this declaration.
-  const DeclTy *getMostRecentDecl() const {
-    return getFirstDecl()->getNextRedeclaration();
+  DeclTy *GetMostRecentRedecl() {
+    return chain ? static_cast<DeclTy *>(chain->GetLatest()) : GetSelf();
+  }
+  const DeclTy *GetMostRecentRedecl() const {
+    return const_cast<Redeclarable *>(this)->GetMostRecentRedecl();
   }
 
-  /// Set the previous declaration. If PrevDecl is NULL, set this as the
-  /// first and only declaration.
-  void setPreviousDecl(DeclTy *PrevDecl);
+  /// Add this declaration to the chain of \p prevDecl, which must be the
+  /// most recent declaration of that chain.
+  void SetPreviousRedecl(DeclTy *prevDecl, ASTContext &astContext) {
+    assert(prevDecl && prevDecl != GetSelf() && "invalid previous decl");
+    assert(!chain && "decl is already on a chain");
+    assert(prevDecl->GetMostRecentRedecl() == prevDecl &&
+           "redeclarations are added at the end of the chain");
+    auto &prevRedecl = static_cast<Redeclarable &>(*prevDecl);
+    if (!prevRedecl.chain) {
+      prevRedecl.chain = RedeclChain::Create(prevDecl, astContext);
+    }
+    chain = prevRedecl.chain;
+    previous = prevDecl;
+    chain->Add(GetSelf());
+  }
 
-  /// Iterates through all the redeclarations of the same decl.
+  /// Iterates through the redeclarations from the first to the latest. It
+  /// reads the array of the chain and never visits the decls themselves.
   class redecl_iterator {
-    /// Current - The current declaration.
-    DeclTy *Current = nullptr;
-    DeclTy *Starter;
-    bool PassedFirst = false;
+    /// The position in the decls of the chain.
+    Decl *const *Current = nullptr;
+    /// The decl itself, when it is not on a chain.
+    Decl *Only = nullptr;
 
   public:
     using value_type = DeclTy *;
@@ -236,30 +131,22 @@ public:
     using difference_type = std::ptrdiff_t;
 
     redecl_iterator() = default;
-    explicit redecl_iterator(DeclTy *C) : Current(C), Starter(C) {}
+    explicit redecl_iterator(Decl *const *C) : Current(C) {}
+    explicit redecl_iterator(Decl *only) : Only(only) {}
 
-    reference operator*() const { return Current; }
-    pointer operator->() const { return Current; }
+    reference operator*() const {
+      return static_cast<DeclTy *>(Only ? Only : *Current);
+    }
+    pointer operator->() const { return **this; }
 
     redecl_iterator &operator++() {
-      assert(Current && "Advancing while iterator has reached end");
-      // Make sure we don't infinitely loop on an invalid redecl chain. This
-      // should never happen.
-      if (Current->isFirstDecl()) {
-        if (PassedFirst) {
-          assert(0 && "Passed first decl twice, invalid redecl chain!");
-          Current = nullptr;
-          return *this;
-        }
-        PassedFirst = true;
+      if (Only) {
+        Only = nullptr;
+      } else {
+        ++Current;
       }
-
-      // Get either previous decl or latest decl.
-      DeclTy *Next = Current->getNextRedeclaration();
-      Current = (Next != Starter) ? Next : nullptr;
       return *this;
     }
-
     redecl_iterator operator++(int) {
       redecl_iterator tmp(*this);
       ++(*this);
@@ -267,10 +154,10 @@ public:
     }
 
     friend bool operator==(redecl_iterator x, redecl_iterator y) {
-      return x.Current == y.Current;
+      return x.Current == y.Current && x.Only == y.Only;
     }
     friend bool operator!=(redecl_iterator x, redecl_iterator y) {
-      return x.Current != y.Current;
+      return !(x == y);
     }
   };
 
@@ -278,14 +165,15 @@ public:
 
   /// Returns an iterator range for all the redeclarations of the same
   /// decl. It will iterate at least once (when this decl is the only one).
-  redecl_range redecls() const {
-    return redecl_range(redecl_iterator(const_cast<DeclTy *>(
-                            static_cast<const DeclTy *>(this))),
-                        redecl_iterator());
+  redecl_range GetRedecls() const {
+    if (!chain) {
+      Decl *only = const_cast<DeclTy *>(GetSelf());
+      return redecl_range(redecl_iterator(only), redecl_iterator());
+    }
+    auto decls = chain->GetDecls();
+    return redecl_range(redecl_iterator(decls.begin()),
+                        redecl_iterator(decls.end()));
   }
-
-  redecl_iterator redecls_begin() const { return redecls().begin(); }
-  redecl_iterator redecls_end() const { return redecls().end(); }
 };
 
 /// Get the primary declaration for a declaration from an AST file. That
@@ -0,0 +1,87 @@
+#ifndef STONE_AST_SERIALIZEDMODULE_H
+#define STONE_AST_SERIALIZEDMODULE_H
+
+#include "stone/AST/DeclName.h"
+#include "stone/AST/ModuleFormat.h"
+#include "stone/AST/Module.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <memory>
+#include <string>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace stone {
+class TypeBase;
+class ValueDecl;
+
+/// A module file read from a serialized module. The file is mapped, not
+/// read, and nothing is deserialized up front: a decl, and the identifiers
+/// and types it refers to, are only materialized when a lookup finds it.
+class SerializedModuleFile final : public ModuleFile {
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+
+  /// Materialized entities, indexed by ID - 1. Empty until first used.
+  llvm::SmallVector<Identifier, 0> identifiers;
+  llvm::SmallVector<TypeBase *, 0> types;
+  llvm::SmallVector<ValueDecl *, 0> decls;
+
+  unsigned numDeclsLoaded = 0;
+
+  SerializedModuleFile(ModuleDecl &owner,
+                       std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+public:
+  /// Check that \p buffer is a well-formed module file that this compiler can
+  /// read, and return the name of the module in it.
+  static bool Validate(llvm::MemoryBufferRef buffer,
+                       llvm::StringRef &moduleName, std::string &error);
+
+  /// Create the file for \p buffer, which must have been validated.
+  static SerializedModuleFile *
+  Create(ModuleDecl &owner, std::unique_ptr<llvm::MemoryBuffer> buffer);
+
+public:
+  /// Add the decls named \p name to \p results, materializing them first if
+  /// needed.
+  void LookupValue(DeclNameBase name,
+                   llvm::SmallVectorImpl<ValueDecl *> &results);
+
+  unsigned GetNumDecls() const { return GetHeader().numDecls; }
+  unsigned GetNumDeclsLoaded() const { return numDeclsLoaded; }
+
+private:
+  const serialization::ModuleFileHeader &GetHeader() const;
+
+  /// The word at \p offset, or nullptr if it is out of bounds.
+  const llvm::support::ulittle32_t *GetWords(uint32_t offset,
+                                             uint32_t count) const;
+
+  llvm::StringRef GetIdentifierText(serialization::IdentifierID id) const;
+
+  Identifier GetIdentifier(serialization::IdentifierID id);
+  TypeBase *GetType(serialization::TypeID id);
+  ValueDecl *GetDecl(serialization::DeclID id);
+
+public:
+  static bool classof(const ModuleFile *file) {
+    return file->GetKind() == ModuleFileKind::Serialized;
+  }
+  static bool classof(const DeclContext *dc) {
+    return llvm::isa<ModuleFile>(dc) && classof(llvm::cast<ModuleFile>(dc));
+  }
+};
+
+/// Write the named functions of the source files of \p module, and the types
+/// they use, as a module file. Decls whose type cannot be serialized yet are
+/// left out.
+void SerializeModule(ModuleDecl &module, llvm::raw_ostream &os);
+
+} // namespace stone
+
+#endif
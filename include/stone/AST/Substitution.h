@@ -43,9 +43,7 @@ namespace stone {
 // inline SubstOptions operator|(SubstFlags lhs, SubstFlags rhs) {
 //   return SubstOptions(lhs) | rhs;
 // }
-class SubstitutionMap {
-public:
-};
+class SubstitutionMap;
 
 } // namespace stone
 
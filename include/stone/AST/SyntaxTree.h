@@ -0,0 +1,221 @@
+#ifndef STONE_AST_SYNTAXTREE_H
+#define STONE_AST_SYNTAXTREE_H
+
+#include "stone/AST/ASTAllocation.h"
+#include "stone/Basic/Basic.h"
+#include "stone/Basic/LLVM.h"
+#include "stone/Basic/TokenKind.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stone {
+class ASTContext;
+class SyntaxTree;
+
+enum class SyntaxKind : uint8 {
+  /// A single token with its leading and trailing trivia.
+  Token = 0,
+  /// The root; it covers every byte of the buffer.
+  SourceFile,
+  /// A top-level declaration.
+  TopLevelDecl,
+  /// A balanced '(...)', '[...]' or '{...}', delimiters included. Groups
+  /// nest, so an edit inside a body only dirties the innermost group that
+  /// contains it.
+  ParenGroup,
+  SquareGroup,
+  BraceGroup,
+};
+
+/// An immutable node of the syntax tree. Green nodes are stored in one flat
+/// array in pre-order; a node's descendants follow it directly, so the
+/// children of a node are found by skipping over each child's subtree.
+///
+/// Offsets are absolute byte offsets into the source buffer and trivia is not
+/// copied: the text of every node is a slice of the buffer. The tokens of the
+/// tree cover the buffer without gaps, so the tree is lossless. The tokens are
+/// the ones the parser consumed, not the lexer's, so after the parser bails
+/// out the rest of the buffer is one run of trivia before the eof token.
+class GreenSyntaxNode final {
+  friend class SyntaxTreeBuilder;
+
+  SyntaxKind kind;
+  tok tokKind = tok::LAST;
+
+  /// The first byte of the node, including leading trivia.
+  uint32_t offset = 0;
+
+  /// The number of bytes covered by the node, including trivia.
+  uint32_t length = 0;
+
+  /// The bytes of trivia before the first and after the last token.
+  uint32_t leadingTriviaLength = 0;
+  uint32_t trailingTriviaLength = 0;
+
+  /// The number of nodes in this subtree, including this one.
+  uint32_t subtreeSize = 1;
+
+public:
+  explicit GreenSyntaxNode(SyntaxKind kind) : kind(kind) {}
+
+public:
+  SyntaxKind GetKind() const { return kind; }
+  bool IsToken() const { return kind == SyntaxKind::Token; }
+  tok GetTokenKind() const { return tokKind; }
+
+  uint32_t GetOffset() const { return offset; }
+  uint32_t GetLength() const { return length; }
+  uint32_t GetEndOffset() const { return offset + length; }
+
+  uint32_t GetLeadingTriviaLength() const { return leadingTriviaLength; }
+  uint32_t GetTrailingTriviaLength() const { return trailingTriviaLength; }
+
+  /// The offset and length of the node without its outer trivia.
+  uint32_t GetTextOffset() const { return offset + leadingTriviaLength; }
+  uint32_t GetTextLength() const {
+    return length - leadingTriviaLength - trailingTriviaLength;
+  }
+
+  uint32_t GetSubtreeSize() const { return subtreeSize; }
+};
+
+/// A parent-linked view of a green node. Red nodes are only created when a
+/// client walks to them and are then cached by the tree.
+class SyntaxNode final : public ASTAllocation<SyntaxNode> {
+  const SyntaxTree &tree;
+  const SyntaxNode *parent;
+  unsigned index;
+
+public:
+  SyntaxNode(const SyntaxTree &tree, const SyntaxNode *parent, unsigned index)
+      : tree(tree), parent(parent), index(index) {}
+
+public:
+  const SyntaxTree &GetTree() const { return tree; }
+  const SyntaxNode *GetParent() const { return parent; }
+  const GreenSyntaxNode &GetGreen() const;
+
+  SyntaxKind GetKind() const { return GetGreen().GetKind(); }
+  bool IsToken() const { return GetGreen().IsToken(); }
+  tok GetTokenKind() const { return GetGreen().GetTokenKind(); }
+
+  unsigned GetNumChildren() const;
+  const SyntaxNode *GetChild(unsigned n) const;
+  llvm::SmallVector<const SyntaxNode *, 4> GetChildren() const;
+
+  /// The source text of the node, including all trivia.
+  llvm::StringRef GetFullText() const;
+
+  /// The source text of the node without its outer trivia.
+  llvm::StringRef GetText() const;
+
+  llvm::StringRef GetLeadingTrivia() const;
+  llvm::StringRef GetTrailingTrivia() const;
+};
+
+/// A lossless syntax tree for one source buffer.
+class SyntaxTree final : public ASTAllocation<SyntaxTree> {
+  friend class SyntaxNode;
+
+  const ASTContext &astContext;
+
+  /// The buffer the tree describes. Node text refers into it.
+  llvm::StringRef buffer;
+
+  /// The green nodes, in pre-order, allocated in the ASTContext.
+  llvm::ArrayRef<GreenSyntaxNode> nodes;
+
+  /// The red node for each green node, allocated on the first walk.
+  mutable const SyntaxNode **redNodes = nullptr;
+
+public:
+  SyntaxTree(const ASTContext &astContext, llvm::StringRef buffer,
+             llvm::ArrayRef<GreenSyntaxNode> nodes)
+      : astContext(astContext), buffer(buffer), nodes(nodes) {}
+
+public:
+  llvm::StringRef GetBuffer() const { return buffer; }
+  llvm::ArrayRef<GreenSyntaxNode> GetGreenNodes() const { return nodes; }
+
+  /// The red node for the root of the tree.
+  const SyntaxNode *GetRoot() const { return GetNode(0, nullptr); }
+
+  /// Rebuild the source text from the tokens; equal to the buffer.
+  std::string GetSourceText() const;
+
+  /// \return the innermost interior node whose text, without its outer
+  /// trivia, contains the \p length bytes at \p offset. This is the smallest
+  /// node that has to be reparsed after those bytes are edited.
+  const SyntaxNode *FindEnclosingNode(uint32_t offset, uint32_t length) const;
+
+private:
+  const SyntaxNode *GetNode(unsigned index, const SyntaxNode *parent) const;
+};
+
+/// Builds the green node array while the parser runs. Tokens are added in
+/// source order and the gap between two tokens is split at the first newline:
+/// the part before it is the trailing trivia of the earlier token and the rest
+/// is the leading trivia of the later one.
+///
+/// Besides the nodes the parser opens, the builder groups every balanced pair
+/// of delimiters into a group node by itself.
+class SyntaxTreeBuilder final {
+  llvm::StringRef buffer;
+  std::vector<GreenSyntaxNode> nodes;
+
+  /// An interior node and the first and last token in it (~0U if none).
+  /// Its byte range is only known once the trivia after its last token is.
+  struct PendingNode final {
+    unsigned index;
+    unsigned firstToken = ~0U;
+    unsigned lastToken = ~0U;
+    /// The token that closes a group node, or tok::LAST for parser nodes.
+    tok closer = tok::LAST;
+
+    bool IsGroup() const { return closer != tok::LAST; }
+  };
+  llvm::SmallVector<PendingNode, 8> openNodes;
+  std::vector<PendingNode> closedNodes;
+
+  /// The most recently added token.
+  unsigned lastToken = ~0U;
+
+  /// The end of the text consumed by the tokens so far.
+  uint32_t consumedOffset = 0;
+
+public:
+  explicit SyntaxTreeBuilder(llvm::StringRef buffer);
+
+public:
+  void OpenNode(SyntaxKind kind);
+  void CloseNode();
+
+  /// Add a token whose text is at \p offset in the buffer.
+  void AddToken(tok kind, uint32_t offset, uint32_t length);
+
+  /// Drop the tokens whose text starts at or after \p offset, and the nodes
+  /// that only hold such tokens, so that the parser can add them again after
+  /// backtracking. Nodes the parser still has open stay open.
+  void Rewind(uint32_t offset);
+
+  /// Add the end-of-file token and close the root. Any bytes not covered by a
+  /// token, such as text the parser gave up on, become its leading trivia.
+  /// That text keeps its bytes but has no structure: it is not re-lexed.
+  SyntaxTree *Finish(const ASTContext &astContext);
+
+private:
+  void OpenPendingNode(SyntaxKind kind, tok closer);
+  void ClosePendingNode();
+
+  /// \return the last token in [begin, end) or ~0U if there is none.
+  unsigned FindLastToken(unsigned begin, unsigned end) const;
+};
+
+} // namespace stone
+
+#endif
@@ -47,6 +47,8 @@ class InterfaceType;
 class StructDecl;
 class TypeBase;
 class Type;
+class CanType;
+class SubstitutionMap;
 class TypeWalker;
 
 enum class GCKind : uint8 { None = 0, Weak, Strong };
@@ -85,6 +87,15 @@ public:
   // const TypeModifierList &GetModifiers() const { return Modifiers; }
   // TypeModifierList &GetModifiers() { return Modifiers; }
 
+  /// \return the canonical form of this type.
+  CanType GetCanType() const;
+
+  /// \return true if both types have the same canonical type.
+  bool IsEqual(Type other) const;
+
+  /// \return this type with the parameters of \p subs replaced.
+  Type Subst(SubstitutionMap subs) const;
+
 public:
   /// Walk this Type.
   ///
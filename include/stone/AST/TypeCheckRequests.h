@@ -0,0 +1,31 @@
+#ifndef STONE_AST_TYPECHECKREQUESTS_H
+#define STONE_AST_TYPECHECKREQUESTS_H
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Evaluator.h"
+
+namespace stone {
+
+/// Type check one decl. The answer is whether checking ran.
+class TypeCheckDeclRequest final
+    : public SimpleRequest<TypeCheckDeclRequest, bool, Decl> {
+public:
+  static constexpr RequestKind kind = RequestKind::TypeCheckDecl;
+  using SimpleRequest::SimpleRequest;
+
+  bool Evaluate(Evaluator &evaluator) const;
+};
+
+/// The function that a virtual function overrides, or null.
+class OverriddenDeclRequest final
+    : public SimpleRequest<OverriddenDeclRequest, FunctionDecl *,
+                           FunctionDecl> {
+public:
+  static constexpr RequestKind kind = RequestKind::OverriddenDecl;
+  using SimpleRequest::SimpleRequest;
+
+  FunctionDecl *Evaluate(Evaluator &evaluator) const;
+};
+
+} // namespace stone
+#endif
@@ -46,6 +46,7 @@
 namespace stone {
 
 class Type;
+class NominalTypeDecl;
 class TypeState;
 class TypeWalker;
 class CanType;
@@ -55,15 +56,23 @@ class Int16Type;
 class FunType;
 class StructType;
 class ASTContext;
+class AliasDecl;
 
 class alignas(1 << TypeBaseAlignInBits) TypeBase
-    : public ASTAllocation<std::aligned_storage<8, 8>::type> {
+    : public ASTAllocation<std::aligned_storage<8, 8>::type,
+                           ASTAllocationKind::Type> {
   friend class ASTContext;
 
+  /// The underlying type
+  ASTRef<TypeBase> underlyingType;
+
+#ifndef STONE_COMPRESSED_AST_REFS
+  /// With compressed references the ASTContext is found through the cage.
   const ASTContext &astContext;
+#endif
 
-  /// The underlying type
-  TypeBase *underlyingType = nullptr;
+  /// The canonical type, once GetCanType has computed it.
+  mutable ASTRef<TypeBase> canType;
 
   TypeBase(const TypeBase &) = delete;
   void operator=(const TypeBase &) = delete;
@@ -88,7 +97,12 @@ protected:
 public:
   TypeBase(TypeKind kind, const ASTContext &astContext,
            TypeBase *underlyingType = nullptr)
-      : astContext(astContext), underlyingType(underlyingType) {
+      : underlyingType(underlyingType)
+#ifndef STONE_COMPRESSED_AST_REFS
+        ,
+        astContext(astContext)
+#endif
+  {
 
     Bits.TypeBase.Kind = static_cast<unsigned>(kind);
     Bits.TypeBase.IsCanonical = true;
@@ -110,8 +124,20 @@ public:
   bool HasQualifiers() const;
 
   bool IsCanType() const { return Bits.TypeBase.IsCanonical; }
-  bool HasCanType() { return underlyingType != nullptr; }
-  TypeBase *GetCanType() { return underlyingType; }
+  bool HasCanType() const {
+    return IsCanType() || !canType.IsNull();
+  }
+
+  /// \return the canonical type, looking through aliases and other sugar.
+  /// The result is computed on the first call and cached in the node.
+  ///
+  /// This is not thread-safe: the first call writes the cache in the node and
+  /// may add nodes to the ASTContext's uniquing tables, neither of which is
+  /// locked.
+  CanType GetCanType() const;
+
+  /// \return the type under one level of sugar, or this type if it has none.
+  TypeBase *GetDesugaredType() const;
 
   // void SetState(TypeState *TS) { typeState = TS; }
   // TypeState *GetState() { return typeState; }
@@ -203,8 +229,14 @@ public:
   bool IsStructType() const;
   StructType *GetStructType() const;
 
+protected:
+  /// Structural types are canonical only when all their components are.
+  void SetIsCanType(bool isCanonical) {
+    Bits.TypeBase.IsCanonical = isCanonical;
+  }
+
 private:
-  // CanType ComputeCanType();
+  CanType ComputeCanType() const;
 };
 
 // inline bool CanType::IsCanTypeOrNull() const {
@@ -219,6 +251,12 @@ protected:
   BuiltinType(TypeKind kind, const ASTContext &AC) : TypeBase(kind, AC) {
     // Bits.TypeBase.IsBuiltin = true;
   }
+
+public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() >= TypeKind::First_BuiltinType &&
+           ty->GetKind() <= TypeKind::Last_BuiltinType;
+  }
 };
 
 // class IdentifierType : public TypeBase{
@@ -485,23 +523,64 @@ class FunctionType : public TypeBase {
 
 public:
   FunctionType(TypeKind kind, Type returnType, const ASTContext &astContext)
-      : TypeBase(kind, astContext) {}
+      : TypeBase(kind, astContext), returnType(returnType) {}
+
+public:
+  Type GetReturnType() const { return returnType; }
+
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() >= TypeKind::First_FunctionType &&
+           ty->GetKind() <= TypeKind::Last_FunctionType;
+  }
 };
 
-// You are returning Type for now, it may have to be Type
-class FunType : public FunctionType,
-                private llvm::TrailingObjects<FunType, Type> {
+/// A function type: fun(params) -> returnType. FunTypes are uniqued in the
+/// ASTContext, so two FunTypes with the same signature are the same node.
+class FunType final : public FunctionType,
+                      public llvm::FoldingSetNode,
+                      private llvm::TrailingObjects<FunType, Type> {
   friend TrailingObjects;
+  friend ASTContext;
+
+  unsigned numParams;
+
+  FunType(Type returnType, llvm::ArrayRef<Type> paramTypes,
+          const ASTContext &astContext);
 
 public:
-  FunType(Type resultType, const ASTContext &AC);
+  llvm::ArrayRef<Type> GetParamTypes() const {
+    return {getTrailingObjects<Type>(), numParams};
+  }
+  unsigned GetNumParams() const { return numParams; }
+
+public:
+  void Profile(llvm::FoldingSetNodeID &id) const {
+    Profile(id, GetReturnType(), GetParamTypes());
+  }
+  static void Profile(llvm::FoldingSetNodeID &id, Type returnType,
+                      llvm::ArrayRef<Type> paramTypes);
+
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Fun;
+  }
 };
 
 class NominalType : public TypeBase {
 protected:
   friend ASTContext;
 
+  /// The declaration of this type.
+  NominalTypeDecl *decl;
+
+  NominalType(TypeKind kind, NominalTypeDecl *decl,
+              const ASTContext &astContext)
+      : TypeBase(kind, astContext), decl(decl) {
+    SetIsCanType(true);
+  }
+
 public:
+  NominalTypeDecl *GetDecl() const { return decl; }
+
   // Implement isa/cast/dyncast/etc.
   static bool classof(const TypeBase *ty) {
     return ty->GetKind() >= TypeKind::First_NominalType &&
@@ -510,21 +589,51 @@ public:
 };
 
 class StructType final : public NominalType {
+  friend NominalTypeDecl;
+
+  StructType(NominalTypeDecl *decl, const ASTContext &astContext)
+      : NominalType(TypeKind::Struct, decl, astContext) {}
+
 public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Struct;
+  }
 };
 
 class ClassType final : public NominalType {
+  friend NominalTypeDecl;
+
+  ClassType(NominalTypeDecl *decl, const ASTContext &astContext)
+      : NominalType(TypeKind::Class, decl, astContext) {}
+
 public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Class;
+  }
 };
 
 class InterfaceType final : public NominalType {
+  friend NominalTypeDecl;
+
+  InterfaceType(NominalTypeDecl *decl, const ASTContext &astContext)
+      : NominalType(TypeKind::Interface, decl, astContext) {}
+
 public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Interface;
+  }
 };
 
 class EnumType final : public NominalType {
+  friend NominalTypeDecl;
+
+  EnumType(NominalTypeDecl *decl, const ASTContext &astContext)
+      : NominalType(TypeKind::Enum, decl, astContext) {}
 
 public:
-  // GetString();
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Enum;
+  }
 };
 
 class DeducedType : public TypeBase {
@@ -538,14 +647,47 @@ public:
 
 class AccessType : public TypeBase {
   // Base class for access-related types.
+protected:
+  AccessType(TypeKind kind, const ASTContext &astContext)
+      : TypeBase(kind, astContext) {}
 };
 
-class PointerType : public AccessType {
+class PointerType : public AccessType, public llvm::FoldingSetNode {
   // Base class for pointer types.
+  Type pointeeType;
+
+protected:
+  PointerType(TypeKind kind, Type pointeeType, const ASTContext &astContext)
+      : AccessType(kind, astContext), pointeeType(pointeeType) {
+    SetIsCanType(pointeeType->IsCanType());
+  }
+
+public:
+  Type GetPointeeType() const { return pointeeType; }
+
+public:
+  void Profile(llvm::FoldingSetNodeID &id) const {
+    Profile(id, GetKind(), pointeeType);
+  }
+  static void Profile(llvm::FoldingSetNodeID &id, TypeKind kind,
+                      Type pointeeType);
+
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Raw || ty->GetKind() == TypeKind::Move;
+  }
 };
 
-class RawType : public PointerType {
+class RawType final : public PointerType {
   // General pointer type.
+  friend ASTContext;
+
+  RawType(Type pointeeType, const ASTContext &astContext)
+      : PointerType(TypeKind::Raw, pointeeType, astContext) {}
+
+public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Raw;
+  }
 };
 
 class MemberPointerType : public PointerType {
@@ -560,16 +702,79 @@ class OwnRawType : public PointerType {
   // Pointer type with ownership semantics.
 };
 
-class MoveType : public PointerType {
+class MoveType final : public PointerType {
   // Pointer type with move semantics.
+  friend ASTContext;
+
+  MoveType(Type pointeeType, const ASTContext &astContext)
+      : PointerType(TypeKind::Move, pointeeType, astContext) {}
+
+public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Move;
+  }
 };
 
-class ReferenceType : public AccessType {
+class ReferenceType : public AccessType, public llvm::FoldingSetNode {
   // Base class for reference types.
+  Type referentType;
+
+protected:
+  ReferenceType(TypeKind kind, Type referentType, const ASTContext &astContext)
+      : AccessType(kind, astContext), referentType(referentType) {
+    SetIsCanType(referentType->IsCanType());
+  }
+
+public:
+  Type GetReferentType() const { return referentType; }
+
+public:
+  void Profile(llvm::FoldingSetNodeID &id) const {
+    Profile(id, GetKind(), referentType);
+  }
+  static void Profile(llvm::FoldingSetNodeID &id, TypeKind kind,
+                      Type referentType);
+
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() >= TypeKind::First_ReferenceType &&
+           ty->GetKind() <= TypeKind::Last_ReferenceType;
+  }
 };
 
-class RefType : public ReferenceType {
+class RefType final : public ReferenceType {
   // General reference type.
+  friend ASTContext;
+
+  RefType(Type referentType, const ASTContext &astContext)
+      : ReferenceType(TypeKind::Ref, referentType, astContext) {}
+
+public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Ref;
+  }
+};
+
+/// A type with qualifiers, such as const int. The base type never has
+/// qualifiers itself; ASTContext::GetQualifiedType merges nested qualifiers.
+class QualifiedType final : public TypeBase {
+  friend ASTContext;
+
+  Type baseType;
+  QualSpecs quals;
+
+  QualifiedType(Type baseType, QualSpecs quals, const ASTContext &astContext)
+      : TypeBase(TypeKind::Qualified, astContext), baseType(baseType),
+        quals(quals) {
+    SetIsCanType(baseType->IsCanType());
+  }
+
+public:
+  Type GetBaseType() const { return baseType; }
+  QualSpecs GetQualSpecs() const { return quals; }
+
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Qualified;
+  }
 };
 
 // class PointerType : public Type {
@@ -690,11 +895,37 @@ class SugarType : public TypeBase {
   //   Type *underlyingType;
   //   const ASTContext *Context;
   // };
+protected:
+  SugarType(TypeKind kind, Type underlyingType, const ASTContext &astContext)
+      : TypeBase(kind, astContext, underlyingType.GetPtr()) {
+    SetIsCanType(false);
+  }
+
+public:
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() >= TypeKind::First_SugarType &&
+           ty->GetKind() <= TypeKind::Last_SugarType;
+  }
 };
 /// An alias to a type
 /// alias Int = int; My using use using Int = int;
-class AliasType : public SugarType {
+class AliasType final : public SugarType {
+  AliasDecl *aliasDecl;
+
+public:
+  /// \p underlyingType may be null while the alias is not yet resolved; the
+  /// underlying type of \p aliasDecl is used instead.
+  AliasType(AliasDecl *aliasDecl, Type underlyingType,
+            const ASTContext &astContext)
+      : SugarType(TypeKind::Alias, underlyingType, astContext),
+        aliasDecl(aliasDecl) {}
+
 public:
+  AliasDecl *GetAliasDecl() const { return aliasDecl; }
+
+  static bool classof(const TypeBase *ty) {
+    return ty->GetKind() == TypeKind::Alias;
+  }
 };
 
 // /// An alias to a type
@@ -1,12 +1,73 @@
 #ifndef STONE_AST_VIRTUALTABLE_H
 #define STONE_AST_VIRTUALTABLE_H
 
+#include "stone/AST/ASTAllocation.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/TrailingObjects.h"
+
+#include <optional>
+
 namespace stone {
 
-class VirtualTable final {
+class ASTContext;
+class ClassDecl;
+class FunctionDecl;
+
+/// The virtual function layout of a class: one slot per virtual function,
+/// holding the function that a call through the slot reaches for this class.
+///
+/// A class keeps the slots of its superclass at the same indices, overriding
+/// some of them, and appends slots for the virtual functions it introduces.
+/// The layout is built from the superclass's layout, so a deep hierarchy
+/// builds every layout once. A layout is rebuilt when its class changes or
+/// the superclass's layout was rebuilt. Type checking uses it to find
+/// overridden functions and CodeGen to emit the table.
+class VirtualTable final
+    : public ASTAllocation<VirtualTable>,
+      private llvm::TrailingObjects<VirtualTable, FunctionDecl *> {
+  friend TrailingObjects;
+
+  ClassDecl &classDecl;
+
+  /// The layout of the superclass, or null for a root class.
+  const VirtualTable *parent;
+
+  unsigned numSlots;
+
+  /// The virtual generation of the class when the layout was built.
+  unsigned generation;
+
+  /// The slots filled by functions of this class: introduced or overriding.
+  llvm::DenseMap<const FunctionDecl *, unsigned> ownSlots;
+
+  VirtualTable(ClassDecl &classDecl, const VirtualTable *parent,
+               unsigned generation, llvm::ArrayRef<FunctionDecl *> slots,
+               llvm::DenseMap<const FunctionDecl *, unsigned> &&ownSlots);
+
+public:
+  /// Lay out the virtual functions of \p classDecl on top of \p parent.
+  static VirtualTable *Create(ClassDecl &classDecl, const VirtualTable *parent,
+                              unsigned generation, ASTContext &astContext);
+
 public:
-  VirtualTable();
-  ~VirtualTable();
+  ClassDecl &GetClassDecl() const { return classDecl; }
+  const VirtualTable *GetParent() const { return parent; }
+  unsigned GetGeneration() const { return generation; }
+
+  /// The function each slot reaches, in slot order.
+  llvm::ArrayRef<FunctionDecl *> GetSlots() const {
+    return {getTrailingObjects<FunctionDecl *>(), numSlots};
+  }
+  unsigned GetNumSlots() const { return numSlots; }
+
+  /// \return the slot \p fn fills in this class or a superclass, if any.
+  std::optional<unsigned> GetSlotIndex(const FunctionDecl *fn) const;
+
+  /// \return the function that \p fn, a function of this class, overrides,
+  /// or null if it introduces its slot.
+  FunctionDecl *GetOverriddenDecl(const FunctionDecl *fn) const;
 };
 
 } // namespace stone
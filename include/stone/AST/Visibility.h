@@ -8,12 +8,17 @@
 #include "stone/Basic/PlatformKind.h"
 #include "stone/Basic/SrcLoc.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SmallVector.h"
 
 namespace stone {
 
+class Decl;
 class DeclContext;
+class Type;
+class TypeBase;
+
 enum class VisibilityLevel : uint8 {
   None = 0,
   Public,
@@ -109,12 +114,39 @@ class VisibilityContext {
 public:
 };
 
+/// \returns the level that lets fewer clients see a decl. A decl without a
+/// level is internal.
+VisibilityLevel GetNarrowerVisibility(VisibilityLevel lhs, VisibilityLevel rhs);
+
+/// \returns true if \p lhs lets fewer clients see a decl than \p rhs.
+bool IsNarrowerVisibility(VisibilityLevel lhs, VisibilityLevel rhs);
+
+/// The effective visibility of decls and types: the narrowest level of a decl
+/// and the decls that enclose it, and of a type and the types it is built
+/// from. Each decl and each canonical type is computed once, so checking the
+/// signatures of a module is linear in the decls and types it has.
+class VisibilityCache final {
+  llvm::DenseMap<const Decl *, VisibilityLevel> decls;
+  llvm::DenseMap<const TypeBase *, VisibilityLevel> types;
+
+public:
+  VisibilityLevel GetEffectiveVisibility(Decl *decl);
+  VisibilityLevel GetEffectiveVisibility(Type type);
+};
+
 class ExportContext {
   DeclContext *DC;
+  /// Whether the signature is seen outside its module.
+  bool exported;
+
   ExportContext(DeclContext *DC, VisibilityContext runningOSVersion,
-                std::optional<PlatformKind> unavailablePlatformKind);
+                std::optional<PlatformKind> unavailablePlatformKind,
+                bool exported);
 
 public:
+  DeclContext *GetDeclContext() const { return DC; }
+  bool IsExported() const { return exported; }
+
   /// Create an instance describing the types that can be referenced from the
   /// given declaration's signature.
   ///
@@ -128,8 +160,5 @@ public:
 /// declaration itself. Related checks may also be performed.
 void CheckVisibilityControl(Decl *D);
 
-/// Check the Type visibility level
-void CheckVisibilityControl(Type ty);
-
 } // namespace stone
 #endif
\ No newline at end of file
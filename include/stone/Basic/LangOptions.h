@@ -54,6 +54,15 @@ public:
   /// Enable 'availability' restrictions for App Extensions.
   bool EnableAppExtensionRestrictions = false;
 
+  /// Leave '#if' blocks to the parser instead of evaluating them while lexing.
+  bool DisablePoundIfEvaluation = false;
+
+  /// Build a lossless syntax tree for each source file.
+  bool BuildSyntaxTree = false;
+
+  /// Record the tokens consumed by the parser on each source file.
+  bool CollectParsedTokens = false;
+
 public:
   enum class ThreadModelKind {
     /// POSIX Threads.
@@ -108,6 +117,20 @@ public:
   bool CheckPlatformCondition(PlatformConditionKind Kind,
                               llvm::StringRef Value) const;
 
+  /// Sets a custom conditional compilation flag, as in '-D FLAG'.
+  void AddCustomConditionalCompilationFlag(llvm::StringRef Name) {
+    assert(!Name.empty());
+    CustomConditionalCompilationFlags.push_back(Name.str());
+  }
+
+  /// Determines whether the given custom conditional compilation flag is set.
+  bool IsCustomConditionalCompilationFlagSet(llvm::StringRef Name) const;
+
+  /// Returns the custom conditional compilation flags in the order added.
+  llvm::ArrayRef<std::string> GetCustomConditionalCompilationFlags() const {
+    return CustomConditionalCompilationFlags;
+  }
+
 public:
   class TargetResult final {
     friend LangOptions;
@@ -0,0 +1,139 @@
+#ifndef STONE_BASIC_MEMORYCAGE_H
+#define STONE_BASIC_MEMORYCAGE_H
+
+#include "llvm/Support/Compiler.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace stone {
+
+/// A contiguous reservation of address space, aligned to its own size. Any
+/// 8-byte aligned address in the cage can be named by a 32-bit offset from
+/// the base, and the cage of an address is found by masking the address, so
+/// an object in the cage can decompress an offset using its own address.
+///
+/// The first bytes of the cage hold a header with the owner of the cage.
+/// Offset 0 therefore never names an allocation and stands for null.
+///
+/// Address space is never given back before the cage is destroyed, but a
+/// slab that is released goes on a free list and is handed out again, so an
+/// arena that is reset does not grow the cage.
+class MemoryCage final {
+  struct Header final {
+    void *owner;
+  };
+
+  /// A released slab. The link lives in the slab itself.
+  struct FreeSlab final {
+    FreeSlab *next;
+    size_t bytes;
+  };
+
+  /// The first byte past the committed pages.
+  uintptr_t committedEnd;
+
+  /// The first byte that has not been handed out.
+  uintptr_t cursor;
+
+  /// The released slabs, most recently released first.
+  FreeSlab *freeSlabs = nullptr;
+
+  /// The total size of the slabs on the free list.
+  size_t bytesFree = 0;
+
+  MemoryCage() = default;
+
+public:
+  /// Offsets are scaled by the alignment of the allocations in the cage.
+  static constexpr unsigned ScaleInBits = 3;
+  static constexpr uint64_t Size = uint64_t(1) << (32 + ScaleInBits);
+
+  MemoryCage(const MemoryCage &) = delete;
+  MemoryCage &operator=(const MemoryCage &) = delete;
+
+public:
+  /// Reserve a new cage for \p owner. Pages are committed as slabs are
+  /// allocated.
+  static MemoryCage *Create(void *owner);
+
+  /// Release the whole cage, and every slab in it.
+  void Destroy();
+
+  /// Allocate \p bytes from the cage, aligned to at least \p alignment. A
+  /// released slab that fits is reused before the cage grows.
+  void *AllocateSlab(size_t bytes, size_t alignment);
+
+  /// Put the \p bytes at \p slab on the free list.
+  void DeallocateSlab(void *slab, size_t bytes);
+
+  uintptr_t GetBase() const { return GetBase(this); }
+
+  /// The number of bytes the cage has grown to, including the header and the
+  /// released slabs.
+  size_t GetBytesAllocated() const { return cursor - GetBase(); }
+
+  /// The number of bytes in released slabs, waiting to be reused.
+  size_t GetBytesFree() const { return bytesFree; }
+
+public:
+  static uintptr_t GetBase(const void *ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) & ~(Size - 1);
+  }
+
+  /// \return the owner of the cage that \p ptr is in.
+  static void *GetOwner(const void *ptr) {
+    return reinterpret_cast<const Header *>(GetBase(ptr))->owner;
+  }
+
+  static uint32_t Compress(const void *ptr) {
+    if (!ptr) {
+      return 0;
+    }
+    auto offset = reinterpret_cast<uintptr_t>(ptr) - GetBase(ptr);
+    assert((offset & ((uint64_t(1) << ScaleInBits) - 1)) == 0 &&
+           "cage pointers must be 8-byte aligned");
+    return static_cast<uint32_t>(offset >> ScaleInBits);
+  }
+
+  /// \return the pointer named by \p offset in the cage of \p holder.
+  static void *Decompress(const void *holder, uint32_t offset) {
+    if (!offset) {
+      return nullptr;
+    }
+    return reinterpret_cast<void *>(GetBase(holder) +
+                                    (uintptr_t(offset) << ScaleInBits));
+  }
+};
+
+struct MemoryCageDeleter final {
+  void operator()(MemoryCage *cage) const { cage->Destroy(); }
+};
+using MemoryCagePtr = std::unique_ptr<MemoryCage, MemoryCageDeleter>;
+
+/// The slab allocator of a BumpPtrAllocator whose slabs come from a cage.
+/// Released slabs go back to the cage for reuse; they are only returned to
+/// the system when the cage is destroyed.
+class MemoryCageSlabAllocator {
+  MemoryCage *cage;
+
+public:
+  explicit MemoryCageSlabAllocator(MemoryCage *cage) : cage(cage) {}
+
+public:
+  LLVM_ATTRIBUTE_RETURNS_NONNULL void *Allocate(size_t bytes,
+                                                size_t alignment) {
+    return cage->AllocateSlab(bytes, alignment);
+  }
+  void Deallocate(const void *ptr, size_t bytes, size_t alignment) {
+    cage->DeallocateSlab(const_cast<void *>(ptr), bytes);
+  }
+
+  MemoryCage *GetCage() const { return cage; }
+};
+
+} // namespace stone
+
+#endif
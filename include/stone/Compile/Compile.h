@@ -62,6 +62,9 @@ void PerformPrintAST(CompilerInstance &instance, SourceFile &sourceFile);
 // \return true if the code generation was successfull
 bool PerformEmitCode(CompilerInstance &instance);
 
+// \return true if the main module could not be written as a module file
+bool PerformSerializeModule(CompilerInstance &instance);
+
 using PerformEmitIRCallback =
     llvm::function_ref<bool(CompilerInstance &, CodeGenResult &)>;
 
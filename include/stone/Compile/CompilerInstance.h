@@ -70,6 +70,9 @@ public:
 
   StatsReporter *GetStats() { return stats.get(); }
 
+  /// Print the statistics to stderr if -print-stats was passed.
+  void PrintStats();
+
   ///\the primary requested action
   CompilerActionKind GetPrimaryActionKind() const {
     return invocation.GetCompilerOptions().GetPrimaryAction();
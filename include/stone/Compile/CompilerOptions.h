@@ -64,6 +64,9 @@ public:
   /// The path to which we should output statistics files.
   std::string statsOutputDir;
 
+  /// Print the statistics as JSON when the compile finishes.
+  bool printStats = false;
+
   /// Follow the compile lifecyle
   bool printLifecycle = false;
 
@@ -8,6 +8,7 @@
 
 // TODO: Move to support
 namespace stone {
+class LangOptions;
 class SrcMgr;
 class Token;
 /// Given a pointer to the starting byte of a UTF8 character, validate it and
@@ -121,6 +122,24 @@ class Lexer final : public LexerBase {
   /// deep.
   const char *LexerCutOffPoint = nullptr;
 
+  /// If this is not \c nullptr, '#if' directives at the start of a line are
+  /// evaluated against these options and the inactive clauses are skipped
+  /// without being tokenized.
+  const LangOptions *IfConfigLangOpts = nullptr;
+
+  /// The byte ranges of the '#if' clauses skipped so far, in source order.
+  std::vector<CharSrcRange> InactiveIfConfigRanges;
+
+  /// The number of '#if' blocks open after each directive lexed so far, keyed
+  /// by the directive's '#'. Restoring an earlier state drops the entries past
+  /// it, so a directive lexed again after backtracking is counted once.
+  std::vector<std::pair<const char *, unsigned>> IfConfigDepths;
+
+  /// The number of tokens lexed so far. A token lexed again after the state
+  /// was restored counts again, so this measures the work done, not the size
+  /// of the buffer.
+  unsigned NumTokensLexed = 0;
+
   Lexer(const Lexer &) = delete;
   void operator=(const Lexer &) = delete;
 
@@ -177,6 +196,12 @@ public:
   Lexer(unsigned BufferID, const SrcMgr &sm, DiagnosticEngine *de,
         StatsReporter *se);
 
+  /// Create a lexer that evaluates '#if' directives while lexing, using the
+  /// platform conditions and custom flags in \p IfConfigLangOpts. Only the
+  /// tokens of active clauses are produced.
+  Lexer(unsigned BufferID, const SrcMgr &sm, DiagnosticEngine *de,
+        StatsReporter *se, const LangOptions *IfConfigLangOpts);
+
   /// Create a lexer that scans a subrange of the source buffer.
   Lexer(unsigned BufferID, const SrcMgr &sm, stone::DiagnosticEngine *de,
         StatsReporter *se, LexerMode LexMode, HashbangMode HashbangAllowed,
@@ -194,6 +219,17 @@ public:
   /// Returns true if this lexer will produce a code completion token.
   bool isCodeCompletion() const { return CodeCompletionPtr != nullptr; }
 
+  /// Returns the number of tokens lexed so far, re-lexed ones included.
+  unsigned getNumTokensLexed() const { return NumTokensLexed; }
+
+  /// Returns true if this lexer evaluates '#if' directives.
+  bool isEvaluatingIfConfig() const { return IfConfigLangOpts != nullptr; }
+
+  /// Returns the byte ranges of the inactive '#if' clauses skipped so far.
+  llvm::ArrayRef<CharSrcRange> getInactiveIfConfigRanges() const {
+    return InactiveIfConfigRanges;
+  }
+
   /// Whether we are lexing a Swift interface file.
   bool IsStoneInterface() const { return LexMode == LexerMode::StoneInterface; }
 
@@ -282,6 +318,9 @@ public:
   void restoreState(LexerState S, bool enableDiagnostics = false) {
     assert(S.IsValid());
     CurPtr = getBufferPtrForSrcLoc(S.loc);
+    while (!IfConfigDepths.empty() && IfConfigDepths.back().first >= CurPtr) {
+      IfConfigDepths.pop_back();
+    }
     LexImpl();
 
     // TODO: Don't re-emit diagnostics from readvancing the lexer.
@@ -524,6 +563,26 @@ private:
   void skipSlashStarComment();
 
   void lexHash();
+
+  /// Handle a '#if', '#elseif', '#else' or '#endif' directive when
+  /// evaluating conditions at lex time. \c CurPtr is just past the directive
+  /// keyword and \p TokStart at its '#'. Returns false if the directive
+  /// should be formed as a token.
+  bool lexIfConfigDirective(tok Kind, const char *TokStart);
+
+  /// Evaluate the condition following '#if' or '#elseif' up to the end of the
+  /// line. Malformed conditions are diagnosed and evaluate to false.
+  bool evaluateIfConfigCondition();
+
+  /// Skip the inactive clause that starts at \c CurPtr. Returns a pointer to
+  /// the '#' of the directive that ends the clause and sets \p Kind to it, or
+  /// returns \c nullptr if the end of the buffer is reached first.
+  const char *skipInactiveIfConfigClause(tok &Kind) const;
+
+  /// The number of '#if' blocks open at \c CurPtr.
+  unsigned getIfConfigDepth() const {
+    return IfConfigDepths.empty() ? 0 : IfConfigDepths.back().second;
+  }
   void lexIdentifier();
   void lexDollarIdent();
   void lexOperatorIdentifier();
@@ -11,6 +11,7 @@
 #include "stone/AST/Modfifier.h"
 #include "stone/AST/Module.h"
 #include "stone/AST/Stmt.h"
+#include "stone/AST/SyntaxTree.h"
 #include "stone/AST/TypeResult.h"
 #include "stone/Basic/StableHasher.h"
 
@@ -188,6 +189,12 @@ class Parser final {
   /// The code completion call back
   CodeCompletionCallbacks *codeCompletionCallbacks = nullptr;
 
+  /// Where consumed tokens are recorded when the source file collects them.
+  std::vector<ParsedToken> *parsedTokens = nullptr;
+
+  /// Builds the syntax tree when the source file asks for one.
+  std::optional<SyntaxTreeBuilder> syntaxTreeBuilder;
+
   mutable llvm::BumpPtrAllocator allocator;
 
   ParsingScopeCache parsingScopeCache;
@@ -260,6 +267,53 @@ private:
   void AddTopLevelDecl(ParserResult<Decl> result);
   void Lex(Token &result) { lexer->Lex(result); }
 
+  ///\return the byte offset of \p tok in the buffer being parsed.
+  uint32_t GetTokenOffset(const Token &tok) const {
+    auto bufferStart = static_cast<const char *>(
+        lexer->GetLocForStartOfBuffer().getOpaquePointerValue());
+    auto tokStart =
+        static_cast<const char *>(tok.GetLoc().getOpaquePointerValue());
+    return static_cast<uint32_t>(tokStart - bufferStart);
+  }
+
+  /// Record \p tok in the source file's parsed tokens and syntax tree.
+  void RecordParsedToken(const Token &tok) {
+    auto offset = GetTokenOffset(tok);
+    auto length = static_cast<uint32_t>(tok.GetLength());
+    if (parsedTokens) {
+      parsedTokens->push_back(ParsedToken{tok.GetKind(), offset, length});
+    }
+    if (syntaxTreeBuilder) {
+      syntaxTreeBuilder->AddToken(tok.GetKind(), offset, length);
+    }
+  }
+
+  /// Drop what was recorded for \p tok and the tokens after it. Called after
+  /// backtracking, since the parser is about to consume them again.
+  void ForgetParsedTokensFrom(const Token &tok) {
+    auto offset = GetTokenOffset(tok);
+    if (parsedTokens) {
+      while (!parsedTokens->empty() && parsedTokens->back().offset >= offset) {
+        parsedTokens->pop_back();
+      }
+    }
+    if (syntaxTreeBuilder) {
+      syntaxTreeBuilder->Rewind(offset);
+    }
+  }
+
+  /// Open and close a node of the syntax tree, if one is being built.
+  void OpenSyntaxNode(SyntaxKind kind) {
+    if (syntaxTreeBuilder) {
+      syntaxTreeBuilder->OpenNode(kind);
+    }
+  }
+  void CloseSyntaxNode() {
+    if (syntaxTreeBuilder) {
+      syntaxTreeBuilder->CloseNode();
+    }
+  }
+
 public:
   bool IsStartOfDecl();
   bool IsTopLevelDeclParsing();
@@ -491,6 +545,7 @@ public:
                               bool enableDiagnostics = false) {
     GetLexer().restoreState(parsingPos.lexingState, enableDiagnostics);
     Lex(curTok);
+    ForgetParsedTokensFrom(curTok);
 
     prevTokLoc = parsingPos.prevLoc;
   }
@@ -499,6 +554,7 @@ public:
     assert(parsingPos.isValid());
     GetLexer().backtrackToState(parsingPos.lexingState);
     Lex(curTok);
+    ForgetParsedTokensFrom(curTok);
     prevTokLoc = parsingPos.prevLoc;
   }
 
@@ -125,13 +125,17 @@ private:
   /// record any additional stats until we've finished.
   bool IsFlushingTracesAndProfiles;
 
+  /// Whether the stats are written to StatsFilename when the reporter goes
+  /// away. Off when they are only printed, as with -print-stats alone.
+  bool WriteStatsFile;
+
   void publishAlwaysOnStatsToLLVM();
   void printAlwaysOnStatsAndTimers(raw_ostream &OS);
 
   StatsReporter(llvm::StringRef ProgramName, llvm::StringRef AuxName,
                 llvm::StringRef Directory, SrcMgr *SM,
                 clang::SourceManager *CSM, bool TraceEvents, bool ProfileEvents,
-                bool ProfileEntities);
+                bool ProfileEntities, bool WriteStatsFile);
 
 public:
   StatsReporter(llvm::StringRef ProgramName, llvm::StringRef ModuleName,
@@ -139,7 +143,8 @@ public:
                 llvm::StringRef OutputType, llvm::StringRef OptType,
                 llvm::StringRef Directory, SrcMgr *SM = nullptr,
                 clang::SourceManager *CSM = nullptr, bool TraceEvents = false,
-                bool ProfileEvents = false, bool ProfileEntities = false);
+                bool ProfileEvents = false, bool ProfileEntities = false,
+                bool WriteStatsFile = true);
   ~StatsReporter();
 
   AlwaysOnDriverCounters &getDriverCounters();
@@ -149,6 +154,9 @@ public:
   void saveAnyFrontendStatsEvents(FrontendStatsTracer const &T, bool IsEntry);
   void recordJobMaxRSS(long rss);
   int64_t getChildrenMaxResidentSetSize();
+
+  /// Print the always-on counters as JSON, as -print-stats does.
+  void printAlwaysOnStats(raw_ostream &OS);
 };
 
 // This is a non-nested type just to make it less work to write at call sites.
@@ -1,4 +1,5 @@
 #include "stone/AST/ASTContext.h"
+#include "stone/AST/DiagnosticsCompile.h"
 #include "stone/AST/Module.h"
 
 #include "llvm/ADT/DenseMap.h"
@@ -18,7 +19,19 @@ ASTContext::ASTContext(LangOptions &langOpts, const SearchPathOptions &spOpts,
                        StatsReporter *stats)
     : langOpts(langOpts), searchPathOpts(spOpts),
       typeCheckerOpts(typeCheckerOpts), clangImporter(clangImporter), de(de),
-      stats(stats), identifierTable(allocator), builtin(*this) {
+#ifdef STONE_COMPRESSED_AST_REFS
+      cage(MemoryCage::Create(this)),
+      allocator(MemoryCageSlabAllocator(cage.get())),
+#endif
+      identifierTable(allocator), declNames(*this), stats(stats),
+      builtin(*this), evaluator(*this) {
+
+#ifdef STONE_COMPRESSED_AST_REFS
+  // Every node must be in the cage for its references to be compressed.
+  if (langOpts.useMalloc) {
+    de.diagnose(SrcLoc(), diag::warning_use_malloc_ignored_with_compressed_refs);
+  }
+#endif
 
   // Initialize all of the known identifiers.
   // This is done here because the allocation is not yet initialized.
@@ -33,7 +46,48 @@ ASTContext::~ASTContext() {
   }
 }
 
-llvm::BumpPtrAllocator &ASTContext::GetAllocator() const { return allocator; }
+void ASTContext::AddCleanup(std::function<void(void)> cleanup) {
+  cleanups.push_back(std::move(cleanup));
+}
+
+ASTArenaAllocator &
+ASTContext::GetAllocator(MemoryAllocationArena arena) const {
+  if (arena == MemoryAllocationArena::Temporary) {
+    assert(numActiveTemporaryArenas != 0 &&
+           "temporary allocation outside of a TemporaryArenaScope");
+    return *temporaryArenas[numActiveTemporaryArenas - 1];
+  }
+  return allocator;
+}
+
+size_t ASTContext::GetTemporaryMemoryAllocated() const {
+  size_t total = 0;
+  for (auto &temporaryArena : temporaryArenas) {
+    total += temporaryArena->getTotalMemory();
+  }
+  return total;
+}
+
+TemporaryArenaScope::TemporaryArenaScope(const ASTContext &astContext)
+    : astContext(astContext) {
+  auto &arenas = astContext.temporaryArenas;
+  if (astContext.numActiveTemporaryArenas == arenas.size()) {
+#ifdef STONE_COMPRESSED_AST_REFS
+    arenas.push_back(std::make_unique<ASTArenaAllocator>(
+        MemoryCageSlabAllocator(astContext.cage.get())));
+#else
+    arenas.push_back(std::make_unique<ASTArenaAllocator>());
+#endif
+  }
+  ++astContext.numActiveTemporaryArenas;
+}
+
+TemporaryArenaScope::~TemporaryArenaScope() {
+  assert(astContext.numActiveTemporaryArenas != 0 &&
+         "unbalanced arena scopes");
+  // Keep the arena and its first slab for the next scope at this depth.
+  astContext.temporaryArenas[--astContext.numActiveTemporaryArenas]->Reset();
+}
 
 void ASTContext::AddLoadedModule(ModuleDecl *mod) {
   assert(mod);
@@ -75,7 +129,132 @@ Identifier ASTContext::GetRealModuleName(Identifier key,
   return value.first;
 }
 
+FunType *ASTContext::GetFunType(Type returnType,
+                                llvm::ArrayRef<Type> paramTypes) const {
+  llvm::FoldingSetNodeID id;
+  FunType::Profile(id, returnType, paramTypes);
+
+  void *insertPos = nullptr;
+  if (auto *funType = funTypes.FindNodeOrInsertPos(id, insertPos)) {
+    return funType;
+  }
+  void *mem = AllocateMemory(FunType::totalSizeToAlloc<Type>(paramTypes.size()),
+                             alignof(FunType));
+  auto *funType = ::new (mem) FunType(returnType, paramTypes, *this);
+  funTypes.InsertNode(funType, insertPos);
+  return funType;
+}
+
+template <typename T>
+T *ASTContext::GetPointerType(TypeKind kind, Type pointeeType) const {
+  assert(pointeeType && "pointer to a null type");
+  llvm::FoldingSetNodeID id;
+  PointerType::Profile(id, kind, pointeeType);
+
+  void *insertPos = nullptr;
+  if (auto *pointerType = pointerTypes.FindNodeOrInsertPos(id, insertPos)) {
+    return llvm::cast<T>(pointerType);
+  }
+  auto *pointerType = new (*this) T(pointeeType, *this);
+  pointerTypes.InsertNode(pointerType, insertPos);
+  return pointerType;
+}
+
+RawType *ASTContext::GetRawType(Type pointeeType) const {
+  return GetPointerType<RawType>(TypeKind::Raw, pointeeType);
+}
+
+MoveType *ASTContext::GetMoveType(Type pointeeType) const {
+  return GetPointerType<MoveType>(TypeKind::Move, pointeeType);
+}
+
+RefType *ASTContext::GetRefType(Type referentType) const {
+  assert(referentType && "reference to a null type");
+  llvm::FoldingSetNodeID id;
+  ReferenceType::Profile(id, TypeKind::Ref, referentType);
+
+  void *insertPos = nullptr;
+  if (auto *refType = referenceTypes.FindNodeOrInsertPos(id, insertPos)) {
+    return llvm::cast<RefType>(refType);
+  }
+  auto *refType = new (*this) RefType(referentType, *this);
+  referenceTypes.InsertNode(refType, insertPos);
+  return refType;
+}
+
+Type ASTContext::GetQualifiedType(Type baseType, QualSpecs quals) const {
+  assert(baseType && "qualifying a null type");
+
+  // Keep the base type unqualified so that each combination of base type and
+  // qualifiers has exactly one node.
+  if (auto *qualifiedType = llvm::dyn_cast<QualifiedType>(baseType.GetPtr())) {
+    quals.qualSpecs |= qualifiedType->GetQualSpecs().qualSpecs;
+    baseType = qualifiedType->GetBaseType();
+  }
+  quals.qualSpecs &= ~QualSpecs::None;
+  if (quals.qualSpecs == 0) {
+    return baseType;
+  }
+  auto &qualifiedType = qualifiedTypes[{baseType.GetPtr(), quals.qualSpecs}];
+  if (!qualifiedType) {
+    qualifiedType = new (*this) QualifiedType(baseType, quals, *this);
+  }
+  return qualifiedType;
+}
+
+void ASTContext::RecordAllocation(size_t bytes, MemoryAllocationArena arena,
+                                  ASTAllocationKind kind) const {
+  assert(stats && "recording an allocation without a stats reporter");
+  auto &counters = stats->getFrontendCounters();
+  counters.NumASTBytesAllocated += bytes;
+
+  switch (kind) {
+  case ASTAllocationKind::Decl:
+    counters.NumASTBytesAllocatedForDecls += bytes;
+    break;
+  case ASTAllocationKind::Expr:
+    counters.NumASTBytesAllocatedForExprs += bytes;
+    break;
+  case ASTAllocationKind::Stmt:
+    counters.NumASTBytesAllocatedForStmts += bytes;
+    break;
+  case ASTAllocationKind::Type:
+    counters.NumASTBytesAllocatedForTypes += bytes;
+    break;
+  case ASTAllocationKind::Identifier:
+    counters.NumASTBytesAllocatedForIdentifiers += bytes;
+    break;
+  case ASTAllocationKind::Other:
+    counters.NumASTBytesAllocatedForOther += bytes;
+    break;
+  }
+
+  switch (arena) {
+  case MemoryAllocationArena::Stoneanent:
+    counters.NumASTBytesAllocatedPermanent += bytes;
+    break;
+  case MemoryAllocationArena::Temporary:
+    counters.NumASTBytesAllocatedScratch += bytes;
+    break;
+  }
+
+  switch (allocationPhase) {
+  case ASTAllocationPhase::None:
+    break;
+  case ASTAllocationPhase::Parse:
+    counters.NumASTBytesAllocatedDuringParse += bytes;
+    break;
+  case ASTAllocationPhase::Sema:
+    counters.NumASTBytesAllocatedDuringSema += bytes;
+    break;
+  case ASTAllocationPhase::CodeGen:
+    counters.NumASTBytesAllocatedDuringCodeGen += bytes;
+    break;
+  }
+}
+
 void *stone::AllocateInASTContext(size_t bytes, const ASTContext &ctx,
-                                  unsigned alignment) {
-  return ctx.AllocateMemory(bytes, alignment);
+                                  MemoryAllocationArena arena,
+                                  unsigned alignment, ASTAllocationKind kind) {
+  return ctx.AllocateMemory(bytes, alignment, arena, kind);
 }
@@ -1,30 +1,105 @@
 #include "stone/AST/ASTScope.h"
+#include "stone/Basic/SrcMgr.h"
+
+#include <algorithm>
 
 using namespace stone;
 
-// static const auto &GetScopeNameTable() {
-//   static const std::pair<ScopeKind, const char *> Table[] = {
-//       {ScopeKind::Decl, "Decl"},
-//       {ScopeKind::FunDecl, "Function Declaration"},
-//       {ScopeKind::SourceFile, "Source File"},
-//       {ScopeKind::FunctionSignature, "Function Signature "},
-//   };
-//   return Table;
-// }
-
-// const char *Scope::GetName(ScopeKind kind) {
-//   for (const auto &item : GetScopeNameTable()) {
-//     if (item.first == kind) {
-//       return item.second;
-//     }
-//   }
-//   assert(false && "Invalid ScopeKind");
-// }
-
-// Scope::Scope(ScopeKind kind, DiagnosticEngine &diags, Scope *parent)
-//     : kind(kind), diags(diags), parent(parent) {
-//   Initialize();
-// }
-// Scope::~Scope() {}
-
-// void Scope::Initialize() { scopeDecls.clear(); }
\ No newline at end of file
+static const auto &GetScopeNameTable() {
+  static const std::pair<ASTScopeKind, const char *> Table[] = {
+      {ASTScopeKind::None, "None"},
+      {ASTScopeKind::File, "File"},
+      {ASTScopeKind::TopLevelDecl, "Top Level Declaration"},
+      {ASTScopeKind::Decl, "Declaration"},
+      {ASTScopeKind::FunctionDecl, "Function Declaration"},
+      {ASTScopeKind::FunctionSignature, "Function Signature"},
+      {ASTScopeKind::FunctionArguments, "Function Arguments"},
+      {ASTScopeKind::FunctionBody, "Function Body"},
+      {ASTScopeKind::EnumDecl, "Enum Declaration"},
+      {ASTScopeKind::StructDecl, "Struct Declaration"},
+      {ASTScopeKind::InterfaceDecl, "Interface Declaration"},
+      {ASTScopeKind::ClassDecl, "Class Declaration"},
+  };
+  return Table;
+}
+
+const char *ASTScope::GetName(ASTScopeKind kind) {
+  for (const auto &item : GetScopeNameTable()) {
+    if (item.first == kind) {
+      return item.second;
+    }
+  }
+  llvm_unreachable("Invalid ASTScopeKind");
+}
+
+ASTScope::ASTScope(ASTScopeKind kind, DiagnosticEngine &diags,
+                   ASTScope *parent)
+    : kind(kind), diags(diags), parent(parent),
+      parentAndWasExpanded(parent, false) {
+  Initialize();
+}
+ASTScope::~ASTScope() {}
+
+void ASTScope::Initialize() {
+  scopeDecls.clear();
+  lookupTable.clear();
+  hasLookupTable = false;
+}
+
+void ASTScope::AddChild(ASTScope *child, const SrcMgr &sm) {
+  assert(child->GetParent() == this && "child of another scope");
+  auto insertPos = std::upper_bound(
+      storedChildren.begin(), storedChildren.end(), child,
+      [&](const ASTScope *lhs, const ASTScope *rhs) {
+        return sm.isBeforeInBuffer(lhs->srcRange.Start, rhs->srcRange.Start);
+      });
+  storedChildren.insert(insertPos, child);
+}
+
+ASTScope *ASTScope::FindInnermostScope(SrcLoc loc, const SrcMgr &sm) {
+  auto scope = this;
+  while (true) {
+    // The children are sorted and disjoint, so the only candidate is the
+    // first one that does not end before the location.
+    auto children = scope->GetChildren();
+    auto candidate = std::partition_point(
+        children.begin(), children.end(), [&](const ASTScope *child) {
+          return sm.isBeforeInBuffer(child->srcRange.End, loc);
+        });
+    if (candidate == children.end() ||
+        !sm.rangeContainsTokenLoc((*candidate)->srcRange, loc)) {
+      return scope;
+    }
+    scope = *candidate;
+  }
+}
+
+unsigned ASTScope::GetLookupGeneration() const {
+  unsigned lookupGeneration = 0;
+  for (auto scope = this; scope; scope = scope->parent) {
+    lookupGeneration += scope->generation;
+  }
+  return lookupGeneration;
+}
+
+llvm::ArrayRef<ValueDecl *> ASTScope::LookupLocal(DeclNameBase name) {
+  if (!hasLookupTable) {
+    lookupTable.clear();
+    for (auto d : scopeDecls) {
+      auto valueDecl = llvm::dyn_cast<ValueDecl>(d);
+      if (!valueDecl) {
+        continue;
+      }
+      auto declName = valueDecl->GetName().GetDeclNameBase();
+      if (declName.IsValid()) {
+        lookupTable[declName].push_back(valueDecl);
+      }
+    }
+    hasLookupTable = true;
+  }
+  auto found = lookupTable.find(name);
+  if (found == lookupTable.end()) {
+    return {};
+  }
+  return found->second;
+}
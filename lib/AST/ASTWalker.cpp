@@ -1,3 +1,95 @@
 #include "stone/AST/ASTWalker.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/ParallelASTWalker.h"
+#include "stone/AST/Stmt.h"
 
-using stone::ASTWalker;
+#include "llvm/Support/Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace stone;
+
+bool Decl::Walk(ASTWalker &walker) {
+  if (!walker.WalkToDeclPre(this)) {
+    return false;
+  }
+  if (auto functionDecl = llvm::dyn_cast<FunctionDecl>(this)) {
+    // Never synthesize here: walks may run on several threads at once.
+    if (auto body = functionDecl->GetBody(/*canSynthesize=*/false)) {
+      auto result = walker.WalkToStmtPre(body);
+      if (!result.second) {
+        return true;
+      }
+      // A walker that skips the body does not see it again on the way out.
+      if (result.first && !walker.WalkToStmtPost(result.second)) {
+        return true;
+      }
+    }
+  }
+  return !walker.WalkToDeclPost(this);
+}
+
+ParallelASTWalk::ParallelASTWalk(ModuleDecl &module, unsigned chunkSize)
+    : chunkSize(std::max(chunkSize, 1U)) {
+  for (auto file : module.GetFiles()) {
+    if (auto sourceFile = llvm::dyn_cast<SourceFile>(file)) {
+      for (auto decl : sourceFile->GetTopLevelDecls()) {
+        AddDecl(decl);
+      }
+    }
+  }
+}
+
+void ParallelASTWalk::AddDecl(Decl *decl) {
+  decls.push_back(decl);
+  auto nominalTypeDecl = llvm::dyn_cast<NominalTypeDecl>(decl);
+  if (!nominalTypeDecl) {
+    return;
+  }
+  // The functions of a type are walked on their own, so a type with many
+  // bodies is spread over several chunks.
+  AddMembers(nominalTypeDecl);
+  for (auto join : nominalTypeDecl->GetJoins()) {
+    AddMembers(join);
+  }
+}
+
+void ParallelASTWalk::AddMembers(DeclContext *dc) {
+  for (auto functionDecl : dc->GetFunctionDecls()) {
+    decls.push_back(functionDecl);
+  }
+  for (auto nominalTypeDecl : dc->GetNominalTypeDecls()) {
+    AddDecl(nominalTypeDecl);
+  }
+}
+
+unsigned ParallelASTWalk::GetNumChunks() const {
+  return (decls.size() + chunkSize - 1) / chunkSize;
+}
+
+llvm::ArrayRef<Decl *> ParallelASTWalk::GetChunk(unsigned index) const {
+  assert(index < GetNumChunks() && "chunk out of range");
+  return llvm::ArrayRef<Decl *>(decls).slice(
+      index * chunkSize,
+      std::min<size_t>(chunkSize, decls.size() - index * chunkSize));
+}
+
+bool ParallelASTWalk::Run(
+    llvm::function_ref<ASTWalker &(unsigned chunk)> getWalker) {
+  std::atomic<bool> aborted(false);
+  llvm::parallelFor(0, GetNumChunks(), [&](size_t index) {
+    if (aborted.load(std::memory_order_relaxed)) {
+      return;
+    }
+    auto &walker = getWalker(index);
+    for (auto decl : GetChunk(index)) {
+      if (decl->Walk(walker)) {
+        aborted.store(true, std::memory_order_relaxed);
+        return;
+      }
+    }
+  });
+  return aborted.load();
+}
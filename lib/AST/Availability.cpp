@@ -0,0 +1,94 @@
+#include "stone/AST/Availability.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/DeclContext.h"
+#include "stone/AST/DiagnosticsSem.h"
+
+using namespace stone;
+
+AvailabilityContext AvailabilityContext::forDeploymentTarget(ASTContext &Ctx) {
+  return AvailabilityContext(VersionRange::allGTE(
+      Ctx.GetLangOptions().DefaultTargetTriple.getOSVersion()));
+}
+
+void ASTContext::SetAnnotatedAvailability(
+    const Decl *decl, const AvailabilityContext &available) {
+  annotatedAvailability[decl] =
+      AllocateObjectCopy(AvailabilityContext(available));
+}
+
+const AvailabilityContext *
+ASTContext::GetAnnotatedAvailability(const Decl *decl) const {
+  auto found = annotatedAvailability.find(decl);
+  if (found == annotatedAvailability.end()) {
+    return nullptr;
+  }
+  return found->second;
+}
+
+std::optional<AvailabilityContext>
+AvailabilityInference::annotatedAvailableRange(const Decl *D, ASTContext &C) {
+  if (auto annotated = C.GetAnnotatedAvailability(D)) {
+    return *annotated;
+  }
+  return std::nullopt;
+}
+
+AvailabilityContext AvailabilityInference::availableRange(const Decl *D,
+                                                          ASTContext &C) {
+  if (auto annotated = annotatedAvailableRange(D, C)) {
+    return *annotated;
+  }
+  return AvailabilityContext::alwaysAvailable();
+}
+
+const AvailabilityContext &DeclContext::GetAvailabilityContext() const {
+  if (availability) {
+    return *availability;
+  }
+  auto &astContext = GetASTContext();
+  const AvailabilityContext *parentAvailability =
+      parent ? &parent->GetAvailabilityContext() : nullptr;
+
+  std::optional<AvailabilityContext> annotated;
+  if (auto decl = ToDecl()) {
+    annotated =
+        AvailabilityInference::annotatedAvailableRange(decl, astContext);
+  }
+  if (parentAvailability &&
+      (!annotated || parentAvailability->isContainedIn(*annotated))) {
+    availability = parentAvailability;
+    return *availability;
+  }
+
+  auto result = parentAvailability
+                    ? *parentAvailability
+                    : AvailabilityContext::forDeploymentTarget(astContext);
+  if (annotated) {
+    result.constrainWith(*annotated);
+  }
+  availability = astContext.AllocateObjectCopy(result);
+  return *availability;
+}
+
+void stone::CheckAvailability(Decl *D) {
+  auto dc = D->GetDeclContext();
+  if (!dc) {
+    return;
+  }
+  auto &astContext = D->GetASTContext();
+  auto annotated =
+      AvailabilityInference::annotatedAvailableRange(D, astContext);
+  if (!annotated) {
+    return;
+  }
+  // Annotating below the deployment target is harmless; only a range the
+  // enclosing decls rule out is an error.
+  auto available = AvailabilityContext::forDeploymentTarget(astContext);
+  available.constrainWith(*annotated);
+  if (!available.isContainedIn(dc->GetAvailabilityContext())) {
+    astContext.GetDiags().diagnose(
+        D->GetNameLoc(), diag::error_decl_more_available_than_enclosing_scope,
+        D->GetBasicNameText());
+  }
+}
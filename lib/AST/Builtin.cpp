@@ -26,3 +26,50 @@ Builtin::Builtin(const ASTContext &AC)
       BuiltinUInt64Type(new(AC) UInt64Type(AC)),
       BuiltinUInt128Type(new(AC) UInt128Type(AC)),
       BuiltinUIntType(new(AC) UIntType(AC)) {}
+
+Type Builtin::GetType(TypeKind kind) const {
+  switch (kind) {
+  case TypeKind::Void:
+    return BuiltinVoidType;
+  case TypeKind::Null:
+    return BuiltinNullType;
+  case TypeKind::Bool:
+    return BuiltinBoolType;
+  case TypeKind::Float16:
+    return BuiltinFloat16Type;
+  case TypeKind::Float32:
+    return BuiltinFloat32Type;
+  case TypeKind::Float64:
+    return BuiltinFloat64Type;
+  case TypeKind::Float128:
+    return BuiltinFloat128Type;
+  case TypeKind::Float:
+    return BuiltinFloatType;
+  case TypeKind::Int8:
+    return BuiltinInt8Type;
+  case TypeKind::Int16:
+    return BuiltinInt16Type;
+  case TypeKind::Int32:
+    return BuiltinInt32Type;
+  case TypeKind::Int64:
+    return BuiltinInt64Type;
+  case TypeKind::Int128:
+    return BuiltinInt128Type;
+  case TypeKind::Int:
+    return BuiltinIntType;
+  case TypeKind::UInt8:
+    return BuiltinUInt8Type;
+  case TypeKind::UInt16:
+    return BuiltinUInt16Type;
+  case TypeKind::UInt32:
+    return BuiltinUInt32Type;
+  case TypeKind::UInt64:
+    return BuiltinUInt64Type;
+  case TypeKind::UInt128:
+    return BuiltinUInt128Type;
+  case TypeKind::UInt:
+    return BuiltinUIntType;
+  default:
+    return Type();
+  }
+}
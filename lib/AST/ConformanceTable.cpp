@@ -0,0 +1,116 @@
+#include "stone/AST/ConformanceTable.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Types.h"
+#include "stone/Support/Statistics.h"
+
+#include "llvm/ADT/SmallVector.h"
+
+using namespace stone;
+
+void ConformanceTable::Build(NominalTypeDecl &nominal, unsigned newGeneration) {
+  entries.clear();
+  generation = newGeneration;
+
+  // Interfaces the type names come first, so that an interface both named
+  // and implied is recorded as named.
+  llvm::SmallVector<ConformanceEntry, 8> worklist;
+  auto addNamed = [&](NominalTypeDecl &named) {
+    for (auto &inherited : named.GetInheritedInterfaces()) {
+      ConformanceEntry entry;
+      entry.interface = inherited.first;
+      entry.declaredIn = inherited.second;
+      worklist.push_back(entry);
+    }
+  };
+  addNamed(nominal);
+  // A class conforms to what its superclasses name, and what it names itself
+  // is recorded as its own. SetSuperclass keeps the chain free of cycles.
+  if (auto classDecl = llvm::dyn_cast<ClassDecl>(&nominal)) {
+    for (auto superclass = classDecl->GetSuperclass(); superclass;
+         superclass = superclass->GetSuperclass()) {
+      addNamed(*superclass);
+    }
+  }
+  for (unsigned i = 0; i != worklist.size(); ++i) {
+    auto entry = worklist[i];
+    if (!entries.try_emplace(entry.interface, entry).second) {
+      continue;
+    }
+    // Conforming to an interface means conforming to what it inherits.
+    for (auto &implied : entry.interface->GetInheritedInterfaces()) {
+      ConformanceEntry impliedEntry;
+      impliedEntry.interface = implied.first;
+      impliedEntry.declaredIn = entry.declaredIn;
+      impliedEntry.impliedBy = entry.interface;
+      worklist.push_back(impliedEntry);
+    }
+  }
+}
+
+const ConformanceEntry *
+ConformanceTable::Find(InterfaceDecl *interface) const {
+  auto found = entries.find(interface);
+  if (found == entries.end()) {
+    return nullptr;
+  }
+  return &found->second;
+}
+
+void NominalTypeDecl::AddInheritedInterface(InterfaceDecl *interface,
+                                            DeclContext *declaredIn) {
+  inheritedInterfaces.push_back({interface, declaredIn});
+  // Tables of other types include this one's interfaces when it is an
+  // interface they name, so every table and every answer may be stale.
+  Decl::GetASTContext().InvalidateConformances();
+}
+
+ConformanceTable &NominalTypeDecl::GetConformanceTable() {
+  auto &astContext = Decl::GetASTContext();
+  auto generation = astContext.GetConformanceGeneration();
+  if (conformanceTable && conformanceTable->GetGeneration() == generation) {
+    return *conformanceTable;
+  }
+  if (!conformanceTable) {
+    conformanceTable = new (astContext) ConformanceTable(generation);
+    auto table = conformanceTable;
+    astContext.AddCleanup([table]() { table->~ConformanceTable(); });
+  }
+  conformanceTable->Build(*this, generation);
+  return *conformanceTable;
+}
+
+const ConformanceEntry *
+NominalTypeDecl::LookupConformance(InterfaceDecl *interface) {
+  return GetConformanceTable().Find(interface);
+}
+
+bool ASTContext::ConformsTo(Type type, InterfaceDecl *interface) const {
+  if (!type || !interface) {
+    return false;
+  }
+  auto canType = type->GetCanType();
+  auto found = conformances.find({canType.GetPtr(), interface});
+  if (found != conformances.end()) {
+    if (stats) {
+      ++stats->getFrontendCounters().NumConformanceCacheHits;
+    }
+    return found->second;
+  }
+  if (stats) {
+    ++stats->getFrontendCounters().NumConformanceCacheMisses;
+  }
+
+  bool result = false;
+  if (auto qualifiedType = llvm::dyn_cast<QualifiedType>(canType.GetPtr())) {
+    result = ConformsTo(qualifiedType->GetBaseType(), interface);
+  } else if (auto nominalType = llvm::dyn_cast<NominalType>(canType.GetPtr())) {
+    if (auto nominal = nominalType->GetDecl()) {
+      // An interface conforms to itself.
+      result = nominal == interface ||
+               nominal->LookupConformance(interface) != nullptr;
+    }
+  }
+  conformances[{canType.GetPtr(), interface}] = result;
+  return result;
+}
@@ -6,6 +6,7 @@
 #include "stone/AST/Template.h"
 #include "stone/AST/Type.h"
 #include "stone/AST/TypeState.h"
+#include "stone/AST/Types.h"
 #include "stone/Basic/LLVM.h"
 #include "stone/Basic/LangOptions.h"
 #include "stone/Basic/SrcLoc.h"
@@ -42,7 +43,9 @@ void *Decl::AllocateMemory(AllocatorTy &allocatorTy, size_t baseSize,
   if (extraSace) {
     size += alignof(DeclTy);
   }
-  void *mem = allocatorTy.AllocateMemory(size, alignof(DeclTy));
+  void *mem = allocatorTy.AllocateMemory(size, alignof(DeclTy),
+                                         MemoryAllocationArena::Stoneanent,
+                                         ASTAllocationKind::Decl);
   if (extraSace)
     mem = reinterpret_cast<char *>(mem) + alignof(DeclTy);
   return mem;
@@ -147,8 +150,22 @@ TemplateContext::TemplateContext(DeclContextKind kind, DeclContext *parent,
   // }
 }
 
-// TODO: Set body  -- not being set now.
+TemplateTypeDecl::TemplateTypeDecl(DeclKind K, DeclContext *DC,
+                                   Identifier name, SrcLoc nameLoc, Type type,
+                                   TemplateParamList *genericParams)
+    : TemplateContext(DeclContextKind::TemplateTypeDecl, DC, genericParams),
+      TypeDecl(K, name, nameLoc, type, DC) {}
+
+RedeclChain *RedeclChain::Create(Decl *first, ASTContext &astContext) {
+  auto chain = new (astContext) RedeclChain(first);
+  astContext.AddCleanup([chain]() { chain->~RedeclChain(); });
+  return chain;
+}
+
+BraceStmt *FunctionDecl::GetBody(bool canSynthesize) const { return body; }
+
 void FunctionDecl::SetBody(BraceStmt *body, BodyStatus bodyStatus) {
+  this->body = body;
   SetBodyStatus(bodyStatus);
 }
 
@@ -192,14 +209,60 @@ FunDecl *FunDecl::Create(ASTContext &AC, SrcLoc staticLoc, SrcLoc funLoc,
 //   return nullptr;
 // }
 
-// StructDecl *StructDecl::Create(DeclName name, SrcLoc loc,
-//                                ASTContext &astContext, DeclContext *dc) {
+NominalType *NominalTypeDecl::GetDeclaredType() {
+  if (declaredType) {
+    return declaredType;
+  }
+  auto &astContext = Decl::GetASTContext();
+  switch (GetKind()) {
+  case DeclKind::Struct:
+    declaredType = new (astContext) StructType(this, astContext);
+    break;
+  case DeclKind::Class:
+    declaredType = new (astContext) ClassType(this, astContext);
+    break;
+  case DeclKind::Interface:
+    declaredType = new (astContext) InterfaceType(this, astContext);
+    break;
+  case DeclKind::Enum:
+    declaredType = new (astContext) EnumType(this, astContext);
+    break;
+  default:
+    llvm_unreachable("not a nominal type decl");
+  }
+  return declaredType;
+}
+
+StructDecl *StructDecl::Create(DeclName name, SrcLoc loc,
+                               ASTContext &astContext, DeclContext *parent) {
+  auto declPtr = Decl::AllocateMemory<StructDecl>(astContext,
+                                                  sizeof(StructDecl));
+  return ::new (declPtr)
+      StructDecl(name.GetDeclNameBaseIdentifier(), loc, parent);
+}
 
-//   size_t size = sizeof(StructDecl);
-//   auto declPtr = Decl::AllocateMemory<StructDecl>(astContext, size);
-//   // return ::new (declPtr) StructDecl(loc, GetASTContext(), dc);
-//   return nullptr;
-// }
+ClassDecl *ClassDecl::Create(DeclName name, SrcLoc loc, ASTContext &astContext,
+                             DeclContext *parent) {
+  auto declPtr = Decl::AllocateMemory<ClassDecl>(astContext, sizeof(ClassDecl));
+  return ::new (declPtr)
+      ClassDecl(name.GetDeclNameBaseIdentifier(), loc, parent);
+}
+
+InterfaceDecl *InterfaceDecl::Create(DeclName name, SrcLoc loc,
+                                     ASTContext &astContext,
+                                     DeclContext *parent) {
+  auto declPtr = Decl::AllocateMemory<InterfaceDecl>(astContext,
+                                                     sizeof(InterfaceDecl));
+  return ::new (declPtr)
+      InterfaceDecl(name.GetDeclNameBaseIdentifier(), loc, parent);
+}
+
+EnumDecl *EnumDecl::Create(DeclName name, SrcLoc loc, ASTContext &astContext,
+                           DeclContext *parent) {
+  auto declPtr = Decl::AllocateMemory<EnumDecl>(astContext, sizeof(EnumDecl));
+  return ::new (declPtr)
+      EnumDecl(name.GetDeclNameBaseIdentifier(), loc, parent);
+}
 
 ModuleDecl *ModuleDecl::Create(Identifier name, ASTContext &astContext) {
   size_t size = sizeof(ModuleDecl);
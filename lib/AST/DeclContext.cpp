@@ -16,6 +16,8 @@
 #include "llvm/Support/VersionTuple.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+
 using namespace stone;
 
 DeclContext::DeclContext(DeclContextKind declContextKind, DeclContext *parent)
@@ -26,6 +28,67 @@ DeclContext::DeclContext(DeclContextKind declContextKind, DeclContext *parent)
   }
 }
 
+void DeclContext::AddDecl(Decl *decl) {
+  assert(decl && decl->nextDecl.IsNull() && decl != lastDecl &&
+         "declaration is already in a context");
+  if (!firstDecl) {
+    firstDecl = decl;
+  } else {
+    lastDecl->nextDecl = decl;
+  }
+  lastDecl = decl;
+  AddDeclToChunks(decl);
+}
+
+void DeclContext::AddDeclToChunks(Decl *decl) {
+  auto &astContext = GetASTContext();
+  if (!declChunks) {
+    declChunks = new (astContext) DeclChunkList();
+    auto list = declChunks;
+    astContext.AddCleanup([list]() { list->~DeclChunkList(); });
+  }
+  declChunks->AddDecl(decl, astContext);
+}
+
+static bool IsBeforeKind(const DeclChunkList::KindChunks &entry,
+                         DeclKind kind) {
+  return entry.kind < kind;
+}
+
+void DeclChunkList::AddDecl(Decl *decl, ASTContext &astContext) {
+  auto kind = decl->GetKind();
+  auto entry = std::lower_bound(kinds.begin(), kinds.end(), kind, IsBeforeKind);
+  if (entry == kinds.end() || entry->kind != kind) {
+    entry = kinds.insert(entry, {kind, nullptr, nullptr});
+  }
+  auto chunk = entry->lastChunk;
+  if (!chunk || chunk->size == chunk->capacity) {
+    // Grow geometrically so that a kind with many members has few chunks.
+    unsigned capacity = chunk ? chunk->capacity * 2 : 4;
+    void *mem = astContext.AllocateMemory(
+        sizeof(Chunk) + capacity * sizeof(Decl *), alignof(Chunk));
+    auto newChunk = ::new (mem) Chunk(capacity);
+    if (chunk) {
+      chunk->next = newChunk;
+    } else {
+      entry->firstChunk = newChunk;
+    }
+    entry->lastChunk = chunk = newChunk;
+  }
+  chunk->GetDecls()[chunk->size++] = decl;
+}
+
+llvm::ArrayRef<DeclChunkList::KindChunks>
+DeclChunkList::GetKinds(DeclKind first, DeclKind last) const {
+  auto begin =
+      std::lower_bound(kinds.begin(), kinds.end(), first, IsBeforeKind);
+  auto end = begin;
+  while (end != kinds.end() && end->kind <= last) {
+    ++end;
+  }
+  return llvm::makeArrayRef(begin, end);
+}
+
 DeclContextKind DeclContext::GetDeclContextKind() const {
   return declContextKind;
 }
@@ -64,6 +127,13 @@ bool DeclContext::IsTypeContext() const {
   return false;
 }
 
+NominalTypeDecl *DeclContext::GetSelfNominalTypeDecl() const {
+  if (auto decl = const_cast<DeclContext *>(this)->ToDecl()) {
+    return dyn_cast<NominalTypeDecl>(decl);
+  }
+  return GetASTContext().GetJoinedType(this);
+}
+
 VisibilityScope::VisibilityScope(const DeclContext *DC, bool isPrivate)
     : val(DC, isPrivate) {
   // if (isPrivate) {
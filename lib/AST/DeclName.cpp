@@ -1,8 +1,76 @@
 #include "stone/AST/DeclName.h"
+#include "stone/AST/ASTContext.h"
 
 using namespace stone;
 
-int DeclName::Compare(DeclName other) { return 0; }
+void CompoundDeclName::Profile(llvm::FoldingSetNodeID &id,
+                               DeclNameBase nameBase, DeclNameKind kind,
+                               ArrayRef<Identifier> argumentNames) {
+  id.AddPointer(nameBase.GetAsOpaquePointer());
+  id.AddInteger(static_cast<unsigned>(kind));
+  id.AddInteger(argumentNames.size());
+  for (auto argumentName : argumentNames) {
+    id.AddPointer(argumentName.GetAsOpaquePointer());
+  }
+}
+
+DeclName
+DeclNameTable::GetCompoundName(DeclNameBase nameBase,
+                               llvm::ArrayRef<Identifier> argumentNames) {
+  return GetName(nameBase, DeclNameKind::Compound, argumentNames);
+}
+
+DeclName DeclNameTable::GetSpecialName(DeclNameKind kind,
+                                       DeclNameBase nameBase) {
+  assert(kind != DeclNameKind::Basic && kind != DeclNameKind::Compound &&
+         "not a special name kind");
+  return GetName(nameBase, kind, {});
+}
+
+DeclName DeclNameTable::GetName(DeclNameBase nameBase, DeclNameKind kind,
+                                llvm::ArrayRef<Identifier> argumentNames) {
+  llvm::FoldingSetNodeID id;
+  CompoundDeclName::Profile(id, nameBase, kind, argumentNames);
+
+  void *insertPos = nullptr;
+  if (auto compound = compoundNames.FindNodeOrInsertPos(id, insertPos)) {
+    return DeclName(compound);
+  }
+  auto bytes = CompoundDeclName::totalSizeToAlloc<Identifier>(
+      argumentNames.size());
+  auto memory = astContext.AllocateMemory(bytes, alignof(CompoundDeclName));
+  auto compound =
+      ::new (memory) CompoundDeclName(nameBase, kind, argumentNames.size());
+  std::uninitialized_copy(argumentNames.begin(), argumentNames.end(),
+                          compound->getArgumentNames().begin());
+  compoundNames.InsertNode(compound, insertPos);
+  return DeclName(compound);
+}
+
+int DeclName::Compare(DeclName other) const {
+  if (*this == other) {
+    return 0;
+  }
+  if (int result = GetDeclNameBase().GetIdentifier().Compare(
+          other.GetDeclNameBase().GetIdentifier())) {
+    return result;
+  }
+  auto argumentNames = GetArgumentNames();
+  auto otherArgumentNames = other.GetArgumentNames();
+  for (unsigned i = 0, n = std::min(argumentNames.size(),
+                                    otherArgumentNames.size());
+       i != n; ++i) {
+    if (int result = argumentNames[i].Compare(otherArgumentNames[i])) {
+      return result;
+    }
+  }
+  if (argumentNames.size() != otherArgumentNames.size()) {
+    return argumentNames.size() < otherArgumentNames.size() ? -1 : 1;
+  }
+  // Same text but a different kind, such as a basic name and a nullary
+  // compound name.
+  return static_cast<int>(GetKind()) - static_cast<int>(other.GetKind());
+}
 
 void DeclName::Print(ColorStream &os, const PrintingPolicy *policy) const {}
 
@@ -0,0 +1,88 @@
+#include "stone/AST/Evaluator.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/DiagnosticsSem.h"
+#include "stone/Support/Statistics.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace stone;
+
+llvm::StringRef stone::GetRequestKindName(RequestKind kind) {
+  switch (kind) {
+#define REQUEST(ID)                                                            \
+  case RequestKind::ID:                                                        \
+    return #ID "Request";
+#include "stone/AST/RequestKind.def"
+  }
+  llvm_unreachable("unknown request kind");
+}
+
+void Evaluator::RecordDependency(RequestKey key) {
+  if (activeRequests.empty()) {
+    return;
+  }
+  auto &asked = dependencies[activeRequests.back().key];
+  if (!llvm::is_contained(asked, key)) {
+    asked.push_back(key);
+  }
+}
+
+void Evaluator::NoteCacheHit(RequestKey key) {
+  ++counters[key.first].cacheHits;
+  if (auto stats = astContext.GetStats()) {
+    ++stats->getFrontendCounters().NumRequestCacheHits;
+  }
+}
+
+bool Evaluator::BeginRequest(RequestKey key, SrcLoc loc) {
+  if (activeKeys.insert(key).second) {
+    activeRequests.push_back({key, loc});
+    return true;
+  }
+  if (auto stats = astContext.GetStats()) {
+    ++stats->getFrontendCounters().NumRequestCycles;
+  }
+  auto name = [](RequestKey key) {
+    return GetRequestKindName(static_cast<RequestKind>(key.first));
+  };
+  auto &diags = astContext.GetDiags();
+  diags.diagnose(loc, diag::error_circular_reference, name(key));
+  // Note each request on the way from the first ask back to this one.
+  auto first = llvm::find_if(activeRequests, [&](const ActiveRequest &active) {
+    return active.key == key;
+  });
+  for (auto active = std::next(first); active != activeRequests.end();
+       ++active) {
+    diags.diagnose(active->loc, diag::note_circular_reference_through,
+                   name(active->key));
+  }
+  return false;
+}
+
+void Evaluator::EndRequest(RequestKey key, uint64_t nanos) {
+  assert(!activeRequests.empty() && activeRequests.back().key == key &&
+         "requests must end in the reverse order they began");
+  activeRequests.pop_back();
+  activeKeys.erase(key);
+
+  auto &requestCounters = counters[key.first];
+  ++requestCounters.evaluations;
+  requestCounters.nanos += nanos;
+  if (auto stats = astContext.GetStats()) {
+    ++stats->getFrontendCounters().NumRequestsEvaluated;
+  }
+}
+
+void Evaluator::PrintCounters(llvm::raw_ostream &os) const {
+  for (unsigned kind = 0; kind != NumRequestKinds; ++kind) {
+    auto &requestCounters = counters[kind];
+    if (!requestCounters.evaluations && !requestCounters.cacheHits) {
+      continue;
+    }
+    os << GetRequestKindName(static_cast<RequestKind>(kind)) << ": "
+       << requestCounters.evaluations << " evaluated, "
+       << requestCounters.cacheHits << " cached, "
+       << requestCounters.nanos / 1000 << " us\n";
+  }
+}
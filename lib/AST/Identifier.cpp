@@ -23,8 +23,25 @@ Identifier ASTContext::GetIdentifier(llvm::StringRef identifierText) const {
   if ((identifierText.data() != nullptr) && !identifierText.empty() &&
       identifierText.size() > 0) {
     auto pair = std::make_pair(identifierText, Identifier::Aligner());
-    auto first = identifierTable.insert(pair).first;
-    return Identifier(first->getKeyData());
+    auto result = identifierTable.insert(pair);
+    if (result.second && stats) {
+      RecordAllocation(sizeof(IdentifierTable::MapEntryTy) +
+                           identifierText.size() + 1,
+                       MemoryAllocationArena::Stoneanent,
+                       ASTAllocationKind::Identifier);
+    }
+    return Identifier(result.first->getKeyData());
   }
   return Identifier(nullptr);
 }
+
+int Identifier::Compare(Identifier other) const {
+  // Handle empty identifiers.
+  if (IsEmpty() || other.IsEmpty()) {
+    if (IsEmpty() != other.IsEmpty()) {
+      return IsEmpty() ? 1 : -1;
+    }
+    return 0;
+  }
+  return GetString().compare(other.GetString());
+}
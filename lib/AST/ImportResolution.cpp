@@ -0,0 +1,148 @@
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/ImportCache.h"
+#include "stone/AST/Module.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+
+using namespace stone;
+
+ImportSet::ImportSet(llvm::ArrayRef<ImportedModule> topLevelImports,
+                     llvm::ArrayRef<ImportedModule> transitiveImports)
+    : numTopLevelImports(topLevelImports.size()),
+      numTransitiveImports(transitiveImports.size()) {
+  auto buffer = getTrailingObjects<ImportedModule>();
+  std::uninitialized_copy(topLevelImports.begin(), topLevelImports.end(),
+                          buffer);
+  std::uninitialized_copy(transitiveImports.begin(), transitiveImports.end(),
+                          buffer + numTopLevelImports);
+}
+
+bool ImportSet::Contains(const ModuleDecl *module) const {
+  for (auto &import : GetAllImports()) {
+    if (import.importedModule == module) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ImportSet::Profile(llvm::FoldingSetNodeID &id,
+                        llvm::ArrayRef<ImportedModule> topLevelImports) {
+  id.AddInteger(topLevelImports.size());
+  for (auto &import : topLevelImports) {
+    id.AddPointer(import.importedModule);
+    id.AddInteger(import.accessPath.size());
+    for (auto identifier : import.accessPath) {
+      id.AddPointer(identifier.GetAsOpaquePointer());
+    }
+  }
+}
+
+ImportSet &
+ImportCache::GetImportSet(const ASTContext &astContext,
+                          llvm::ArrayRef<ImportedModule> topLevelImports) {
+  llvm::FoldingSetNodeID id;
+  ImportSet::Profile(id, topLevelImports);
+
+  void *insertPos = nullptr;
+  if (auto found = importSets.FindNodeOrInsertPos(id, insertPos)) {
+    return *found;
+  }
+
+  // Walk the imports of the imported modules. A scoped import only limits
+  // the decls of its own module, so the modules behind it are reached through
+  // their own imports.
+  llvm::SmallVector<ImportedModule, 16> transitiveImports;
+  llvm::SmallDenseSet<ImportedModule, 16> visited;
+  llvm::SmallVector<ModuleDecl *, 16> worklist;
+  for (auto &import : topLevelImports) {
+    visited.insert(import);
+    worklist.push_back(import.importedModule);
+  }
+  while (!worklist.empty()) {
+    auto module = worklist.pop_back_val();
+    for (auto &import : module->GetImports()) {
+      if (visited.insert(import).second) {
+        transitiveImports.push_back(import);
+        worklist.push_back(import.importedModule);
+      }
+    }
+  }
+
+  // The set outlives the caller's imports, so it owns its access paths. The
+  // transitive ones were already copied by ModuleDecl::AddImport.
+  llvm::SmallVector<ImportedModule, 4> ownedTopLevelImports;
+  for (auto import : topLevelImports) {
+    import.accessPath = astContext.AllocateCopy(import.accessPath);
+    ownedTopLevelImports.push_back(import);
+  }
+
+  auto bytes = ImportSet::totalSizeToAlloc<ImportedModule>(
+      topLevelImports.size() + transitiveImports.size());
+  auto memory = astContext.AllocateMemory(bytes, alignof(ImportSet));
+  auto result =
+      ::new (memory) ImportSet(ownedTopLevelImports, transitiveImports);
+  importSets.InsertNode(result, insertPos);
+  return *result;
+}
+
+ImportSet &ImportCache::GetImportSet(const ASTContext &astContext,
+                                     ImportedModule import) {
+  auto found = importSetForImport.find(import);
+  if (found != importSetForImport.end()) {
+    return *found->second;
+  }
+  auto &result = GetImportSet(astContext, llvm::ArrayRef(import));
+  // Key on the set's own copy of the import, not the caller's access path.
+  importSetForImport[result.GetTopLevelImports().front()] = &result;
+  return result;
+}
+
+ImportSet &ImportCache::GetImportSet(const ModuleDecl *module) {
+  auto found = importSetForModule.find(module);
+  if (found != importSetForModule.end()) {
+    return *found->second;
+  }
+  auto &result = GetImportSet(module->GetASTContext(), module->GetImports());
+  importSetForModule[module] = &result;
+  return result;
+}
+
+void ImportCache::InvalidateImportSets() {
+  importSets.clear();
+  importSetForImport.clear();
+  importSetForModule.clear();
+}
+
+bool ImportCache::IsImportedBy(const ModuleDecl *imported,
+                               const ModuleDecl *importer) {
+  if (imported == importer) {
+    return true;
+  }
+  return GetImportSet(importer).Contains(imported);
+}
+
+bool ImportCache::IsVisible(Decl *decl, const ModuleDecl *importer) {
+  auto declModule = decl->GetDeclContext()->GetParentModule();
+  if (declModule == importer) {
+    return true;
+  }
+  auto &importSet = GetImportSet(importer);
+  for (auto &import : importSet.GetTopLevelImports()) {
+    if (import.importedModule != declModule) {
+      continue;
+    }
+    if (!import.IsScoped() ||
+        import.accessPath.back() == decl->GetBasicName()) {
+      return true;
+    }
+  }
+  for (auto &import : importSet.GetTransitiveImports()) {
+    if (import.importedModule == declModule && !import.IsScoped()) {
+      return true;
+    }
+  }
+  return false;
+}
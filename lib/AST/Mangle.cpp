@@ -0,0 +1,374 @@
+#include "stone/AST/Mangle.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/Types.h"
+#include "stone/Support/Statistics.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace stone;
+
+namespace {
+/// Writes one Itanium mangled name. The substitution table only lives as
+/// long as the name: back references never point into another symbol.
+class ItaniumMangler final {
+  llvm::raw_svector_ostream os;
+
+  /// The substitution candidates seen so far: prefix decls and canonical
+  /// types, numbered in the order they were mangled.
+  llvm::DenseMap<const void *, unsigned> substitutions;
+
+public:
+  explicit ItaniumMangler(llvm::SmallVectorImpl<char> &out) : os(out) {}
+
+public:
+  void MangleName(ValueDecl *decl);
+  void MangleType(Type type);
+
+private:
+  void MangleEncoding(FunctionDecl *fn);
+  void MangleEntityName(Decl *decl);
+  void ManglePrefix(Decl *decl);
+  void MangleUnqualifiedName(Decl *decl);
+  void MangleSourceName(llvm::StringRef name);
+  void MangleBuiltinType(TypeKind kind);
+
+  /// Emit a back reference to \p key if it was mangled before.
+  bool MangleSubstitution(const void *key);
+  void AddSubstitution(const void *key) {
+    substitutions.try_emplace(key, substitutions.size());
+  }
+};
+} // namespace
+
+/// \return the innermost decl that encloses \p dc, looking through files.
+static Decl *GetContextDecl(DeclContext *dc) {
+  for (; dc; dc = dc->GetParent()) {
+    if (auto decl = dc->ToDecl()) {
+      return decl;
+    }
+  }
+  return nullptr;
+}
+
+/// \return \p decl if it is a function, or else the innermost function that
+/// encloses it.
+static FunctionDecl *GetEnclosingFunction(Decl *decl) {
+  for (; decl && !llvm::isa<ModuleDecl>(decl);
+       decl = GetContextDecl(decl->GetDeclContext())) {
+    if (auto fn = llvm::dyn_cast<FunctionDecl>(decl)) {
+      return fn;
+    }
+  }
+  return nullptr;
+}
+
+void ItaniumMangler::MangleName(ValueDecl *decl) {
+  os << "_Z";
+  if (auto fn = llvm::dyn_cast<FunctionDecl>(decl)) {
+    MangleEncoding(fn);
+    return;
+  }
+  MangleEntityName(decl);
+}
+
+void ItaniumMangler::MangleEncoding(FunctionDecl *fn) {
+  MangleEntityName(fn);
+  // Only the parameters are part of the encoding; the return type is not.
+  auto type = fn->GetType();
+  auto funType =
+      type ? llvm::dyn_cast<FunType>(type->GetCanType().GetPtr()) : nullptr;
+  if (!funType || funType->GetParamTypes().empty()) {
+    os << 'v';
+    return;
+  }
+  for (auto paramType : funType->GetParamTypes()) {
+    MangleType(paramType);
+  }
+}
+
+void ItaniumMangler::MangleEntityName(Decl *decl) {
+  auto contextDecl = GetContextDecl(decl->GetDeclContext());
+  if (!contextDecl || llvm::isa<ModuleDecl>(decl)) {
+    MangleUnqualifiedName(decl);
+    return;
+  }
+  // An entity local to a function is named within the function, so that
+  // types with the same name in two functions do not collide.
+  if (auto fn = GetEnclosingFunction(contextDecl)) {
+    os << 'Z';
+    MangleEncoding(fn);
+    os << 'E';
+    if (contextDecl == fn) {
+      MangleUnqualifiedName(decl);
+      return;
+    }
+  }
+  os << 'N';
+  ManglePrefix(contextDecl);
+  MangleUnqualifiedName(decl);
+  os << 'E';
+}
+
+void ItaniumMangler::ManglePrefix(Decl *decl) {
+  if (MangleSubstitution(decl)) {
+    return;
+  }
+  // The prefix stops at a function; MangleEntityName already named it.
+  if (!llvm::isa<ModuleDecl>(decl)) {
+    auto contextDecl = GetContextDecl(decl->GetDeclContext());
+    if (contextDecl && !llvm::isa<FunctionDecl>(contextDecl)) {
+      ManglePrefix(contextDecl);
+    }
+  }
+  MangleUnqualifiedName(decl);
+  AddSubstitution(decl);
+}
+
+void ItaniumMangler::MangleUnqualifiedName(Decl *decl) {
+  switch (decl->GetKind()) {
+  case DeclKind::Constructor:
+    os << "C1";
+    return;
+  case DeclKind::Destructor:
+    os << "D1";
+    return;
+  case DeclKind::Module:
+    MangleSourceName(llvm::cast<ModuleDecl>(decl)->GetABIName().GetString());
+    return;
+  default:
+    MangleSourceName(decl->GetBasicNameText());
+    return;
+  }
+}
+
+void ItaniumMangler::MangleSourceName(llvm::StringRef name) {
+  os << name.size() << name;
+}
+
+bool ItaniumMangler::MangleSubstitution(const void *key) {
+  auto found = substitutions.find(key);
+  if (found == substitutions.end()) {
+    return false;
+  }
+  // S_ is the first candidate; then S0_, S1_, ... with base-36 numbers.
+  os << 'S';
+  if (unsigned seqID = found->second) {
+    char digits[8];
+    unsigned numDigits = 0;
+    for (--seqID; seqID || numDigits == 0; seqID /= 36) {
+      unsigned digit = seqID % 36;
+      digits[numDigits++] = digit < 10 ? '0' + digit : 'A' + (digit - 10);
+    }
+    while (numDigits) {
+      os << digits[--numDigits];
+    }
+  }
+  os << '_';
+  return true;
+}
+
+void ItaniumMangler::MangleType(Type type) {
+  if (!type) {
+    os << 'v';
+    return;
+  }
+  auto ty = type->GetCanType().GetPtr();
+  if (llvm::isa<BuiltinType>(ty)) {
+    MangleBuiltinType(ty->GetKind());
+    return;
+  }
+  // A nominal type and the prefix that names it are the same candidate.
+  if (auto nominalType = llvm::dyn_cast<NominalType>(ty)) {
+    auto decl = nominalType->GetDecl();
+    assert(decl && "nominal type without a decl");
+    if (MangleSubstitution(decl)) {
+      return;
+    }
+    MangleEntityName(decl);
+    AddSubstitution(decl);
+    return;
+  }
+  if (MangleSubstitution(ty)) {
+    return;
+  }
+  switch (ty->GetKind()) {
+  case TypeKind::Raw:
+    os << 'P';
+    MangleType(llvm::cast<PointerType>(ty)->GetPointeeType());
+    break;
+  case TypeKind::Move:
+    os << "U4move";
+    MangleType(llvm::cast<PointerType>(ty)->GetPointeeType());
+    break;
+  case TypeKind::Ref:
+    os << 'R';
+    MangleType(llvm::cast<ReferenceType>(ty)->GetReferentType());
+    break;
+  case TypeKind::Qualified: {
+    auto qualifiedType = llvm::cast<QualifiedType>(ty);
+    auto quals = qualifiedType->GetQualSpecs();
+    if (quals.HasRestrict()) {
+      os << 'r';
+    }
+    if (quals.HasVolatile()) {
+      os << 'V';
+    }
+    if (quals.HasConst()) {
+      os << 'K';
+    }
+    MangleType(qualifiedType->GetBaseType());
+    break;
+  }
+  case TypeKind::Fun: {
+    auto funType = llvm::cast<FunType>(ty);
+    os << 'F';
+    MangleType(funType->GetReturnType());
+    if (funType->GetParamTypes().empty()) {
+      os << 'v';
+    }
+    for (auto paramType : funType->GetParamTypes()) {
+      MangleType(paramType);
+    }
+    os << 'E';
+    break;
+  }
+  case TypeKind::Auto:
+    os << "Da";
+    break;
+  default:
+    llvm_unreachable("type cannot be mangled");
+  }
+  AddSubstitution(ty);
+}
+
+void ItaniumMangler::MangleBuiltinType(TypeKind kind) {
+  switch (kind) {
+  case TypeKind::Void:
+    os << 'v';
+    return;
+  case TypeKind::Bool:
+    os << 'b';
+    return;
+  case TypeKind::Char:
+    os << 'c';
+    return;
+  case TypeKind::Char8:
+    os << "Du";
+    return;
+  case TypeKind::Char16:
+    os << "Ds";
+    return;
+  case TypeKind::Char32:
+    os << "Di";
+    return;
+  case TypeKind::Int:
+    os << 'l';
+    return;
+  case TypeKind::Int8:
+    os << 'a';
+    return;
+  case TypeKind::Int16:
+    os << 's';
+    return;
+  case TypeKind::Int32:
+    os << 'i';
+    return;
+  case TypeKind::Int64:
+    os << 'x';
+    return;
+  case TypeKind::Int128:
+    os << 'n';
+    return;
+  case TypeKind::UInt:
+    os << 'm';
+    return;
+  case TypeKind::UInt8:
+    os << 'h';
+    return;
+  case TypeKind::UInt16:
+    os << 't';
+    return;
+  case TypeKind::UInt32:
+    os << 'j';
+    return;
+  case TypeKind::UInt64:
+    os << 'y';
+    return;
+  case TypeKind::UInt128:
+    os << 'o';
+    return;
+  case TypeKind::Float:
+  case TypeKind::Float64:
+    os << 'd';
+    return;
+  case TypeKind::Float16:
+    os << "DF16_";
+    return;
+  case TypeKind::Float32:
+    os << 'f';
+    return;
+  case TypeKind::Float128:
+    os << 'g';
+    return;
+  case TypeKind::Complex32:
+    os << "Cf";
+    return;
+  case TypeKind::Complex64:
+    os << "Cd";
+    return;
+  case TypeKind::Imaginary32:
+    os << "Gf";
+    return;
+  case TypeKind::Imaginary64:
+    os << "Gd";
+    return;
+  case TypeKind::Null:
+    os << "Dn";
+    return;
+  case TypeKind::String:
+    os << "u6string";
+    return;
+  default:
+    llvm_unreachable("not a builtin type");
+  }
+}
+
+void ItaniumMangleContext::MangleName(ValueDecl *decl,
+                                      llvm::SmallVectorImpl<char> &out) {
+  // The entry point keeps its C name.
+  if (auto fun = llvm::dyn_cast<FunDecl>(decl)) {
+    if (fun->IsMain()) {
+      out.append({'m', 'a', 'i', 'n'});
+      return;
+    }
+  }
+  ItaniumMangler(out).MangleName(decl);
+}
+
+void ItaniumMangleContext::MangleTypeName(Type T,
+                                          llvm::SmallVectorImpl<char> &out) {
+  out.append({'_', 'Z', 'T', 'S'});
+  ItaniumMangler(out).MangleType(T);
+}
+
+llvm::StringRef ASTContext::GetMangledName(ValueDecl *decl) const {
+  auto found = mangledNames.find(decl);
+  if (found != mangledNames.end()) {
+    if (stats) {
+      ++stats->getFrontendCounters().NumMangledNameCacheHits;
+    }
+    return found->second;
+  }
+  if (stats) {
+    ++stats->getFrontendCounters().NumMangledNameCacheMisses;
+  }
+  llvm::SmallString<128> buffer;
+  ItaniumMangleContext(const_cast<ASTContext &>(*this))
+      .MangleName(decl, buffer);
+  auto name = AllocateCopy(buffer.str());
+  mangledNames[decl] = name;
+  return name;
+}
@@ -0,0 +1,30 @@
+#include "stone/AST/MemberTable.h"
+#include "stone/AST/Decl.h"
+
+using namespace stone;
+
+void MemberTable::AddMember(Decl *member) {
+  auto valueDecl = llvm::dyn_cast<ValueDecl>(member);
+  if (!valueDecl) {
+    return;
+  }
+  auto name = valueDecl->GetName().GetDeclNameBase();
+  if (!name.IsValid()) {
+    return;
+  }
+  entries[name].push_back(valueDecl);
+}
+
+void MemberTable::AddMembers(Decl *firstMember) {
+  for (auto member = firstMember; member; member = member->GetNextDecl()) {
+    AddMember(member);
+  }
+}
+
+llvm::ArrayRef<ValueDecl *> MemberTable::Find(DeclNameBase name) const {
+  auto found = entries.find(name);
+  if (found == entries.end()) {
+    return {};
+  }
+  return found->second;
+}
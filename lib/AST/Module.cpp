@@ -1,5 +1,7 @@
 #include "stone/AST/Module.h"
 #include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/SerializedModule.h"
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
@@ -51,12 +53,55 @@ void ModuleDecl::AddFile(ModuleFile &file) {
   // TODO: ClearLookupCache();
 }
 
+void ModuleDecl::AddImport(ImportedModule import) {
+  assert(import.importedModule && import.importedModule != this &&
+         "invalid import");
+  import.accessPath = GetASTContext().AllocateCopy(import.accessPath);
+  imports.push_back(import);
+  GetASTContext().GetImportCache().InvalidateImportSets();
+}
+
+void ModuleDecl::LookupValue(DeclNameBase name,
+                             llvm::SmallVectorImpl<ValueDecl *> &results) {
+  for (auto file : GetFiles()) {
+    if (auto sourceFile = llvm::dyn_cast<SourceFile>(file)) {
+      for (auto decl : sourceFile->GetTopLevelDecls()) {
+        auto valueDecl = llvm::dyn_cast<ValueDecl>(decl);
+        if (valueDecl && valueDecl->GetName().GetDeclNameBase() == name) {
+          results.push_back(valueDecl);
+        }
+      }
+    } else if (auto serializedFile =
+                   llvm::dyn_cast<SerializedModuleFile>(file)) {
+      serializedFile->LookupValue(name, results);
+    }
+  }
+}
+
+Identifier ModuleDecl::GetABIName() const {
+  if (moduleABIName.IsEmpty()) {
+    moduleABIName = GetBasicName();
+  }
+  return moduleABIName;
+}
+
 Identifier ModuleDecl::GetRealName() const {
   // This will return the real name for an alias (if used) or getName()
   return GetASTContext().GetRealModuleName(GetBasicName());
 }
 
-bool ModuleDecl::Walk(ASTWalker &waker) {}
+bool ModuleDecl::Walk(ASTWalker &walker) {
+  for (auto file : GetFiles()) {
+    if (auto sourceFile = llvm::dyn_cast<SourceFile>(file)) {
+      for (auto decl : sourceFile->GetTopLevelDecls()) {
+        if (decl->Walk(walker)) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
 
 bool DeclContext::IsModuleContext() const {
   if (auto D = ToDecl()) {
@@ -114,15 +159,29 @@ SourceFile::ParsingOptions
 SourceFile::GetDefaultParsingOptions(const LangOptions &langOpts) {
 
   ParsingOptions parsingOptions;
-  // if (langOpts.DisablePoundIfEvaluation)
-  //   opts |= ParsingFlags::DisablePoundIfEvaluation;
-  // if (langOpts.BuildSyntaxTree)
-  //   opts |= ParsingFlags::BuildSyntaxTree;
-  // if (langOpts.CollectParsedToken)
-  //   opts |= ParsingFlags::CollectParsedTokens;
+  if (langOpts.DisablePoundIfEvaluation) {
+    parsingOptions |= ParsingFlags::DisablePoundIfEvaluation;
+  }
+  if (langOpts.BuildSyntaxTree) {
+    parsingOptions |= ParsingFlags::BuildSyntaxTree;
+  }
+  if (langOpts.CollectParsedTokens) {
+    parsingOptions |= ParsingFlags::CollectParsedTokens;
+  }
   return parsingOptions;
 }
 
+void SourceFile::SetParsingOptions(ParsingOptions opts) {
+  parsingOpts = opts;
+  if (opts.contains(ParsingFlags::CollectParsedTokens)) {
+    if (!parsedTokens) {
+      parsedTokens.emplace();
+    }
+  } else {
+    parsedTokens.reset();
+  }
+}
+
 llvm::StringRef SourceFile::GetFilename() const {
   if (srcID == -1) {
     return llvm::StringRef();
@@ -143,6 +202,18 @@ SourceFile *SourceFile::CreatePrimarySourceFile(SourceFileKind kind,
   return new (astContext) SourceFile(kind, owner, srcID, true);
 }
 
+void SourceFile::AddTopLevelDecl(Decl *d) {
+  topLevelDecls.push_back(d);
+  AddDeclToChunks(d);
+  if (auto functionDecl = llvm::dyn_cast<FunctionDecl>(d)) {
+    auto &latest = latestFunctionDecls[functionDecl->GetName()];
+    if (latest) {
+      functionDecl->SetPreviousRedecl(latest, GetASTContext());
+    }
+    latest = functionDecl;
+  }
+}
+
 llvm::ArrayRef<Decl *> SourceFile::GetTopLevelDecls() const {
   return topLevelDecls;
 }
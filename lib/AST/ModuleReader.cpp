@@ -0,0 +1,331 @@
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/DiagnosticsBasic.h"
+#include "stone/AST/SerializedModule.h"
+#include "stone/AST/Types.h"
+
+#include "llvm/ADT/STLExtras.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace stone;
+using namespace stone::serialization;
+
+static bool IsInBounds(size_t bufferSize, uint64_t offset, uint64_t size) {
+  return offset % alignof(Offset) == 0 && offset <= bufferSize &&
+         size <= bufferSize - offset;
+}
+
+bool SerializedModuleFile::Validate(llvm::MemoryBufferRef buffer,
+                                    llvm::StringRef &moduleName,
+                                    std::string &error) {
+  auto size = buffer.getBufferSize();
+  auto data = buffer.getBufferStart();
+  if (size < sizeof(ModuleFileHeader) ||
+      std::memcmp(data, ModuleSignature, sizeof(ModuleSignature)) != 0) {
+    error = "not a module file";
+    return false;
+  }
+  auto &header = *reinterpret_cast<const ModuleFileHeader *>(data);
+  if (header.versionMajor != ModuleVersionMajor) {
+    error = "unsupported format version";
+    return false;
+  }
+  if (!IsInBounds(size, header.identifiersOffset,
+                  uint64_t(header.numIdentifiers) * sizeof(IdentifierEntry)) ||
+      !IsInBounds(size, header.typesOffset,
+                  uint64_t(header.numTypes) * sizeof(Offset)) ||
+      !IsInBounds(size, header.declsOffset,
+                  uint64_t(header.numDecls) * sizeof(Offset)) ||
+      !IsInBounds(size, header.nameIndexOffset,
+                  uint64_t(header.numNameIndexEntries) *
+                      sizeof(NameIndexEntry))) {
+    error = "table out of bounds";
+    return false;
+  }
+  // Check the identifier table up front; everything else is checked when it
+  // is read.
+  auto entries = reinterpret_cast<const IdentifierEntry *>(
+      data + header.identifiersOffset);
+  for (auto &entry : llvm::makeArrayRef(entries, header.numIdentifiers)) {
+    if (entry.textOffset > size || entry.length > size - entry.textOffset) {
+      error = "identifier out of bounds";
+      return false;
+    }
+  }
+  auto nameID = header.moduleNameID;
+  if (nameID == 0 || nameID > header.numIdentifiers) {
+    error = "missing module name";
+    return false;
+  }
+  auto &nameEntry = entries[nameID - 1];
+  moduleName = llvm::StringRef(data + nameEntry.textOffset, nameEntry.length);
+  return true;
+}
+
+SerializedModuleFile::SerializedModuleFile(
+    ModuleDecl &owner, std::unique_ptr<llvm::MemoryBuffer> buffer)
+    : ModuleFile(ModuleFileKind::Serialized, owner), buffer(std::move(buffer)) {
+}
+
+SerializedModuleFile *
+SerializedModuleFile::Create(ModuleDecl &owner,
+                             std::unique_ptr<llvm::MemoryBuffer> buffer) {
+  return new (owner.GetASTContext())
+      SerializedModuleFile(owner, std::move(buffer));
+}
+
+const ModuleFileHeader &SerializedModuleFile::GetHeader() const {
+  return *reinterpret_cast<const ModuleFileHeader *>(
+      buffer->getBufferStart());
+}
+
+const llvm::support::ulittle32_t *
+SerializedModuleFile::GetWords(uint32_t offset, uint32_t count) const {
+  if (!IsInBounds(buffer->getBufferSize(), offset,
+                  uint64_t(count) * sizeof(Offset))) {
+    return nullptr;
+  }
+  return reinterpret_cast<const llvm::support::ulittle32_t *>(
+      buffer->getBufferStart() + offset);
+}
+
+llvm::StringRef
+SerializedModuleFile::GetIdentifierText(IdentifierID id) const {
+  auto &header = GetHeader();
+  if (id == 0 || id > header.numIdentifiers) {
+    return llvm::StringRef();
+  }
+  auto &entry = reinterpret_cast<const IdentifierEntry *>(
+      buffer->getBufferStart() + header.identifiersOffset)[id - 1];
+  return llvm::StringRef(buffer->getBufferStart() + entry.textOffset,
+                         entry.length);
+}
+
+Identifier SerializedModuleFile::GetIdentifier(IdentifierID id) {
+  auto &header = GetHeader();
+  if (id == 0 || id > header.numIdentifiers) {
+    return Identifier();
+  }
+  if (identifiers.empty()) {
+    identifiers.resize(header.numIdentifiers);
+  }
+  auto &identifier = identifiers[id - 1];
+  if (identifier.IsEmpty()) {
+    identifier = GetASTContext().GetIdentifier(GetIdentifierText(id));
+  }
+  return identifier;
+}
+
+TypeBase *SerializedModuleFile::GetType(TypeID id) {
+  auto &header = GetHeader();
+  if (id == 0 || id > header.numTypes) {
+    return nullptr;
+  }
+  if (types.empty()) {
+    types.resize(header.numTypes);
+  }
+  if (types[id - 1]) {
+    return types[id - 1];
+  }
+
+  auto offsets = GetWords(header.typesOffset, header.numTypes);
+  auto record = GetWords(offsets[id - 1], 1);
+  if (!record) {
+    return nullptr;
+  }
+  auto code = TypeCode(record[0] & 0xFF);
+  auto kind = TypeKind((record[0] >> 8) & 0xFF);
+
+  // Operands always name types that were written earlier, so a record that
+  // refers to itself or later is malformed.
+  auto getOperandType = [&](uint32_t operandID) -> Type {
+    if (operandID >= id) {
+      return Type();
+    }
+    return Type(GetType(operandID));
+  };
+
+  auto &astContext = GetASTContext();
+  Type result;
+  switch (code) {
+  case TypeCode::Builtin:
+    result = astContext.GetBuiltin().GetType(kind);
+    break;
+  case TypeCode::Fun: {
+    record = GetWords(offsets[id - 1], 3);
+    if (!record) {
+      return nullptr;
+    }
+    auto returnType = getOperandType(record[1]);
+    unsigned numParams = record[2];
+    record = GetWords(offsets[id - 1], 3 + numParams);
+    if (!returnType || !record) {
+      return nullptr;
+    }
+    llvm::SmallVector<Type, 4> paramTypes;
+    for (unsigned i = 0; i != numParams; ++i) {
+      auto paramType = getOperandType(record[3 + i]);
+      if (!paramType) {
+        return nullptr;
+      }
+      paramTypes.push_back(paramType);
+    }
+    result = astContext.GetFunType(returnType, paramTypes);
+    break;
+  }
+  case TypeCode::Pointer: {
+    record = GetWords(offsets[id - 1], 2);
+    if (!record) {
+      return nullptr;
+    }
+    auto pointeeType = getOperandType(record[1]);
+    if (!pointeeType) {
+      return nullptr;
+    }
+    switch (kind) {
+    case TypeKind::Raw:
+      result = astContext.GetRawType(pointeeType);
+      break;
+    case TypeKind::Move:
+      result = astContext.GetMoveType(pointeeType);
+      break;
+    case TypeKind::Ref:
+      result = astContext.GetRefType(pointeeType);
+      break;
+    default:
+      return nullptr;
+    }
+    break;
+  }
+  case TypeCode::Qualified: {
+    record = GetWords(offsets[id - 1], 3);
+    if (!record) {
+      return nullptr;
+    }
+    auto baseType = getOperandType(record[1]);
+    if (!baseType) {
+      return nullptr;
+    }
+    result = astContext.GetQualifiedType(
+        baseType, QualSpecs::GetFromOpaqueValue(record[2]));
+    break;
+  }
+  }
+  if (!result) {
+    return nullptr;
+  }
+  if (auto stats = astContext.GetStats()) {
+    ++stats->getFrontendCounters().NumTypesDeserialized;
+  }
+  types[id - 1] = result.GetPtr();
+  return result.GetPtr();
+}
+
+ValueDecl *SerializedModuleFile::GetDecl(DeclID id) {
+  auto &header = GetHeader();
+  if (id == 0 || id > header.numDecls) {
+    return nullptr;
+  }
+  if (decls.empty()) {
+    decls.resize(header.numDecls);
+  }
+  if (decls[id - 1]) {
+    return decls[id - 1];
+  }
+
+  auto offsets = GetWords(header.declsOffset, header.numDecls);
+  auto record = GetWords(offsets[id - 1], 3);
+  if (!record) {
+    return nullptr;
+  }
+  auto code = DeclCode(record[0] & 0xFF);
+  unsigned visibilityValue = (record[0] >> 8) & 0xFF;
+  // File is the last visibility level.
+  if (visibilityValue > static_cast<unsigned>(VisibilityLevel::File)) {
+    return nullptr;
+  }
+  auto visibility = VisibilityLevel(visibilityValue);
+  auto name = GetIdentifier(record[1]);
+  if (name.IsEmpty()) {
+    return nullptr;
+  }
+  TypeBase *type = nullptr;
+  if (record[2]) {
+    type = GetType(record[2]);
+    if (!type) {
+      return nullptr;
+    }
+  }
+
+  auto &astContext = GetASTContext();
+  ValueDecl *decl = nullptr;
+  switch (code) {
+  case DeclCode::Fun:
+    decl = FunDecl::Create(astContext, SrcLoc(), SrcLoc(), DeclName(name),
+                           SrcLoc(), Type(type), this);
+    break;
+  }
+  if (!decl) {
+    return nullptr;
+  }
+  decl->OverwriteVisibility(visibility);
+
+  if (auto stats = astContext.GetStats()) {
+    ++stats->getFrontendCounters().NumDeclsDeserialized;
+  }
+  ++numDeclsLoaded;
+  decls[id - 1] = decl;
+  return decl;
+}
+
+void SerializedModuleFile::LookupValue(
+    DeclNameBase name, llvm::SmallVectorImpl<ValueDecl *> &results) {
+  if (!name.IsValid()) {
+    return;
+  }
+  auto text = name.GetIdentifier().GetString();
+  auto &header = GetHeader();
+  auto entries = llvm::makeArrayRef(
+      reinterpret_cast<const NameIndexEntry *>(buffer->getBufferStart() +
+                                               header.nameIndexOffset),
+      header.numNameIndexEntries);
+
+  // The index is sorted by text, so the entries for a name are contiguous and
+  // can be found without materializing any other identifier.
+  auto first = std::partition_point(
+      entries.begin(), entries.end(), [&](const NameIndexEntry &entry) {
+        return GetIdentifierText(entry.nameID) < text;
+      });
+  for (auto entry = first;
+       entry != entries.end() && GetIdentifierText(entry->nameID) == text;
+       ++entry) {
+    if (auto decl = GetDecl(entry->declID)) {
+      results.push_back(decl);
+    }
+  }
+}
+
+ModuleDecl *ASTContext::LoadSerializedModule(llvm::StringRef path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer) {
+    GetDiags().diagnose(SrcLoc(), diag::error_open_input_file, path,
+                        buffer.getError().message());
+    return nullptr;
+  }
+  llvm::StringRef moduleName;
+  std::string error;
+  if (!SerializedModuleFile::Validate(**buffer, moduleName, error)) {
+    GetDiags().diagnose(SrcLoc(), diag::error_malformed_module_file, path,
+                        error);
+    return nullptr;
+  }
+  auto module = ModuleDecl::Create(GetIdentifier(moduleName), *this);
+  auto file = SerializedModuleFile::Create(*module, std::move(*buffer));
+  module->AddFile(*file);
+  AddCleanup([file]() { file->~SerializedModuleFile(); });
+  AddLoadedModule(module);
+  return module;
+}
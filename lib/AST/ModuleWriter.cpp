@@ -0,0 +1,253 @@
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/SerializedModule.h"
+#include "stone/AST/Types.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace stone;
+using namespace stone::serialization;
+
+namespace {
+/// Assigns IDs to the identifiers, types and decls of a module, encodes
+/// their records, and lays the tables out.
+class ModuleWriter final {
+  ModuleDecl &module;
+
+  llvm::DenseMap<Identifier, IdentifierID> identifierIDs;
+  std::vector<Identifier> identifiers;
+
+  llvm::DenseMap<TypeBase *, TypeID> typeIDs;
+  /// The encoded record of each type, indexed by ID - 1.
+  std::vector<std::vector<uint32_t>> typeRecords;
+
+  std::vector<std::vector<uint32_t>> declRecords;
+  std::vector<NameIndexEntry> nameIndex;
+
+public:
+  explicit ModuleWriter(ModuleDecl &module) : module(module) {}
+
+public:
+  void AddDecls();
+  void Write(llvm::raw_ostream &os);
+
+private:
+  IdentifierID AddIdentifier(Identifier identifier);
+
+  /// \return the ID of \p type, or 0 if it cannot be serialized.
+  TypeID AddType(Type type);
+
+  void AddDecl(ValueDecl *decl, DeclCode code);
+};
+} // namespace
+
+static uint32_t GetRecordHeader(uint8_t code, uint8_t extra) {
+  return uint32_t(code) | (uint32_t(extra) << 8);
+}
+
+IdentifierID ModuleWriter::AddIdentifier(Identifier identifier) {
+  auto inserted = identifierIDs.try_emplace(identifier, 0);
+  if (inserted.second) {
+    identifiers.push_back(identifier);
+    inserted.first->second = identifiers.size();
+  }
+  return inserted.first->second;
+}
+
+TypeID ModuleWriter::AddType(Type type) {
+  if (!type) {
+    return 0;
+  }
+  auto found = typeIDs.find(type.GetPtr());
+  if (found != typeIDs.end()) {
+    return found->second;
+  }
+
+  auto kind = type->GetKind();
+  std::vector<uint32_t> record;
+  switch (kind) {
+  case TypeKind::Fun: {
+    auto funType = llvm::cast<FunType>(type.GetPtr());
+    auto resultID = AddType(funType->GetReturnType());
+    if (!resultID) {
+      return 0;
+    }
+    record = {GetRecordHeader(uint8_t(TypeCode::Fun), uint8_t(kind)), resultID,
+              funType->GetNumParams()};
+    for (auto paramType : funType->GetParamTypes()) {
+      auto paramID = AddType(paramType);
+      if (!paramID) {
+        return 0;
+      }
+      record.push_back(paramID);
+    }
+    break;
+  }
+  case TypeKind::Raw:
+  case TypeKind::Move: {
+    auto pointeeID =
+        AddType(llvm::cast<PointerType>(type.GetPtr())->GetPointeeType());
+    if (!pointeeID) {
+      return 0;
+    }
+    record = {GetRecordHeader(uint8_t(TypeCode::Pointer), uint8_t(kind)),
+              pointeeID};
+    break;
+  }
+  case TypeKind::Ref: {
+    auto referentID =
+        AddType(llvm::cast<ReferenceType>(type.GetPtr())->GetReferentType());
+    if (!referentID) {
+      return 0;
+    }
+    record = {GetRecordHeader(uint8_t(TypeCode::Pointer), uint8_t(kind)),
+              referentID};
+    break;
+  }
+  case TypeKind::Qualified: {
+    auto qualifiedType = llvm::cast<QualifiedType>(type.GetPtr());
+    auto baseID = AddType(qualifiedType->GetBaseType());
+    if (!baseID) {
+      return 0;
+    }
+    record = {GetRecordHeader(uint8_t(TypeCode::Qualified), uint8_t(kind)),
+              baseID, qualifiedType->GetQualSpecs().GetOpaqueValue()};
+    break;
+  }
+  default: {
+    if (!module.GetASTContext().GetBuiltin().GetType(kind)) {
+      return 0;
+    }
+    record = {GetRecordHeader(uint8_t(TypeCode::Builtin), uint8_t(kind))};
+    break;
+  }
+  }
+  typeRecords.push_back(std::move(record));
+  TypeID id = typeRecords.size();
+  typeIDs[type.GetPtr()] = id;
+  return id;
+}
+
+void ModuleWriter::AddDecl(ValueDecl *decl, DeclCode code) {
+  auto name = decl->GetName();
+  if (!name.IsBasic() || !name.GetDeclNameBase().IsValid()) {
+    return;
+  }
+  auto typeID = AddType(decl->GetType());
+  if (decl->GetType() && !typeID) {
+    return;
+  }
+  auto nameID = AddIdentifier(name.GetDeclNameBaseIdentifier());
+  declRecords.push_back(
+      {GetRecordHeader(uint8_t(code), uint8_t(decl->GetVisibilityLevel())),
+       nameID, typeID});
+
+  NameIndexEntry entry;
+  entry.nameID = nameID;
+  entry.declID = declRecords.size();
+  nameIndex.push_back(entry);
+}
+
+void ModuleWriter::AddDecls() {
+  AddIdentifier(module.GetBasicName());
+  for (auto file : module.GetFiles()) {
+    auto sourceFile = llvm::dyn_cast<SourceFile>(file);
+    if (!sourceFile) {
+      continue;
+    }
+    for (auto funDecl :
+         sourceFile->GetDecls<FunDecl>(DeclKind::Fun, DeclKind::Fun)) {
+      AddDecl(funDecl, DeclCode::Fun);
+    }
+  }
+}
+
+void ModuleWriter::Write(llvm::raw_ostream &os) {
+  // Sort the name index by text so that readers can binary search it
+  // without creating identifiers.
+  std::stable_sort(nameIndex.begin(), nameIndex.end(),
+                   [&](const NameIndexEntry &lhs, const NameIndexEntry &rhs) {
+                     return identifiers[lhs.nameID - 1].GetString() <
+                            identifiers[rhs.nameID - 1].GetString();
+                   });
+
+  // Lay out the tables, then the records, then the text.
+  uint32_t offset = sizeof(ModuleFileHeader);
+  auto identifiersOffset = offset;
+  offset += identifiers.size() * sizeof(IdentifierEntry);
+  auto typesOffset = offset;
+  offset += typeRecords.size() * sizeof(Offset);
+  auto declsOffset = offset;
+  offset += declRecords.size() * sizeof(Offset);
+  auto nameIndexOffset = offset;
+  offset += nameIndex.size() * sizeof(NameIndexEntry);
+
+  std::vector<uint32_t> typeOffsets;
+  for (auto &record : typeRecords) {
+    typeOffsets.push_back(offset);
+    offset += record.size() * sizeof(uint32_t);
+  }
+  std::vector<uint32_t> declOffsets;
+  for (auto &record : declRecords) {
+    declOffsets.push_back(offset);
+    offset += record.size() * sizeof(uint32_t);
+  }
+
+  ModuleFileHeader header;
+  std::copy(std::begin(ModuleSignature), std::end(ModuleSignature),
+            header.signature);
+  header.versionMajor = ModuleVersionMajor;
+  header.versionMinor = ModuleVersionMinor;
+  header.moduleNameID = identifierIDs.lookup(module.GetBasicName());
+  header.identifiersOffset = identifiersOffset;
+  header.numIdentifiers = identifiers.size();
+  header.typesOffset = typesOffset;
+  header.numTypes = typeRecords.size();
+  header.declsOffset = declsOffset;
+  header.numDecls = declRecords.size();
+  header.nameIndexOffset = nameIndexOffset;
+  header.numNameIndexEntries = nameIndex.size();
+
+  auto writeBytes = [&](const void *data, size_t size) {
+    os.write(static_cast<const char *>(data), size);
+  };
+  auto writeWord = [&](uint32_t value) {
+    llvm::support::ulittle32_t word;
+    word = value;
+    writeBytes(&word, sizeof(word));
+  };
+
+  writeBytes(&header, sizeof(header));
+  for (auto identifier : identifiers) {
+    IdentifierEntry entry;
+    entry.textOffset = offset;
+    entry.length = identifier.GetString().size();
+    writeBytes(&entry, sizeof(entry));
+    offset += entry.length;
+  }
+  llvm::for_each(typeOffsets, writeWord);
+  llvm::for_each(declOffsets, writeWord);
+  for (auto &entry : nameIndex) {
+    writeBytes(&entry, sizeof(entry));
+  }
+  for (auto &record : typeRecords) {
+    llvm::for_each(record, writeWord);
+  }
+  for (auto &record : declRecords) {
+    llvm::for_each(record, writeWord);
+  }
+  for (auto identifier : identifiers) {
+    os << identifier.GetString();
+  }
+}
+
+void stone::SerializeModule(ModuleDecl &module, llvm::raw_ostream &os) {
+  ModuleWriter writer(module);
+  writer.AddDecls();
+  writer.Write(os);
+}
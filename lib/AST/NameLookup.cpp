@@ -0,0 +1,88 @@
+#include "stone/AST/NameLookup.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/ASTScope.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/MemberTable.h"
+#include "stone/Support/Statistics.h"
+
+using namespace stone;
+
+void NominalTypeDecl::AddMember(Decl *member) {
+  if (member->GetDeclContext() == static_cast<DeclContext *>(this)) {
+    AddDecl(member);
+  }
+  // Keep a table that is current up to date; a stale one is rebuilt anyway.
+  if (memberTable && memberTable->GetGeneration() == memberGeneration) {
+    memberTable->AddMember(member);
+  }
+  if (auto classDecl = llvm::dyn_cast<ClassDecl>(this)) {
+    classDecl->InvalidateVirtualTable();
+  }
+}
+
+void NominalTypeDecl::AddJoin(DeclContext *join) {
+  joins.push_back(join);
+  Decl::GetASTContext().SetJoinedType(join, this);
+  if (memberTable && memberTable->GetGeneration() == memberGeneration) {
+    memberTable->AddMembers(join->GetFirstDecl());
+  }
+  if (auto classDecl = llvm::dyn_cast<ClassDecl>(this)) {
+    classDecl->InvalidateVirtualTable();
+  }
+}
+
+MemberTable &NominalTypeDecl::GetMemberTable() {
+  if (memberTable && memberTable->GetGeneration() == memberGeneration) {
+    return *memberTable;
+  }
+  if (!memberTable) {
+    auto &astContext = Decl::GetASTContext();
+    memberTable = new (astContext) MemberTable(memberGeneration);
+    auto table = memberTable;
+    astContext.AddCleanup([table]() { table->~MemberTable(); });
+  } else {
+    memberTable->Reset(memberGeneration);
+  }
+  memberTable->AddMembers(GetFirstDecl());
+  for (auto join : joins) {
+    memberTable->AddMembers(join->GetFirstDecl());
+  }
+  return *memberTable;
+}
+
+llvm::ArrayRef<ValueDecl *> NominalTypeDecl::LookupDirect(DeclNameBase name) {
+  return GetMemberTable().Find(name);
+}
+
+llvm::TinyPtrVector<ValueDecl *>
+NameLookup::LookupUnqualified(DeclNameBase name, SrcLoc loc,
+                              ASTScope &rootScope) {
+  return LookupUnqualified(
+      name, rootScope.FindInnermostScope(loc, astContext.GetSrcMgr()));
+}
+
+llvm::TinyPtrVector<ValueDecl *>
+NameLookup::LookupUnqualified(DeclNameBase name, ASTScope *scope) {
+  auto stats = astContext.GetStats();
+  auto generation = scope ? scope->GetLookupGeneration() : 0;
+  auto found = cache.find({scope, name});
+  if (found != cache.end() && found->second.generation == generation) {
+    if (stats) {
+      ++stats->getFrontendCounters().NumUnqualifiedLookupCacheHits;
+    }
+    return found->second.results;
+  }
+  if (stats) {
+    ++stats->getFrontendCounters().NumUnqualifiedLookupCacheMisses;
+  }
+  llvm::TinyPtrVector<ValueDecl *> results;
+  for (auto current = scope; current; current = current->GetParent()) {
+    auto decls = current->LookupLocal(name);
+    if (!decls.empty()) {
+      results.insert(results.end(), decls.begin(), decls.end());
+      break;
+    }
+  }
+  cache[{scope, name}] = {generation, results};
+  return results;
+}
@@ -28,6 +28,7 @@ BraceStmt *BraceStmt::Create(SrcLoc lbloc, llvm::ArrayRef<ASTNode> elements,
 
   void *stmtPtr = astContext.AllocateMemory(
       BraceStmt::totalSizeToAlloc<ASTNode>(elements.size()),
-      alignof(BraceStmt));
+      alignof(BraceStmt), MemoryAllocationArena::Stoneanent,
+      ASTAllocationKind::Stmt);
   return ::new (stmtPtr) BraceStmt(lbloc, elements, rbloc);
 }
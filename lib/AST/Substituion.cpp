@@ -0,0 +1,169 @@
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/SubstitutionMap.h"
+#include "stone/AST/Types.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <algorithm>
+
+using namespace stone;
+
+SubstitutionMap::Storage::Storage(llvm::ArrayRef<Type> params,
+                                  llvm::ArrayRef<Type> replacementTypes)
+    : numParams(params.size()) {
+  assert(params.size() == replacementTypes.size() &&
+         "every parameter needs a replacement");
+  std::uninitialized_copy(params.begin(), params.end(),
+                          getTrailingObjects<Type>());
+  std::uninitialized_copy(replacementTypes.begin(), replacementTypes.end(),
+                          getTrailingObjects<Type>() + numParams);
+}
+
+void SubstitutionMap::Storage::Profile(llvm::FoldingSetNodeID &id,
+                                       llvm::ArrayRef<Type> params,
+                                       llvm::ArrayRef<Type> replacementTypes) {
+  id.AddInteger(params.size());
+  for (auto param : params) {
+    id.AddPointer(param.GetPtr());
+  }
+  for (auto replacementType : replacementTypes) {
+    id.AddPointer(replacementType.GetPtr());
+  }
+}
+
+SubstitutionMap SubstitutionMap::Get(const ASTContext &astContext,
+                                     llvm::ArrayRef<Type> params,
+                                     llvm::ArrayRef<Type> replacementTypes) {
+  assert(params.size() == replacementTypes.size() &&
+         "every parameter needs a replacement");
+  if (params.empty()) {
+    return SubstitutionMap();
+  }
+  // The parameters stay in the order of their parameter list, so equal maps
+  // are built from equal lists in every run, whatever the heap layout.
+  llvm::SmallVector<Type, 4> canParams;
+  for (auto param : params) {
+    auto canParam = Type(param->GetCanType().GetPtr());
+    assert(llvm::none_of(canParams,
+                         [&](Type other) {
+                           return other.GetPtr() == canParam.GetPtr();
+                         }) &&
+           "a parameter is substituted twice");
+    canParams.push_back(canParam);
+  }
+
+  llvm::FoldingSetNodeID id;
+  Storage::Profile(id, canParams, replacementTypes);
+  void *insertPos = nullptr;
+  if (auto storage =
+          astContext.substitutionMaps.FindNodeOrInsertPos(id, insertPos)) {
+    return SubstitutionMap(storage);
+  }
+  void *mem = astContext.AllocateMemory(
+      Storage::totalSizeToAlloc<Type>(canParams.size() * 2), alignof(Storage));
+  auto storage = ::new (mem) Storage(canParams, replacementTypes);
+  astContext.substitutionMaps.InsertNode(storage, insertPos);
+  return SubstitutionMap(storage);
+}
+
+llvm::ArrayRef<Type> SubstitutionMap::GetParams() const {
+  return storage ? storage->GetParams() : llvm::ArrayRef<Type>();
+}
+
+llvm::ArrayRef<Type> SubstitutionMap::GetReplacementTypes() const {
+  return storage ? storage->GetReplacementTypes() : llvm::ArrayRef<Type>();
+}
+
+Type SubstitutionMap::LookupSubstitution(Type param) const {
+  if (!storage || !param) {
+    return Type();
+  }
+  // Maps are as small as parameter lists, so a scan beats a search.
+  auto canParam = param->GetCanType().GetPtr();
+  auto params = GetParams();
+  for (unsigned index = 0, count = params.size(); index != count; ++index) {
+    if (params[index].GetPtr() == canParam) {
+      return GetReplacementTypes()[index];
+    }
+  }
+  return Type();
+}
+
+Type Type::Subst(SubstitutionMap subs) const {
+  if (!typePtr || subs.IsEmpty()) {
+    return *this;
+  }
+  return typePtr->GetASTContext().GetSubstitutedType(*this, subs);
+}
+
+Type ASTContext::GetSubstitutedType(Type type, SubstitutionMap subs) const {
+  if (!type || subs.IsEmpty()) {
+    return type;
+  }
+  auto found = substitutedTypes.find({type.GetPtr(), subs});
+  if (found != substitutedTypes.end()) {
+    if (stats) {
+      ++stats->getFrontendCounters().NumSubstitutionCacheHits;
+    }
+    return found->second;
+  }
+  if (stats) {
+    ++stats->getFrontendCounters().NumSubstitutionCacheMisses;
+  }
+
+  Type result = subs.LookupSubstitution(type);
+  if (!result) {
+    result = type;
+    switch (type->GetKind()) {
+    case TypeKind::Fun: {
+      auto funType = llvm::cast<FunType>(type.GetPtr());
+      auto returnType = GetSubstitutedType(funType->GetReturnType(), subs);
+      bool changed = returnType.GetPtr() != funType->GetReturnType().GetPtr();
+      llvm::SmallVector<Type, 4> paramTypes;
+      for (auto paramType : funType->GetParamTypes()) {
+        paramTypes.push_back(GetSubstitutedType(paramType, subs));
+        changed |= paramTypes.back().GetPtr() != paramType.GetPtr();
+      }
+      if (changed) {
+        result = GetFunType(returnType, paramTypes);
+      }
+      break;
+    }
+    case TypeKind::Raw:
+    case TypeKind::Move: {
+      auto pointeeType =
+          llvm::cast<PointerType>(type.GetPtr())->GetPointeeType();
+      auto substType = GetSubstitutedType(pointeeType, subs);
+      if (substType.GetPtr() != pointeeType.GetPtr()) {
+        result = type->GetKind() == TypeKind::Raw
+                     ? Type(GetRawType(substType))
+                     : Type(GetMoveType(substType));
+      }
+      break;
+    }
+    case TypeKind::Ref: {
+      auto referentType =
+          llvm::cast<ReferenceType>(type.GetPtr())->GetReferentType();
+      auto substType = GetSubstitutedType(referentType, subs);
+      if (substType.GetPtr() != referentType.GetPtr()) {
+        result = GetRefType(substType);
+      }
+      break;
+    }
+    case TypeKind::Qualified: {
+      auto qualifiedType = llvm::cast<QualifiedType>(type.GetPtr());
+      auto baseType = qualifiedType->GetBaseType();
+      auto substType = GetSubstitutedType(baseType, subs);
+      if (substType.GetPtr() != baseType.GetPtr()) {
+        result = GetQualifiedType(substType, qualifiedType->GetQualSpecs());
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  substitutedTypes[{type.GetPtr(), subs}] = result.GetPtr();
+  return result;
+}
@@ -0,0 +1,309 @@
+#include "stone/AST/SyntaxTree.h"
+#include "stone/AST/ASTContext.h"
+
+using namespace stone;
+
+const GreenSyntaxNode &SyntaxNode::GetGreen() const {
+  return tree.nodes[index];
+}
+
+unsigned SyntaxNode::GetNumChildren() const {
+  unsigned numChildren = 0;
+  unsigned end = index + GetGreen().GetSubtreeSize();
+  for (unsigned child = index + 1; child < end;
+       child += tree.nodes[child].GetSubtreeSize()) {
+    ++numChildren;
+  }
+  return numChildren;
+}
+
+const SyntaxNode *SyntaxNode::GetChild(unsigned n) const {
+  unsigned end = index + GetGreen().GetSubtreeSize();
+  for (unsigned child = index + 1; child < end;
+       child += tree.nodes[child].GetSubtreeSize()) {
+    if (n-- == 0) {
+      return tree.GetNode(child, this);
+    }
+  }
+  return nullptr;
+}
+
+llvm::SmallVector<const SyntaxNode *, 4> SyntaxNode::GetChildren() const {
+  llvm::SmallVector<const SyntaxNode *, 4> children;
+  unsigned end = index + GetGreen().GetSubtreeSize();
+  for (unsigned child = index + 1; child < end;
+       child += tree.nodes[child].GetSubtreeSize()) {
+    children.push_back(tree.GetNode(child, this));
+  }
+  return children;
+}
+
+llvm::StringRef SyntaxNode::GetFullText() const {
+  const auto &green = GetGreen();
+  return tree.buffer.substr(green.GetOffset(), green.GetLength());
+}
+
+llvm::StringRef SyntaxNode::GetText() const {
+  const auto &green = GetGreen();
+  return tree.buffer.substr(green.GetTextOffset(), green.GetTextLength());
+}
+
+llvm::StringRef SyntaxNode::GetLeadingTrivia() const {
+  const auto &green = GetGreen();
+  return tree.buffer.substr(green.GetOffset(),
+                            green.GetLeadingTriviaLength());
+}
+
+llvm::StringRef SyntaxNode::GetTrailingTrivia() const {
+  const auto &green = GetGreen();
+  return tree.buffer.substr(green.GetEndOffset() -
+                                green.GetTrailingTriviaLength(),
+                            green.GetTrailingTriviaLength());
+}
+
+const SyntaxNode *SyntaxTree::GetNode(unsigned index,
+                                      const SyntaxNode *parent) const {
+  assert(index < nodes.size() && "syntax node index out of range");
+  if (!redNodes) {
+    redNodes = astContext.AllocateMemory<const SyntaxNode *>(nodes.size());
+    std::fill_n(redNodes, nodes.size(), nullptr);
+  }
+  if (!redNodes[index]) {
+    redNodes[index] = new (astContext) SyntaxNode(*this, parent, index);
+  }
+  return redNodes[index];
+}
+
+std::string SyntaxTree::GetSourceText() const {
+  std::string text;
+  text.reserve(buffer.size());
+  for (const auto &node : nodes) {
+    if (node.IsToken()) {
+      text += buffer.substr(node.GetOffset(), node.GetLength());
+    }
+  }
+  return text;
+}
+
+const SyntaxNode *SyntaxTree::FindEnclosingNode(uint32_t offset,
+                                                uint32_t length) const {
+  auto contains = [&](const GreenSyntaxNode &node) {
+    return node.GetTextOffset() <= offset &&
+           offset + length <= node.GetTextOffset() + node.GetTextLength();
+  };
+  const SyntaxNode *found = GetRoot();
+  while (true) {
+    const SyntaxNode *inner = nullptr;
+    for (auto child : found->GetChildren()) {
+      if (!child->IsToken() && contains(child->GetGreen())) {
+        inner = child;
+        break;
+      }
+    }
+    if (!inner) {
+      return found;
+    }
+    found = inner;
+  }
+}
+
+/// \return the token that closes a group opened by \p kind, or tok::LAST.
+static tok GetGroupCloser(tok kind, SyntaxKind &groupKind) {
+  switch (kind) {
+  case tok::l_paren:
+    groupKind = SyntaxKind::ParenGroup;
+    return tok::r_paren;
+  case tok::l_square:
+    groupKind = SyntaxKind::SquareGroup;
+    return tok::r_square;
+  case tok::l_brace:
+    groupKind = SyntaxKind::BraceGroup;
+    return tok::r_brace;
+  default:
+    return tok::LAST;
+  }
+}
+
+SyntaxTreeBuilder::SyntaxTreeBuilder(llvm::StringRef buffer) : buffer(buffer) {
+  // Roughly one token for every four bytes of source.
+  nodes.reserve(buffer.size() / 4 + 2);
+  OpenNode(SyntaxKind::SourceFile);
+}
+
+void SyntaxTreeBuilder::OpenNode(SyntaxKind kind) {
+  assert(kind != SyntaxKind::Token && "use AddToken for tokens");
+  OpenPendingNode(kind, tok::LAST);
+}
+
+void SyntaxTreeBuilder::CloseNode() {
+  assert(!openNodes.empty() && "no syntax node to close");
+  // Groups left open by unbalanced source end with the node around them.
+  while (openNodes.back().IsGroup()) {
+    ClosePendingNode();
+  }
+  ClosePendingNode();
+}
+
+void SyntaxTreeBuilder::OpenPendingNode(SyntaxKind kind, tok closer) {
+  PendingNode pending{static_cast<unsigned>(nodes.size())};
+  pending.closer = closer;
+  openNodes.push_back(pending);
+  nodes.emplace_back(kind);
+}
+
+void SyntaxTreeBuilder::ClosePendingNode() {
+  PendingNode closed = openNodes.pop_back_val();
+  nodes[closed.index].subtreeSize = nodes.size() - closed.index;
+  if (!openNodes.empty() && closed.firstToken != ~0U) {
+    auto &parent = openNodes.back();
+    if (parent.firstToken == ~0U) {
+      parent.firstToken = closed.firstToken;
+    }
+    parent.lastToken = closed.lastToken;
+  }
+  closedNodes.push_back(closed);
+}
+
+void SyntaxTreeBuilder::AddToken(tok kind, uint32_t offset, uint32_t length) {
+  assert(!openNodes.empty() && "tokens must be added inside a node");
+  assert(offset >= consumedOffset && offset + length <= buffer.size() &&
+         "tokens must be added in source order; use Rewind to backtrack");
+
+  SyntaxKind groupKind;
+  tok closer = GetGroupCloser(kind, groupKind);
+  if (closer != tok::LAST) {
+    OpenPendingNode(groupKind, closer);
+  }
+
+  // Split the gap since the previous token at the first newline.
+  llvm::StringRef gap = buffer.slice(consumedOffset, offset);
+  uint32_t trailing = 0;
+  if (lastToken != ~0U) {
+    trailing = std::min<size_t>(gap.find_first_of("\r\n"), gap.size());
+    auto &prev = nodes[lastToken];
+    prev.trailingTriviaLength = trailing;
+    prev.length += trailing;
+  }
+
+  GreenSyntaxNode node(SyntaxKind::Token);
+  node.tokKind = kind;
+  node.offset = consumedOffset + trailing;
+  node.leadingTriviaLength = offset - node.offset;
+  node.length = node.leadingTriviaLength + length;
+
+  lastToken = nodes.size();
+  nodes.push_back(node);
+  consumedOffset = offset + length;
+
+  auto &parent = openNodes.back();
+  if (parent.firstToken == ~0U) {
+    parent.firstToken = lastToken;
+  }
+  parent.lastToken = lastToken;
+
+  if (parent.closer == kind) {
+    ClosePendingNode();
+  }
+}
+
+unsigned SyntaxTreeBuilder::FindLastToken(unsigned begin, unsigned end) const {
+  for (unsigned index = end; index-- > begin;) {
+    if (nodes[index].IsToken()) {
+      return index;
+    }
+  }
+  return ~0U;
+}
+
+void SyntaxTreeBuilder::Rewind(uint32_t offset) {
+  // Find the first node to drop: the first token at or after offset, and the
+  // nodes opened right before it, which hold nothing older.
+  unsigned cut = nodes.size();
+  for (unsigned index = nodes.size(); index-- > 0;) {
+    if (nodes[index].IsToken()) {
+      if (nodes[index].GetTextOffset() < offset) {
+        break;
+      }
+      cut = index;
+    }
+  }
+  if (cut == nodes.size()) {
+    return;
+  }
+  while (cut > 1 && !nodes[cut - 1].IsToken()) {
+    --cut;
+  }
+
+  // A group that was closed after the cut is open again; the parser's own
+  // nodes must still be open if the parser backtracks into them.
+  llvm::SmallVector<PendingNode, 8> reopened;
+  llvm::erase_if(closedNodes, [&](const PendingNode &closed) {
+    if (closed.index >= cut) {
+      return true;
+    }
+    if (closed.index + nodes[closed.index].GetSubtreeSize() <= cut) {
+      return false;
+    }
+    assert(closed.IsGroup() && "backtracked into a closed syntax node");
+    reopened.push_back(closed);
+    return true;
+  });
+  llvm::sort(reopened, [](const PendingNode &lhs, const PendingNode &rhs) {
+    return lhs.index < rhs.index;
+  });
+
+  // Parser nodes opened after the cut are opened again below; groups are
+  // opened again by their tokens.
+  llvm::SmallVector<SyntaxKind, 4> reopenedKinds;
+  while (openNodes.back().index >= cut) {
+    auto pending = openNodes.pop_back_val();
+    if (!pending.IsGroup()) {
+      reopenedKinds.push_back(nodes[pending.index].GetKind());
+    }
+  }
+  openNodes.append(reopened.begin(), reopened.end());
+  nodes.erase(nodes.begin() + cut, nodes.end());
+
+  for (auto &pending : openNodes) {
+    if (pending.firstToken >= cut) {
+      pending.firstToken = ~0U;
+    }
+    pending.lastToken = pending.firstToken == ~0U
+                            ? ~0U
+                            : FindLastToken(pending.index, cut);
+  }
+  lastToken = FindLastToken(0, cut);
+  consumedOffset = 0;
+  if (lastToken != ~0U) {
+    auto &last = nodes[lastToken];
+    last.length -= last.trailingTriviaLength;
+    last.trailingTriviaLength = 0;
+    consumedOffset = last.GetEndOffset();
+  }
+  for (auto kind : llvm::reverse(reopenedKinds)) {
+    OpenPendingNode(kind, tok::LAST);
+  }
+}
+
+SyntaxTree *SyntaxTreeBuilder::Finish(const ASTContext &astContext) {
+  while (openNodes.size() > 1) {
+    CloseNode();
+  }
+  AddToken(tok::eof, buffer.size(), 0);
+  CloseNode();
+
+  for (const auto &closed : closedNodes) {
+    auto &node = nodes[closed.index];
+    if (closed.firstToken == ~0U) {
+      continue;
+    }
+    const auto &first = nodes[closed.firstToken];
+    const auto &last = nodes[closed.lastToken];
+    node.offset = first.GetOffset();
+    node.length = last.GetEndOffset() - node.offset;
+    node.leadingTriviaLength = first.GetLeadingTriviaLength();
+    node.trailingTriviaLength = last.GetTrailingTriviaLength();
+  }
+  auto storedNodes = astContext.AllocateCopy(llvm::ArrayRef(nodes));
+  return new (astContext) SyntaxTree(astContext, buffer, storedNodes);
+}
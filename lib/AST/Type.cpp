@@ -1,3 +1,5 @@
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
 #include "stone/AST/TypeLoc.h"
 #include "stone/AST/TypeState.h"
 #include "stone/AST/Types.h"
@@ -26,6 +28,82 @@ bool TypeBase::IsBasic() {
   }
 }
 
+ASTContext &TypeBase::GetASTContext() {
+#ifdef STONE_COMPRESSED_AST_REFS
+  return *static_cast<ASTContext *>(MemoryCage::GetOwner(this));
+#else
+  return const_cast<ASTContext &>(astContext);
+#endif
+}
+
+TypeBase *TypeBase::GetDesugaredType() const {
+  if (auto underlying = underlyingType.Get(this)) {
+    return underlying;
+  }
+  if (auto *aliasType = llvm::dyn_cast<AliasType>(this)) {
+    auto aliasDecl = aliasType->GetAliasDecl();
+    assert(aliasDecl && "alias type without a declaration");
+    return aliasDecl->GetUnderlyingType().GetPtr();
+  }
+  return const_cast<TypeBase *>(this);
+}
+
+CanType TypeBase::GetCanType() const {
+  if (IsCanType()) {
+    return CanType(const_cast<TypeBase *>(this));
+  }
+  if (auto *cached = canType.Get(this)) {
+    return CanType(cached);
+  }
+  auto result = ComputeCanType();
+  assert(result && "type has no canonical form");
+  canType = ASTRef<TypeBase>(result.GetPtr());
+  return result;
+}
+
+CanType TypeBase::ComputeCanType() const {
+  auto &astContext = const_cast<TypeBase *>(this)->GetASTContext();
+  switch (GetKind()) {
+  case TypeKind::Alias: {
+    auto *desugaredType = GetDesugaredType();
+    assert(desugaredType && "alias type has not been resolved");
+    return desugaredType->GetCanType();
+  }
+  case TypeKind::Fun: {
+    auto *funType = llvm::cast<FunType>(this);
+    llvm::SmallVector<Type, 4> paramTypes;
+    for (auto paramType : funType->GetParamTypes()) {
+      paramTypes.push_back(paramType.GetCanType());
+    }
+    return CanType(astContext.GetFunType(
+        funType->GetReturnType().GetCanType(), paramTypes));
+  }
+  case TypeKind::Raw:
+    return CanType(astContext.GetRawType(
+        llvm::cast<RawType>(this)->GetPointeeType().GetCanType()));
+  case TypeKind::Move:
+    return CanType(astContext.GetMoveType(
+        llvm::cast<MoveType>(this)->GetPointeeType().GetCanType()));
+  case TypeKind::Ref:
+    return CanType(astContext.GetRefType(
+        llvm::cast<RefType>(this)->GetReferentType().GetCanType()));
+  case TypeKind::Qualified: {
+    auto *qualifiedType = llvm::cast<QualifiedType>(this);
+    return CanType(astContext.GetQualifiedType(
+        qualifiedType->GetBaseType().GetCanType(),
+        qualifiedType->GetQualSpecs()));
+  }
+  default:
+    break;
+  }
+  // Any other sugar is canonical once its one level is removed.
+  auto *desugaredType = GetDesugaredType();
+  if (desugaredType != this) {
+    return desugaredType->GetCanType();
+  }
+  return CanType(const_cast<TypeBase *>(this));
+}
+
 bool TypeBase::IsNominalType() {
   switch (GetKind()) {
   case TypeKind::Interface:
@@ -85,8 +163,38 @@ bool NumberType::IsFloat() const { return false; }
 bool NumberType::IsImaginary() const { return false; }
 bool NumberType::IsComplex() const { return false; }
 
-FunType::FunType(Type returnType, const ASTContext &astContext)
-    : FunctionType(TypeKind::Fun, returnType, astContext) {}
+FunType::FunType(Type returnType, llvm::ArrayRef<Type> paramTypes,
+                 const ASTContext &astContext)
+    : FunctionType(TypeKind::Fun, returnType, astContext),
+      numParams(paramTypes.size()) {
+  std::uninitialized_copy(paramTypes.begin(), paramTypes.end(),
+                          getTrailingObjects<Type>());
+  SetIsCanType(returnType->IsCanType() &&
+               llvm::all_of(paramTypes, [](Type paramType) {
+                 return paramType->IsCanType();
+               }));
+}
+
+void FunType::Profile(llvm::FoldingSetNodeID &id, Type returnType,
+                      llvm::ArrayRef<Type> paramTypes) {
+  id.AddPointer(returnType.GetPtr());
+  id.AddInteger(paramTypes.size());
+  for (auto paramType : paramTypes) {
+    id.AddPointer(paramType.GetPtr());
+  }
+}
+
+void PointerType::Profile(llvm::FoldingSetNodeID &id, TypeKind kind,
+                          Type pointeeType) {
+  id.AddInteger(static_cast<unsigned>(kind));
+  id.AddPointer(pointeeType.GetPtr());
+}
+
+void ReferenceType::Profile(llvm::FoldingSetNodeID &id, TypeKind kind,
+                            Type referentType) {
+  id.AddInteger(static_cast<unsigned>(kind));
+  id.AddPointer(referentType.GetPtr());
+}
 
 // VoidType *VoidType::Create(const ASTContext &astContext,
 // MemoryAllocationArena arena) {
@@ -107,6 +215,15 @@ FunType::FunType(Type returnType, const ASTContext &astContext)
 // == Type == //
 bool Type::Walk(TypeWalker &walker) const {}
 
+CanType Type::GetCanType() const {
+  assert(typePtr && "canonical type of a null Type");
+  return typePtr->GetCanType();
+}
+
+bool Type::IsEqual(Type other) const {
+  return GetCanType() == other.GetCanType();
+}
+
 // == TypeQualifierCollector == //
 
 /// Collect any qualifiers on the given type and return an
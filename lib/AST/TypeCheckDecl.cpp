@@ -1,4 +1,7 @@
+#include "stone/AST/ASTContext.h"
 #include "stone/AST/ASTVisitor.h"
+#include "stone/AST/Availability.h"
+#include "stone/AST/TypeCheckRequests.h"
 #include "stone/AST/TypeChecker.h"
 #include "stone/AST/Visibility.h"
 
@@ -18,14 +21,21 @@ public:
 public:
   void VisitFunDecl(FunDecl *FD) {
     stone::CheckVisibilityControl(FD);
+    stone::CheckAvailability(FD);
 
     // TODO:
     // TypeChecker::CheckParameterList(FD->GetParameters(), FD);
   }
 
-  void VisitStructDecl(StructDecl *structDecl) {}
+  void VisitStructDecl(StructDecl *structDecl) {
+    stone::CheckAvailability(structDecl);
+  }
 };
 
+bool TypeCheckDeclRequest::Evaluate(Evaluator &evaluator) const {
+  return TypeChecker::CheckDecl(GetSubject());
+}
+
 bool TypeChecker::CheckDecl(Decl *D) {
   auto *SF = D->GetDeclContext()->GetParentSourceFile();
   DeclChecker(D->GetASTContext(), SF).Visit(D);
@@ -0,0 +1,19 @@
+#include "stone/AST/TypeCheckRequests.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/VirtualTable.h"
+
+using namespace stone;
+
+FunctionDecl *OverriddenDeclRequest::Evaluate(Evaluator &evaluator) const {
+  auto fn = GetSubject();
+  if (!fn->IsVirtual()) {
+    return nullptr;
+  }
+  // A function declared in a join belongs to the class the join adds to.
+  auto classDecl = llvm::dyn_cast_or_null<ClassDecl>(
+      fn->GetDeclContext()->GetSelfNominalTypeDecl());
+  if (!classDecl) {
+    return nullptr;
+  }
+  return classDecl->GetVirtualTable().GetOverriddenDecl(fn);
+}
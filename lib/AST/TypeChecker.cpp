@@ -1,11 +1,13 @@
 #include "stone/AST/TypeChecker.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/TypeCheckRequests.h"
 
 using namespace stone;
 
 void TypeChecker::CheckSourceFile(SourceFile &sourceFile) {
-
+  auto &evaluator = sourceFile.GetASTContext().GetEvaluator();
   for (auto D : sourceFile.GetTopLevelDecls()) {
-    TypeChecker::CheckDecl(D);
+    evaluator(TypeCheckDeclRequest(D));
     sourceFile.SetTypeCheckedStage();
   }
 }
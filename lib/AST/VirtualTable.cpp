@@ -1,7 +1,163 @@
 #include "stone/AST/VirtualTable.h"
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/Decl.h"
+
+#include "llvm/ADT/SmallVector.h"
 
 using namespace stone;
 
-VirtualTable::VirtualTable() {}
+VirtualTable::VirtualTable(
+    ClassDecl &classDecl, const VirtualTable *parent, unsigned generation,
+    llvm::ArrayRef<FunctionDecl *> slots,
+    llvm::DenseMap<const FunctionDecl *, unsigned> &&ownSlots)
+    : classDecl(classDecl), parent(parent), numSlots(slots.size()),
+      generation(generation), ownSlots(std::move(ownSlots)) {
+  std::uninitialized_copy(slots.begin(), slots.end(),
+                          getTrailingObjects<FunctionDecl *>());
+}
+
+/// \return true if \p fn can fill the slot of \p base.
+static bool IsOverrideOf(FunctionDecl *fn, FunctionDecl *base) {
+  if (fn->GetBasicName() != base->GetBasicName()) {
+    return false;
+  }
+  auto type = fn->GetType();
+  auto baseType = base->GetType();
+  if (!type || !baseType) {
+    return !type && !baseType;
+  }
+  return type.IsEqual(baseType);
+}
+
+VirtualTable *VirtualTable::Create(ClassDecl &classDecl,
+                                   const VirtualTable *parent,
+                                   unsigned generation,
+                                   ASTContext &astContext) {
+  llvm::SmallVector<FunctionDecl *, 16> slots;
+  if (parent) {
+    auto parentSlots = parent->GetSlots();
+    slots.append(parentSlots.begin(), parentSlots.end());
+  }
+  // Index the inherited slots by name, so that each function of this class
+  // is matched against the few slots that share its name. The slots with one
+  // name are chained in slot order through nextWithName, which is scratch
+  // data and goes away with the temporary arena.
+  TemporaryArenaScope temporaryArena(astContext);
+  unsigned numInherited = slots.size();
+  auto nextWithName = astContext.AllocateMemory<unsigned>(
+      numInherited, MemoryAllocationArena::Temporary);
+  llvm::DenseMap<Identifier, unsigned> firstWithName;
+  for (unsigned index = numInherited; index-- > 0;) {
+    auto inserted =
+        firstWithName.try_emplace(slots[index]->GetBasicName(), index);
+    nextWithName[index] = inserted.second ? ~0U : inserted.first->second;
+    inserted.first->second = index;
+  }
+
+  llvm::DenseMap<const FunctionDecl *, unsigned> ownSlots;
+  auto addFunctions = [&](Decl *firstDecl) {
+    for (auto decl = firstDecl; decl; decl = decl->GetNextDecl()) {
+      auto fn = llvm::dyn_cast<FunctionDecl>(decl);
+      if (!fn || !fn->IsVirtual() || ownSlots.count(fn)) {
+        continue;
+      }
+      std::optional<unsigned> overridden;
+      auto found = firstWithName.find(fn->GetBasicName());
+      if (found != firstWithName.end()) {
+        for (auto index = found->second; index != ~0U;
+             index = nextWithName[index]) {
+          if (IsOverrideOf(fn, slots[index])) {
+            overridden = index;
+            break;
+          }
+        }
+      }
+      if (overridden) {
+        slots[*overridden] = fn;
+        ownSlots[fn] = *overridden;
+        continue;
+      }
+      ownSlots[fn] = slots.size();
+      slots.push_back(fn);
+    }
+  };
+  addFunctions(classDecl.GetFirstDecl());
+  for (auto join : classDecl.GetJoins()) {
+    addFunctions(join->GetFirstDecl());
+  }
+
+  void *mem = astContext.AllocateMemory(totalSizeToAlloc<FunctionDecl *>(
+                                            slots.size()),
+                                        alignof(VirtualTable));
+  auto table = ::new (mem)
+      VirtualTable(classDecl, parent, generation, slots, std::move(ownSlots));
+  astContext.AddCleanup([table]() { table->~VirtualTable(); });
+  return table;
+}
+
+std::optional<unsigned>
+VirtualTable::GetSlotIndex(const FunctionDecl *fn) const {
+  for (auto table = this; table; table = table->parent) {
+    auto found = table->ownSlots.find(fn);
+    if (found != table->ownSlots.end()) {
+      return found->second;
+    }
+  }
+  return std::nullopt;
+}
+
+FunctionDecl *VirtualTable::GetOverriddenDecl(const FunctionDecl *fn) const {
+  auto found = ownSlots.find(fn);
+  if (found == ownSlots.end() || !parent ||
+      found->second >= parent->GetNumSlots()) {
+    return nullptr;
+  }
+  return parent->GetSlots()[found->second];
+}
+
+void FunctionDecl::SetVirtual(bool isVirtual) {
+  if (IsVirtual() == isVirtual) {
+    return;
+  }
+  Bits.FunctionDecl.IsVirtual = isVirtual;
+  if (auto classDecl = llvm::dyn_cast_or_null<ClassDecl>(
+          GetDeclContext()->GetSelfNominalTypeDecl())) {
+    classDecl->InvalidateVirtualTable();
+  }
+}
+
+bool ClassDecl::IsSubclassOf(const ClassDecl *other) const {
+  for (auto classDecl = this; classDecl; classDecl = classDecl->superclass) {
+    if (classDecl == other) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ClassDecl::SetSuperclass(ClassDecl *inputSuperclass) {
+  // Refusing cycles here keeps every walk up the superclasses finite.
+  if (inputSuperclass && inputSuperclass->IsSubclassOf(this)) {
+    return false;
+  }
+  superclass = inputSuperclass;
+  InvalidateVirtualTable();
+  // Subclasses conform to what their superclasses conform to.
+  Decl::GetASTContext().InvalidateConformances();
+  return true;
+}
 
-VirtualTable::~VirtualTable() {}
\ No newline at end of file
+const VirtualTable &ClassDecl::GetVirtualTable() {
+  const VirtualTable *parent = nullptr;
+  if (superclass) {
+    parent = &superclass->GetVirtualTable();
+  }
+  // A layout is stale when this class changed or the superclass's layout,
+  // whose slots it copies, was rebuilt.
+  if (!virtualTable || virtualTable->GetGeneration() != virtualGeneration ||
+      virtualTable->GetParent() != parent) {
+    virtualTable = VirtualTable::Create(*this, parent, virtualGeneration,
+                                        Decl::GetASTContext());
+  }
+  return *virtualTable;
+}
@@ -1,5 +1,10 @@
 #include "stone/AST/Visibility.h"
+#include "stone/AST/ASTContext.h"
 #include "stone/AST/ASTVisitor.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/DiagnosticsSem.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/Types.h"
 
 using namespace stone;
 
@@ -11,16 +16,117 @@ public:
   explicit DeclVisibilityChecker(ExportContext where) : Where(where) {}
 };
 
+/// Orders the levels from the narrowest to the widest.
+static unsigned GetVisibilityRank(VisibilityLevel level) {
+  switch (level) {
+  case VisibilityLevel::Private:
+    return 0;
+  case VisibilityLevel::File:
+    return 1;
+  case VisibilityLevel::None:
+  case VisibilityLevel::Internal:
+    return 2;
+  case VisibilityLevel::Public:
+    return 3;
+  case VisibilityLevel::Global:
+    return 4;
+  }
+  llvm_unreachable("Invalid visibility level");
+}
+
+bool stone::IsNarrowerVisibility(VisibilityLevel lhs, VisibilityLevel rhs) {
+  return GetVisibilityRank(lhs) < GetVisibilityRank(rhs);
+}
+
+VisibilityLevel stone::GetNarrowerVisibility(VisibilityLevel lhs,
+                                             VisibilityLevel rhs) {
+  return IsNarrowerVisibility(rhs, lhs) ? rhs : lhs;
+}
+
+VisibilityLevel VisibilityCache::GetEffectiveVisibility(Decl *decl) {
+  auto found = decls.find(decl);
+  if (found != decls.end()) {
+    return found->second;
+  }
+  // Decls without a level of their own, such as extensions, only pass on
+  // the level of their context.
+  auto result = VisibilityLevel::Global;
+  if (auto valueDecl = llvm::dyn_cast<ValueDecl>(decl)) {
+    result = GetNarrowerVisibility(result, valueDecl->GetVisibilityLevel());
+  }
+  // Modules do not narrow what they contain.
+  for (auto dc = decl->GetDeclContext(); dc && !dc->IsModuleFileContext();
+       dc = dc->GetParent()) {
+    if (auto parentDecl = dc->ToDecl()) {
+      result =
+          GetNarrowerVisibility(result, GetEffectiveVisibility(parentDecl));
+      break;
+    }
+  }
+  decls[decl] = result;
+  return result;
+}
+
+VisibilityLevel VisibilityCache::GetEffectiveVisibility(Type type) {
+  // Nothing in a type without decls narrows it.
+  if (!type) {
+    return VisibilityLevel::Global;
+  }
+  auto canType = type->GetCanType();
+  auto found = types.find(canType.GetPtr());
+  if (found != types.end()) {
+    return found->second;
+  }
+  auto result = VisibilityLevel::Global;
+  if (auto nominalType = llvm::dyn_cast<NominalType>(canType.GetPtr())) {
+    result = GetEffectiveVisibility(nominalType->GetDecl());
+  } else if (auto funType = llvm::dyn_cast<FunType>(canType.GetPtr())) {
+    result = GetEffectiveVisibility(funType->GetReturnType());
+    for (auto paramType : funType->GetParamTypes()) {
+      result = GetNarrowerVisibility(result, GetEffectiveVisibility(paramType));
+    }
+  } else if (auto pointerType = llvm::dyn_cast<PointerType>(canType.GetPtr())) {
+    result = GetEffectiveVisibility(pointerType->GetPointeeType());
+  } else if (auto referenceType =
+                 llvm::dyn_cast<ReferenceType>(canType.GetPtr())) {
+    result = GetEffectiveVisibility(referenceType->GetReferentType());
+  } else if (auto qualifiedType =
+                 llvm::dyn_cast<QualifiedType>(canType.GetPtr())) {
+    result = GetEffectiveVisibility(qualifiedType->GetBaseType());
+  }
+  types[canType.GetPtr()] = result;
+  return result;
+}
+
 ExportContext::ExportContext(
     DeclContext *DC, VisibilityContext runningOSVersion,
-    std::optional<PlatformKind> unavailablePlatformKind) {}
+    std::optional<PlatformKind> unavailablePlatformKind, bool exported)
+    : DC(DC), exported(exported) {}
 
-ExportContext ExportContext::ForDeclSignature(Decl *D) {}
+ExportContext ExportContext::ForDeclSignature(Decl *D) {
+  auto visibility =
+      D->GetASTContext().GetVisibilityCache().GetEffectiveVisibility(D);
+  return ExportContext(D->GetDeclContext(), VisibilityContext(), std::nullopt,
+                       !IsNarrowerVisibility(visibility,
+                                             VisibilityLevel::Public));
+}
 
 /// At a high level, this checks the given declaration's signature does not
 /// reference any other declarations that are less visible than the
 /// declaration itself. Related checks may also be performed.
-void stone::CheckVisibilityControl(Decl *D) {}
-
-/// Check the Type visibility level
-void stone::CheckVisibilityControl(Type ty) {}
+void stone::CheckVisibilityControl(Decl *D) {
+  auto valueDecl = llvm::dyn_cast<ValueDecl>(D);
+  if (!valueDecl || !valueDecl->GetType()) {
+    return;
+  }
+  auto &astContext = D->GetASTContext();
+  auto &visibilityCache = astContext.GetVisibilityCache();
+  auto declVisibility = visibilityCache.GetEffectiveVisibility(D);
+  auto typeVisibility =
+      visibilityCache.GetEffectiveVisibility(valueDecl->GetType());
+  if (IsNarrowerVisibility(typeVisibility, declVisibility)) {
+    astContext.GetDiags().diagnose(D->GetNameLoc(),
+                                   diag::error_decl_more_visible_than_signature,
+                                   D->GetBasicNameText());
+  }
+}
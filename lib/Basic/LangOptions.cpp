@@ -1,4 +1,5 @@
 #include "stone/Basic/LangOptions.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/TargetParser/Host.h"
 
 using namespace stone;
@@ -38,6 +39,38 @@ static const SupportedConditionalValue
 static bool CanSupportOS() { return false; }
 static bool CanSupportArch() { return false; }
 
+llvm::StringRef
+LangOptions::GetPlatformConditionValue(PlatformConditionKind Kind) const {
+  // Last one wins.
+  for (auto &Opt : llvm::reverse(PlatformConditionValues)) {
+    if (Opt.first == Kind) {
+      return Opt.second;
+    }
+  }
+  return llvm::StringRef();
+}
+
+bool LangOptions::CheckPlatformCondition(PlatformConditionKind Kind,
+                                         llvm::StringRef Value) const {
+  // Check a special case that "macOS" is an alias of "OSX".
+  if (Kind == PlatformConditionKind::OS && Value == "macOS") {
+    return CheckPlatformCondition(Kind, "OSX");
+  }
+  for (auto &Opt : llvm::reverse(PlatformConditionValues)) {
+    if (Opt.first == Kind) {
+      if (Opt.second == Value) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool LangOptions::IsCustomConditionalCompilationFlagSet(
+    llvm::StringRef Name) const {
+  return llvm::is_contained(CustomConditionalCompilationFlags, Name);
+}
+
 LangOptions::TargetResult LangOptions::SetTarget(llvm::Triple triple) {
 
   LangOptions::TargetResult result;
@@ -59,6 +92,8 @@ LangOptions::TargetResult LangOptions::SetTarget(llvm::Triple triple) {
     triple.setOSName(osx.str());
   }
   DefaultTargetTriple = std::move(triple);
+  ClearAllPlatformConditionValues();
+
   // Set the "os" platform condition.
   switch (DefaultTargetTriple.getOS()) {
   case llvm::Triple::Darwin:
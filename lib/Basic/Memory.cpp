@@ -5,7 +5,7 @@ using namespace stone;
 void *stone::AllocateInMemoryContext(size_t bytes, const MemoryContext &mem,
                                      MemoryAllocationArena arena,
                                      unsigned alignment) {
-  return mem.AllocateMemory(bytes, alignment /*, arena*/);
+  return mem.AllocateMemory(bytes, alignment, arena);
 }
 
 MemoryContext::MemoryContext(const LangOptions &langOpts)
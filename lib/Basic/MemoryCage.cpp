@@ -0,0 +1,129 @@
+#include "stone/Basic/MemoryCage.h"
+
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Process.h"
+
+#if defined(LLVM_ON_UNIX)
+#include <sys/mman.h>
+#endif
+
+using namespace stone;
+
+#if defined(LLVM_ON_UNIX)
+
+MemoryCage *MemoryCage::Create(void *owner) {
+  // Reserve twice the size so that an aligned cage fits, then give back the
+  // ends that are not part of it.
+  auto reserved = ::mmap(nullptr, 2 * Size, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (reserved == MAP_FAILED) {
+    llvm::report_fatal_error("could not reserve the AST memory cage");
+  }
+  auto start = reinterpret_cast<uintptr_t>(reserved);
+  auto base = llvm::alignTo(start, Size);
+  if (base != start) {
+    ::munmap(reserved, base - start);
+  }
+  ::munmap(reinterpret_cast<void *>(base + Size), start + Size - base);
+
+  // The cage object itself lives in the header page.
+  auto pageSize = llvm::sys::Process::getPageSizeEstimate();
+  if (::mprotect(reinterpret_cast<void *>(base), pageSize,
+                 PROT_READ | PROT_WRITE) != 0) {
+    llvm::report_fatal_error("could not commit the AST memory cage header");
+  }
+  reinterpret_cast<Header *>(base)->owner = owner;
+  auto cage = ::new (reinterpret_cast<void *>(base + sizeof(Header)))
+      MemoryCage();
+  cage->committedEnd = base + pageSize;
+  cage->cursor = llvm::alignTo(base + sizeof(Header) + sizeof(MemoryCage),
+                               alignof(std::max_align_t));
+  return cage;
+}
+
+void MemoryCage::Destroy() {
+  ::munmap(reinterpret_cast<void *>(GetBase()), Size);
+}
+
+/// Every slab is a multiple of this, so that a split slab leaves room for
+/// the link of the rest.
+static constexpr size_t SlabGranule = alignof(std::max_align_t);
+
+void *MemoryCage::AllocateSlab(size_t bytes, size_t alignment) {
+  bytes = llvm::alignTo(bytes, SlabGranule);
+
+  // Take the smallest released slab that fits, and release what is left of
+  // it. Arenas ask for the same few slab sizes, so most fits are exact.
+  FreeSlab **bestLink = nullptr;
+  for (auto link = &freeSlabs; *link; link = &(*link)->next) {
+    auto slab = *link;
+    if (slab->bytes < bytes ||
+        reinterpret_cast<uintptr_t>(slab) % alignment != 0) {
+      continue;
+    }
+    if (!bestLink || slab->bytes < (*bestLink)->bytes) {
+      bestLink = link;
+      if (slab->bytes == bytes) {
+        break;
+      }
+    }
+  }
+  if (bestLink) {
+    auto slab = *bestLink;
+    *bestLink = slab->next;
+    bytesFree -= slab->bytes;
+    if (slab->bytes > bytes) {
+      DeallocateSlab(reinterpret_cast<char *>(slab) + bytes,
+                     slab->bytes - bytes);
+    }
+    return slab;
+  }
+
+  auto start = llvm::alignTo(cursor, alignment);
+  auto end = start + bytes;
+  if (end > GetBase() + Size) {
+    llvm::report_fatal_error("the AST memory cage is exhausted");
+  }
+  if (end > committedEnd) {
+    auto pageSize = llvm::sys::Process::getPageSizeEstimate();
+    auto newCommittedEnd = llvm::alignTo(end, pageSize);
+    if (::mprotect(reinterpret_cast<void *>(committedEnd),
+                   newCommittedEnd - committedEnd,
+                   PROT_READ | PROT_WRITE) != 0) {
+      llvm::report_fatal_error("could not commit AST memory cage pages");
+    }
+    committedEnd = newCommittedEnd;
+  }
+  cursor = end;
+  return reinterpret_cast<void *>(start);
+}
+
+void MemoryCage::DeallocateSlab(void *slab, size_t bytes) {
+  bytes = llvm::alignTo(bytes, SlabGranule);
+  assert(reinterpret_cast<uintptr_t>(slab) % SlabGranule == 0 &&
+         "slab was not allocated from the cage");
+  assert(reinterpret_cast<uintptr_t>(slab) + bytes <= cursor &&
+         "slab was not allocated from the cage");
+  auto freeSlab = ::new (slab) FreeSlab{freeSlabs, bytes};
+  freeSlabs = freeSlab;
+  bytesFree += bytes;
+}
+
+#else
+
+MemoryCage *MemoryCage::Create(void *owner) {
+  llvm::report_fatal_error("the AST memory cage is not supported on this host");
+}
+
+void MemoryCage::Destroy() {}
+
+void *MemoryCage::AllocateSlab(size_t bytes, size_t alignment) {
+  llvm_unreachable("the AST memory cage is not supported on this host");
+}
+
+void MemoryCage::DeallocateSlab(void *slab, size_t bytes) {
+  llvm_unreachable("the AST memory cage is not supported on this host");
+}
+
+#endif
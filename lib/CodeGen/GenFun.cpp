@@ -1,3 +1,4 @@
+#include "stone/AST/ASTContext.h"
 #include "stone/AST/Decl.h"
 #include "stone/AST/Global.h"
 #include "stone/AST/Module.h"
@@ -23,6 +24,11 @@ void CodeGenModule::EmitFunDecl(FunDecl *FD, llvm::GlobalValue *GV) {
   assert(FD && "Null FundDecl!");
 
   auto funType = GetFunctionType(FD);
+  if (!GV) {
+    GV = llvm::Function::Create(funType, llvm::GlobalValue::ExternalLinkage,
+                                FD->GetASTContext().GetMangledName(FD),
+                                GetLLVMModule());
+  }
 
   //   EmitFunctionOptions emitFunctionOpts;
   //   emitFunctionOpts |= EmitFunctionFlags::IsForDefinition;
@@ -2,6 +2,7 @@
 #include "stone/AST/Diagnostics.h"
 #include "stone/AST/DiagnosticsCompile.h"
 #include "stone/AST/Module.h"
+#include "stone/AST/SerializedModule.h"
 #include "stone/AST/TypeChecker.h"
 #include "stone/Basic/About.h"
 #include "stone/Basic/Defer.h"
@@ -101,7 +102,9 @@ int stone::Compile(llvm::ArrayRef<const char *> args, const char *arg0,
   if (instance.HasObservation()) {
     instance.GetObservation()->CompletedConfiguration(instance);
   }
-  if (!PerformCompile(instance)) {
+  bool compiled = PerformCompile(instance);
+  instance.PrintStats();
+  if (!compiled) {
     return FinishCompile(false);
   }
   return FinishCompile();
@@ -178,6 +181,7 @@ bool stone::PerformParse(CompilerInstance &instance,
 
   FrontendStatsTracer frontendTracer(
       instance.GetStats(), instance.GetActionString(CompilerActionKind::Parse));
+  instance.GetASTContext().SetAllocationPhase(ASTAllocationPhase::Parse);
   auto CompletedParseSourceFile = [&](CompilerInstance &instance,
                                       SourceFile &sourceFile) -> void {
     if (instance.HasObservation()) {
@@ -225,6 +229,7 @@ bool stone::PerformSemanticAnalysis(CompilerInstance &instance,
   FrontendStatsTracer frontendTracer(
       instance.GetStats(),
       instance.GetActionString(CompilerActionKind::TypeCheck));
+  instance.GetASTContext().SetAllocationPhase(ASTAllocationPhase::Sema);
 
   instance.ForEachSourceFileToTypeCheck([&](SourceFile &sourceFile) {
     assert(sourceFile.HasParsed() &&
@@ -277,10 +282,33 @@ bool stone::PerformEmitCode(CompilerInstance &instance) {
                                            result.GetGlobalHash());
         });
   }
+  case CompilerActionKind::EmitModule: {
+    return stone::PerformSerializeModule(instance);
+  }
   default: {
   }
   }
 }
+
+bool stone::PerformSerializeModule(CompilerInstance &instance) {
+  const PrimaryFileSpecificPaths psps =
+      instance.GetPrimaryFileSpecificPathsForWholeModuleOptimizationMode();
+  llvm::StringRef outputFilename =
+      psps.supplementaryOutputPaths.moduleOutputPath;
+  if (outputFilename.empty()) {
+    outputFilename = psps.outputFilename;
+  }
+  std::error_code ec;
+  llvm::raw_fd_ostream os(outputFilename, ec, llvm::sys::fs::OF_None);
+  if (ec) {
+    instance.GetInvocation().GetDiags().diagnose(
+        SrcLoc(), diag::error_opening_output, outputFilename, ec.message());
+    return true;
+  }
+  stone::SerializeModule(*instance.GetMainModule(), os);
+  return instance.HasError();
+}
+
 bool stone::PerformEmitIR(CompilerInstance &instance,
                           PerformEmitIRCallback callback) {
 
@@ -341,6 +369,7 @@ CodeGenResult stone::PerformEmitSourceFile(CompilerInstance &instance,
                                            llvm::GlobalVariable *globalHash) {
 
   assert(sourceFile.HasTypeChecked() && "source-file was not type-checked!");
+  instance.GetASTContext().SetAllocationPhase(ASTAllocationPhase::CodeGen);
 
   CodeGenContext codeGenContext(instance.GetInvocation().GetCodeGenOptions(),
                                 instance.GetASTContext());
@@ -25,12 +25,13 @@ bool CompilerInstance::Setup() {
   if (SetupCompilerInputFiles().IsError()) {
     return false;
   }
+  // The stats come first so that the ASTContext can count into them.
+  SetupStats();
   if (ShouldSetupASTContext()) {
     if (!SetupASTContext()) {
       return false;
     }
   }
-  SetupStats();
   return true;
 }
 
@@ -301,6 +302,7 @@ SourceFile *CompilerInstance::CreateSourceFileForMainModule(
   auto parsingOpts = GetSourceFileParsingOptions(isPrimary);
   auto sourceFile =
       SourceFile::Create(kind, bufferID, *mainModule, *astContext);
+  sourceFile->SetParsingOptions(parsingOpts);
 
   // if (isMainBuffer)
   //   inputFile->SyntaxParsingCache =
@@ -351,7 +353,7 @@ void CompilerInstance::SetupStats() {
 
   const std::string &statsOutputDir =
       invocation.GetCompilerOptions().statsOutputDir;
-  if (statsOutputDir.empty())
+  if (statsOutputDir.empty() && !invocation.GetCompilerOptions().printStats)
     return;
 
   const std::string &outputFile =
@@ -369,7 +371,18 @@ void CompilerInstance::SetupStats() {
       &invocation.GetClangImporter().GetClangInstance().getSourceManager(),
       invocation.GetCompilerOptions().traceStats,
       invocation.GetCompilerOptions().profileEvents,
-      invocation.GetCompilerOptions().profileEntities);
+      invocation.GetCompilerOptions().profileEntities,
+      /*WriteStatsFile=*/!statsOutputDir.empty());
+}
+
+void CompilerInstance::PrintStats() {
+  if (!stats || !invocation.GetCompilerOptions().printStats) {
+    return;
+  }
+  stats->printAlwaysOnStats(llvm::errs());
+  if (astContext) {
+    astContext->GetEvaluator().PrintCounters(llvm::errs());
+  }
 }
 
 bool CompilerInstance::ForEachSourceFileInMainModule(
@@ -222,6 +222,13 @@ Status CompilerInvocation::ParseArgs(llvm::ArrayRef<const char *> args) {
     return status;
   }
 
+  // The platform conditions used by '#if' come from the target triple.
+  if (!targetOptions.triple.empty()) {
+    SetTargetTriple(targetOptions.triple);
+  } else {
+    SetTargetTriple(langOpts.DefaultTargetTriple.str());
+  }
+
   if (GetCompilerOptions().DoesActionGenerateIR() ||
       GetCompilerOptions().DoesActionGenerateNativeCode()) {
     // TODO: hard coding -cc1 for now -- build out proper string.
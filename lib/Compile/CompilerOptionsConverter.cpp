@@ -43,6 +43,7 @@ Status CompilerOptionsConverter::Convert(
   if (compilerOpts.IsImmediateAction()) {
     return Status::MakeHasCompletion();
   }
+  compilerOpts.printStats = args.hasArg(opts::OPT_PrintStats);
   // TODO: OK for now
   // assert(compilerOpts.inputsAndOutputs.HasInputs() &&
   //       "Inputs and Outputs should be empty");
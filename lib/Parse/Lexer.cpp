@@ -1,6 +1,7 @@
 #include "stone/Parse/Lexer.h"
 #include "stone/AST/DiagnosticsParse.h"
 #include "stone/AST/Identifier.h"
+#include "stone/Basic/LangOptions.h"
 #include "stone/Basic/SrcMgr.h"
 #include "stone/Parse/Confusable.h"
 
@@ -140,7 +141,7 @@ uint32_t stone::validateUTF8CharacterAndAdvance(const char *&Ptr,
 Lexer::Lexer(const PrincipalLexer &, unsigned BufferID, const SrcMgr &sm,
              DiagnosticEngine *de, StatsReporter *se, LexerMode LexMode,
              HashbangMode HashbangAllowed, CommentRetentionMode RetainComments)
-    : BufferID(BufferID), sm(sm), de(de), LexMode(LexMode),
+    : BufferID(BufferID), sm(sm), de(de), se(se), LexMode(LexMode),
       IsHashbangAllowed(HashbangAllowed == HashbangMode::Allowed),
       RetainComments(RetainComments) {}
 
@@ -196,6 +197,18 @@ Lexer::Lexer(unsigned BufferID, const SrcMgr &sm, DiagnosticEngine *de,
     : Lexer(BufferID, sm, de, se, LexerMode::Stone, HashbangMode::Disallowed,
             CommentRetentionMode::None) {}
 
+Lexer::Lexer(unsigned BufferID, const SrcMgr &sm, DiagnosticEngine *de,
+             StatsReporter *se, const LangOptions *IfConfigLangOpts)
+    : Lexer(PrincipalLexer(), BufferID, sm, de, se, LexerMode::Stone,
+            HashbangMode::Disallowed, CommentRetentionMode::None) {
+
+  // Must be set before the first token is lexed.
+  this->IfConfigLangOpts = IfConfigLangOpts;
+
+  unsigned EndOffset = sm.getRangeForBuffer(BufferID).getByteLength();
+  Initialize(/*Offset=*/0, EndOffset);
+}
+
 Lexer::Lexer(unsigned BufferID, const SrcMgr &sm, stone::DiagnosticEngine *de,
              StatsReporter *se, LexerMode LexMode, HashbangMode HashbangAllowed,
              CommentRetentionMode RetainComments, unsigned Offset,
@@ -221,6 +234,7 @@ Lexer::Lexer(Lexer &Parent, LexerState BeginState, LexerState EndState)
   unsigned Offset = sm.getLocOffsetInBuffer(BeginState.loc, BufferID);
   unsigned EndOffset = sm.getLocOffsetInBuffer(EndState.loc, BufferID);
 
+  IfConfigLangOpts = Parent.IfConfigLangOpts;
   Initialize(Offset, EndOffset);
 }
 
@@ -655,9 +669,331 @@ void Lexer::lexHash() {
 
   // If we found something specific, return it.
   CurPtr = tmpPtr;
+
+  // Conditional compilation directives are resolved here when requested, so
+  // the parser only ever sees the tokens of the active clauses.
+  switch (Kind) {
+  case tok::pound_if:
+  case tok::pound_elseif:
+  case tok::pound_else:
+  case tok::pound_endif:
+    if (lexIfConfigDirective(Kind, TokStart)) {
+      return LexImpl();
+    }
+    break;
+  default:
+    break;
+  }
   return formToken(Kind, TokStart);
 }
 
+//===----------------------------------------------------------------------===//
+// Lex-time '#if' evaluation
+//===----------------------------------------------------------------------===//
+
+static std::optional<PlatformConditionKind>
+getPlatformConditionKind(StringRef Name) {
+  return llvm::StringSwitch<std::optional<PlatformConditionKind>>(Name)
+#define PLATFORM_CONDITION(LABEL, IDENTIFIER)                                  \
+  .Case(IDENTIFIER, PlatformConditionKind::LABEL)
+#include "stone/Basic/PlatformConditionKind.def"
+      .Default(std::nullopt);
+}
+
+namespace {
+/// A recursive-descent evaluator for the condition of a '#if' or '#elseif'
+/// directive. The condition runs to the end of the line (or a '//' comment)
+/// and is made of '||', '&&', '!', parentheses, 'true', 'false', platform
+/// conditions such as 'os(Linux)', and custom flags.
+class IfConfigConditionEvaluator final {
+  const LangOptions &LangOpts;
+  const char *Ptr;
+  const char *End;
+
+public:
+  /// The location of the first error, or \c nullptr if there was none.
+  const char *ErrorPtr = nullptr;
+
+  IfConfigConditionEvaluator(const LangOptions &LangOpts, const char *Ptr,
+                             const char *End)
+      : LangOpts(LangOpts), Ptr(Ptr), End(End) {}
+
+  const char *getCurPtr() const { return Ptr; }
+
+  bool evaluate() {
+    bool Result = evaluateOr();
+    skipSpaces();
+    if (!isAtEndOfCondition()) {
+      setError();
+    }
+    return Result && !ErrorPtr;
+  }
+
+private:
+  void setError() {
+    if (!ErrorPtr) {
+      ErrorPtr = Ptr;
+    }
+  }
+
+  void skipSpaces() {
+    while (Ptr < End && (*Ptr == ' ' || *Ptr == '\t')) {
+      ++Ptr;
+    }
+  }
+
+  bool isAtEndOfCondition() const {
+    return Ptr >= End || *Ptr == '\n' || *Ptr == '\r' || *Ptr == '\0' ||
+           (Ptr[0] == '/' && Ptr[1] == '/');
+  }
+
+  bool consumeIf(StringRef Text) {
+    skipSpaces();
+    if (StringRef(Ptr, End - Ptr).starts_with(Text)) {
+      Ptr += Text.size();
+      return true;
+    }
+    return false;
+  }
+
+  StringRef lexName() {
+    skipSpaces();
+    const char *Start = Ptr;
+    while (Ptr < End && (clang::isAsciiIdentifierContinue(*Ptr) || *Ptr == '.')) {
+      ++Ptr;
+    }
+    return StringRef(Start, Ptr - Start);
+  }
+
+  bool evaluateOr() {
+    bool Result = evaluateAnd();
+    while (!ErrorPtr && consumeIf("||")) {
+      // Both sides are always parsed so malformed conditions are reported.
+      bool RHS = evaluateAnd();
+      Result = Result || RHS;
+    }
+    return Result;
+  }
+
+  bool evaluateAnd() {
+    bool Result = evaluateUnary();
+    while (!ErrorPtr && consumeIf("&&")) {
+      bool RHS = evaluateUnary();
+      Result = Result && RHS;
+    }
+    return Result;
+  }
+
+  bool evaluateUnary() {
+    if (consumeIf("!")) {
+      return !evaluateUnary();
+    }
+    return evaluatePrimary();
+  }
+
+  bool evaluatePrimary() {
+    if (consumeIf("(")) {
+      bool Result = evaluateOr();
+      if (!consumeIf(")")) {
+        setError();
+      }
+      return Result;
+    }
+    StringRef Name = lexName();
+    if (Name.empty()) {
+      setError();
+      return false;
+    }
+    if (Name == "true") {
+      return true;
+    }
+    if (Name == "false") {
+      return false;
+    }
+    if (!consumeIf("(")) {
+      return LangOpts.IsCustomConditionalCompilationFlagSet(Name);
+    }
+    auto Kind = getPlatformConditionKind(Name);
+    StringRef Arg = lexName();
+    if (!Kind || Arg.empty() || !consumeIf(")")) {
+      setError();
+      return false;
+    }
+    // Modules are not loaded while lexing, so 'canImport' is never satisfied.
+    if (*Kind == PlatformConditionKind::CanImport) {
+      return false;
+    }
+    return LangOpts.CheckPlatformCondition(*Kind, Arg);
+  }
+};
+} // namespace
+
+bool Lexer::evaluateIfConfigCondition() {
+  assert(IfConfigLangOpts && "not evaluating '#if' conditions");
+  IfConfigConditionEvaluator Evaluator(*IfConfigLangOpts, CurPtr,
+                                       ArtificialEOF);
+  bool Result = Evaluator.evaluate();
+  if (Evaluator.ErrorPtr) {
+    diagnose(Evaluator.ErrorPtr, diag::lex_invalid_if_config_condition);
+  }
+  CurPtr = Evaluator.getCurPtr();
+  return Result;
+}
+
+/// Skip the string literal whose opening quote is at \p Ptr in an inactive
+/// clause. \return the position after the closing quote, or the end of the
+/// line for an unterminated single-line literal.
+static const char *skipInactiveStringLiteral(const char *Ptr,
+                                             const char *End) {
+  if (End - Ptr >= 3 && StringRef(Ptr, 3) == "\"\"\"") {
+    for (Ptr += 3; Ptr < End; ++Ptr) {
+      if (*Ptr == '\\') {
+        ++Ptr;
+      } else if (End - Ptr >= 3 && StringRef(Ptr, 3) == "\"\"\"") {
+        return Ptr + 3;
+      }
+    }
+    return End;
+  }
+  for (++Ptr; Ptr < End && *Ptr != '\n' && *Ptr != '\r'; ++Ptr) {
+    if (*Ptr == '\\') {
+      ++Ptr;
+    } else if (*Ptr == '"') {
+      return Ptr + 1;
+    }
+  }
+  return Ptr;
+}
+
+const char *Lexer::skipInactiveIfConfigClause(tok &Kind) const {
+  // Directives are only recognized at the start of a line and outside of
+  // comments and string literals. The clause is skipped without forming any
+  // tokens.
+  unsigned Depth = 0;
+  bool IsAtStartOfLine = false;
+  const char *Ptr = CurPtr;
+  const char *End = ArtificialEOF;
+  while (Ptr < End) {
+    switch (*Ptr) {
+    case '\n':
+    case '\r':
+      IsAtStartOfLine = true;
+      ++Ptr;
+      continue;
+    case ' ':
+    case '\t':
+      ++Ptr;
+      continue;
+    case '#': {
+      if (!IsAtStartOfLine) {
+        break;
+      }
+      IsAtStartOfLine = false;
+      const char *NameEnd = Ptr + 1;
+      while (NameEnd < End && clang::isAsciiIdentifierContinue(*NameEnd)) {
+        ++NameEnd;
+      }
+      StringRef Name(Ptr + 1, NameEnd - Ptr - 1);
+      if (Name == "if") {
+        ++Depth;
+      } else if (Name == "endif") {
+        if (Depth == 0) {
+          Kind = tok::pound_endif;
+          return Ptr;
+        }
+        --Depth;
+      } else if (Depth == 0 && (Name == "elseif" || Name == "else")) {
+        Kind = Name == "else" ? tok::pound_else : tok::pound_elseif;
+        return Ptr;
+      }
+      Ptr = NameEnd;
+      continue;
+    }
+    case '/':
+      if (Ptr[1] == '/') {
+        auto EOL = static_cast<const char *>(memchr(Ptr, '\n', End - Ptr));
+        Ptr = EOL ? EOL : End;
+        continue;
+      }
+      if (Ptr[1] == '*') {
+        ++Ptr;
+        skipToEndOfSlashStarComment(Ptr, End);
+        IsAtStartOfLine = false;
+        continue;
+      }
+      break;
+    case '"':
+      Ptr = skipInactiveStringLiteral(Ptr, End);
+      IsAtStartOfLine = false;
+      continue;
+    default:
+      break;
+    }
+    IsAtStartOfLine = false;
+    ++Ptr;
+  }
+  return nullptr;
+}
+
+bool Lexer::lexIfConfigDirective(tok Kind, const char *TokStart) {
+  if (!IfConfigLangOpts || !NextToken.IsAtStartOfLine()) {
+    return false;
+  }
+
+  unsigned Depth = getIfConfigDepth();
+  if (Kind != tok::pound_if && Depth == 0) {
+    // There is no block to continue or close; drop the directive.
+    diagnose(TokStart, diag::lex_unexpected_if_config_directive,
+             StringRef(TokStart, CurPtr - TokStart));
+    skipToEndOfLine(/*EatNewline=*/false);
+    return true;
+  }
+
+  // Reaching '#elseif' or '#else' while lexing means the preceding clause was
+  // active, so every remaining clause up to '#endif' is skipped.
+  bool HasActiveClause = Kind != tok::pound_if;
+  while (true) {
+    bool IsActive = false;
+    if (Kind != tok::pound_endif && !HasActiveClause) {
+      IsActive = Kind == tok::pound_else || evaluateIfConfigCondition();
+    }
+    skipToEndOfLine(/*EatNewline=*/false);
+    if (IsActive) {
+      // The block stays open until its '#endif' is lexed.
+      IfConfigDepths.emplace_back(TokStart, Depth + 1);
+      return true;
+    }
+    if (Kind == tok::pound_endif) {
+      // A '#if' whose clauses were all skipped opens nothing.
+      if (HasActiveClause) {
+        IfConfigDepths.emplace_back(TokStart, Depth - 1);
+      }
+      return true;
+    }
+
+    const char *SkipStart = CurPtr;
+    const char *NextDirective = skipInactiveIfConfigClause(Kind);
+    const char *SkipEnd = NextDirective ? NextDirective : ArtificialEOF;
+
+    // The parser may backtrack over a directive; record each range once.
+    if (InactiveIfConfigRanges.empty() ||
+        InactiveIfConfigRanges.back().getStart().getOpaquePointerValue() <
+            SkipStart) {
+      InactiveIfConfigRanges.push_back(
+          CharSrcRange(getSrcLoc(SkipStart), SkipEnd - SkipStart));
+    }
+    if (!NextDirective) {
+      diagnose(TokStart, diag::lex_unterminated_if_config);
+      CurPtr = ArtificialEOF;
+      return true;
+    }
+    CurPtr = NextDirective + 1;
+    while (clang::isAsciiIdentifierContinue(*CurPtr)) {
+      ++CurPtr;
+    }
+  }
+}
+
 /// Is the operator beginning at the given character "left-bound"?
 static bool isLeftBound(const char *tokBegin, const char *bufferBegin) {
   // The first character in the file is not left-bound.
@@ -2408,6 +2744,7 @@ void Lexer::getStringLiteralSegments(const Token &Str,
 void Lexer::LexImpl() {
   assert(CurPtr >= BufferStart && CurPtr <= BufferEnd &&
          "Current pointer out of range!");
+  ++NumTokensLexed;
 
   // If we're re-lexing, clear out any previous diagnostics that weren't
   // emitted.
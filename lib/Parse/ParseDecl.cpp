@@ -33,19 +33,34 @@ bool Parser::ParseTopLevelDecls() {
     return (!result.IsError() && !HasError() && result.IsNonNull());
   };
 
+  // Hand the '#if' clauses skipped by the lexer and the syntax tree over to
+  // the source file.
+  auto CompletedTopLevelDecls = [&](bool status) -> bool {
+    for (auto range : GetLexer().getInactiveIfConfigRanges()) {
+      sourceFile.AddInactiveIfConfigRange(range);
+    }
+    if (syntaxTreeBuilder) {
+      sourceFile.SetSyntaxTree(syntaxTreeBuilder->Finish(astContext));
+      syntaxTreeBuilder.reset();
+    }
+    return status;
+  };
+
   while (IsTopLevelDeclParsing()) {
     ParsingDeclSpec spec(*this);
     spec.GetParsingDeclOptions().AddAllowTopLevel();
+    OpenSyntaxNode(SyntaxKind::TopLevelDecl);
     auto result = ParseTopLevelDecl(spec);
+    CloseSyntaxNode();
     if (!ParsedTopLevelDecl(result)) {
-      return false;
+      return CompletedTopLevelDecls(false);
     }
     if (HasCodeCompletionCallbacks()) {
       GetCodeCompletionCallbacks()->CompletedParseTopLevelDecl(result.Get());
     }
     AddTopLevelDecl(result);
   }
-  return true;
+  return CompletedTopLevelDecls(true);
 }
 
 ParserResult<Decl> Parser::ParseTopLevelDecl(ParsingDeclSpec &spec) {
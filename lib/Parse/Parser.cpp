@@ -10,14 +10,24 @@ Parser::Parser(SourceFile &sourceFile, ASTContext &astContext)
     : Parser(sourceFile, astContext,
              std::unique_ptr<Lexer>(
                  new Lexer(sourceFile.GetSrcID(), astContext.GetSrcMgr(),
-                           &astContext.GetDiags(), astContext.GetStats()))) {}
+                           &astContext.GetDiags(), astContext.GetStats(),
+                           sourceFile.ShouldEvaluatePoundIf()
+                               ? &astContext.GetLangOptions()
+                               : nullptr))) {}
 
 Parser::Parser(SourceFile &sourceFile, ASTContext &astContext,
                std::unique_ptr<Lexer> lx)
     : sourceFile(sourceFile), SM(astContext.GetSrcMgr()),
-      astContext(astContext), lexer(lx.release()), curDC(&sourceFile) {
+      astContext(astContext), lexer(lx.release()), curDC(&sourceFile),
+      parsedTokens(sourceFile.GetParsedTokenStorage()) {
 
   astContext.GetDiags().SetLexerBase(lexer.get());
+
+  if (sourceFile.GetParsingOptions().contains(
+          SourceFile::ParsingFlags::BuildSyntaxTree)) {
+    syntaxTreeBuilder.emplace(
+        SM.extractText(SM.getRangeForBuffer(sourceFile.GetSrcID())));
+  }
 }
 
 Parser::~Parser() {}
@@ -27,6 +37,9 @@ SrcLoc Parser::ConsumeToken(ParsingNotification notification) {
   auto loc = curTok.GetLoc();
   assert(curTok.IsNot(tok::eof) && "Lexing past eof!");
 
+  if ((parsedTokens || syntaxTreeBuilder) && curTok.IsNot(tok::LAST)) {
+    RecordParsedToken(curTok);
+  }
   if (notification == ParsingNotification::TokenConsumed) {
     if (HasCodeCompletionCallbacks()) {
       GetCodeCompletionCallbacks()->CompletedToken(&curTok);
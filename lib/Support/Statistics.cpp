@@ -281,17 +281,19 @@ StatsReporter::StatsReporter(
     llvm::StringRef InputName, llvm::StringRef TripleName,
     llvm::StringRef OutputType, llvm::StringRef OptType,
     llvm::StringRef Directory, SrcMgr *SM, clang::SourceManager *CSM,
-    bool TraceEvents, bool ProfileEvents, bool ProfileEntities)
+    bool TraceEvents, bool ProfileEvents, bool ProfileEntities,
+    bool WriteStatsFile)
     : StatsReporter(
           ProgramName,
           auxName(ModuleName, InputName, TripleName, OutputType, OptType),
-          Directory, SM, CSM, TraceEvents, ProfileEvents, ProfileEntities) {}
+          Directory, SM, CSM, TraceEvents, ProfileEvents, ProfileEntities,
+          WriteStatsFile) {}
 
 StatsReporter::StatsReporter(llvm::StringRef ProgramName,
                              llvm::StringRef AuxName, llvm::StringRef Directory,
                              SrcMgr *SM, clang::SourceManager *CSM,
                              bool TraceEvents, bool ProfileEvents,
-                             bool ProfileEntities)
+                             bool ProfileEntities, bool WriteStatsFile)
     : currentProcessExitStatusSet(false),
       currentProcessExitStatus(EXIT_FAILURE), StatsFilename(Directory),
       TraceFilename(Directory), ProfileDirname(Directory),
@@ -301,7 +303,7 @@ StatsReporter::StatsReporter(llvm::StringRef ProgramName,
                                                ProgramName, "Running Program")),
       SourceMgr(SM), ClangSourceMgr(CSM),
       RecursiveTimers(std::make_unique<RecursionSafeTimers>()),
-      IsFlushingTracesAndProfiles(false) {
+      IsFlushingTracesAndProfiles(false), WriteStatsFile(WriteStatsFile) {
   path::append(StatsFilename, makeStatsFileName(ProgramName, AuxName));
   path::append(TraceFilename, makeTraceFileName(ProgramName, AuxName));
   path::append(ProfileDirname, makeProfileDirName(ProgramName, AuxName));
@@ -569,6 +571,13 @@ void StatsReporter::saveAnyFrontendStatsEvents(FrontendStatsTracer const &T,
   Last = Curr;
 }
 
+void StatsReporter::printAlwaysOnStats(raw_ostream &OS) {
+  if (FrontendCounters) {
+    updateProcessWideFrontendCounters(getFrontendCounters());
+  }
+  printAlwaysOnStatsAndTimers(OS);
+}
+
 StatsReporter::TraceFormatter::~TraceFormatter() {}
 
 StatsReporter::~StatsReporter() {
@@ -613,6 +622,11 @@ StatsReporter::~StatsReporter() {
           (int64_t)(((double)C.NumSourceLines) / ElapsedTime.getProcessTime());
   }
 
+  if (!WriteStatsFile) {
+    flushTracesAndProfiles();
+    return;
+  }
+
   std::error_code EC;
   raw_fd_ostream ostream(StatsFilename, EC, fs::OF_Append | fs::OF_Text);
   if (EC) {
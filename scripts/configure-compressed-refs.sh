@@ -0,0 +1 @@
+cmake -G "Unix Makefiles" -DCMAKE_BUILD_TYPE=Debug -DSTONE_ENABLE_COMPRESSED_AST_REFS=ON ../llvm
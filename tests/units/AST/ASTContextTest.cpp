@@ -0,0 +1,101 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Types.h"
+
+using namespace stone;
+
+class ASTContextTest : public ASTTest {};
+
+TEST_F(ASTContextTest, TemporaryArenaIsReused) {
+  ASSERT_FALSE(astContext.HasTemporaryArena());
+  {
+    TemporaryArenaScope scope(astContext);
+    ASSERT_TRUE(astContext.HasTemporaryArena());
+    ASSERT_NE(nullptr, astContext.AllocateMemory(
+                           128, 8, MemoryAllocationArena::Temporary));
+  }
+  ASSERT_FALSE(astContext.HasTemporaryArena());
+  auto held = astContext.GetTemporaryMemoryAllocated();
+  ASSERT_NE(0u, held);
+
+  // Later scopes at the same depth take no new memory.
+  for (unsigned i = 0; i < 100; ++i) {
+    TemporaryArenaScope scope(astContext);
+    astContext.AllocateMemory(128, 8, MemoryAllocationArena::Temporary);
+  }
+  ASSERT_EQ(held, astContext.GetTemporaryMemoryAllocated());
+}
+
+TEST_F(ASTContextTest, TemporaryArenasNest) {
+  TemporaryArenaScope outer(astContext);
+  auto &outerArena = astContext.GetAllocator(MemoryAllocationArena::Temporary);
+  {
+    TemporaryArenaScope inner(astContext);
+    ASSERT_NE(&outerArena,
+              &astContext.GetAllocator(MemoryAllocationArena::Temporary));
+  }
+  ASSERT_EQ(&outerArena,
+            &astContext.GetAllocator(MemoryAllocationArena::Temporary));
+}
+
+TEST_F(ASTContextTest, PointerTypesAreUniqued) {
+  auto &builtin = astContext.GetBuiltin();
+  Type intType(builtin.BuiltinInt32Type);
+  Type boolType(builtin.BuiltinBoolType);
+
+  ASSERT_EQ(astContext.GetRawType(intType), astContext.GetRawType(intType));
+  ASSERT_NE(astContext.GetRawType(intType), astContext.GetRawType(boolType));
+  ASSERT_EQ(astContext.GetMoveType(intType), astContext.GetMoveType(intType));
+  ASSERT_EQ(astContext.GetRefType(intType), astContext.GetRefType(intType));
+
+  // Each pointer kind has its own table.
+  ASSERT_NE(static_cast<TypeBase *>(astContext.GetRawType(intType)),
+            static_cast<TypeBase *>(astContext.GetMoveType(intType)));
+  ASSERT_NE(static_cast<TypeBase *>(astContext.GetRawType(intType)),
+            static_cast<TypeBase *>(astContext.GetRefType(intType)));
+}
+
+TEST_F(ASTContextTest, FunTypesAreUniqued) {
+  auto &builtin = astContext.GetBuiltin();
+  Type voidType(builtin.BuiltinVoidType);
+  Type intType(builtin.BuiltinInt32Type);
+  Type boolType(builtin.BuiltinBoolType);
+
+  auto funType = astContext.GetFunType(voidType, {intType, boolType});
+  ASSERT_EQ(funType, astContext.GetFunType(voidType, {intType, boolType}));
+  ASSERT_NE(funType, astContext.GetFunType(voidType, {boolType, intType}));
+  ASSERT_NE(funType, astContext.GetFunType(voidType, {intType}));
+  ASSERT_NE(funType, astContext.GetFunType(intType, {intType, boolType}));
+  ASSERT_EQ(astContext.GetFunType(voidType, {}),
+            astContext.GetFunType(voidType, {}));
+}
+
+TEST_F(ASTContextTest, QualifiersMergeOntoTheBase) {
+  Type intType(astContext.GetBuiltin().BuiltinInt32Type);
+  auto constQuals = QualSpecs::GetFromOpaqueValue(QualSpecs::Const);
+  auto volatileQuals = QualSpecs::GetFromOpaqueValue(QualSpecs::Volatile);
+  auto bothQuals =
+      QualSpecs::GetFromOpaqueValue(QualSpecs::Const | QualSpecs::Volatile);
+
+  auto constType = astContext.GetQualifiedType(intType, constQuals);
+  ASSERT_EQ(constType.GetPtr(),
+            astContext.GetQualifiedType(intType, constQuals).GetPtr());
+  ASSERT_NE(intType.GetPtr(), constType.GetPtr());
+
+  // const volatile int, however it is spelled, is one node over int.
+  auto nested = astContext.GetQualifiedType(constType, volatileQuals);
+  auto flat = astContext.GetQualifiedType(intType, bothQuals);
+  ASSERT_EQ(flat.GetPtr(), nested.GetPtr());
+  auto qualifiedType = llvm::cast<QualifiedType>(nested.GetPtr());
+  ASSERT_EQ(intType.GetPtr(), qualifiedType->GetBaseType().GetPtr());
+  ASSERT_EQ(bothQuals.GetOpaqueValue(),
+            qualifiedType->GetQualSpecs().GetOpaqueValue());
+
+  // Adding what is already there, or nothing, adds no node.
+  ASSERT_EQ(constType.GetPtr(),
+            astContext.GetQualifiedType(constType, constQuals).GetPtr());
+  ASSERT_EQ(intType.GetPtr(),
+            astContext
+                .GetQualifiedType(intType, QualSpecs::GetFromOpaqueValue(0))
+                .GetPtr());
+}
@@ -0,0 +1,96 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/Types.h"
+#include "stone/Basic/MemoryCage.h"
+
+using namespace stone;
+
+// These hold in both layouts. Configure with STONE_ENABLE_COMPRESSED_AST_REFS
+// (scripts/configure-compressed-refs.sh) to run them over 32-bit offsets.
+class ASTRefTest : public ASTTest {
+protected:
+  Type intType;
+
+protected:
+  ASTRefTest() : intType(astContext.GetBuiltin().BuiltinInt32Type) {}
+};
+
+#ifdef STONE_COMPRESSED_AST_REFS
+static_assert(sizeof(ASTRef<TypeBase>) == sizeof(uint32_t),
+              "compressed references are offsets into the cage");
+#else
+static_assert(sizeof(ASTRef<TypeBase>) == sizeof(TypeBase *),
+              "references are plain pointers");
+#endif
+
+TEST_F(ASTRefTest, NullRoundTrips) {
+  ASTRef<TypeBase> ref;
+  ASSERT_TRUE(ref.IsNull());
+  ASSERT_EQ(nullptr, ref.Get(intType.GetPtr()));
+  ASSERT_TRUE(ASTRef<TypeBase>(nullptr).IsNull());
+}
+
+TEST_F(ASTRefTest, NodesRoundTrip) {
+  TypeBase *rawType = astContext.GetRawType(intType);
+  TypeBase *refType = astContext.GetRefType(intType);
+
+  // A reference decodes relative to any node of the same context.
+  ASTRef<TypeBase> ref(rawType);
+  ASSERT_FALSE(ref.IsNull());
+  ASSERT_EQ(rawType, ref.Get(rawType));
+  ASSERT_EQ(rawType, ref.Get(refType));
+  ASSERT_EQ(rawType, ref.Get(intType.GetPtr()));
+#ifdef STONE_COMPRESSED_AST_REFS
+  ASSERT_EQ(MemoryCage::GetBase(rawType), MemoryCage::GetBase(refType));
+#endif
+  ASSERT_EQ(&astContext, &rawType->GetASTContext());
+}
+
+TEST_F(ASTRefTest, RefsInTypesDecode) {
+  TypeBase *rawType = astContext.GetRawType(intType);
+  auto alias = new (astContext) AliasType(nullptr, rawType, astContext);
+
+  // The underlying type is held by the alias node.
+  ASSERT_EQ(rawType, alias->GetDesugaredType());
+  ASSERT_EQ(&astContext, &alias->GetASTContext());
+
+  // So is the cached canonical type, once it is written.
+  ASSERT_FALSE(alias->HasCanType());
+  ASSERT_EQ(rawType, alias->GetCanType().GetPtr());
+  ASSERT_TRUE(alias->HasCanType());
+  ASSERT_EQ(rawType, alias->GetCanType().GetPtr());
+
+  // And by a structural type over the alias.
+  auto aliasPointerType = astContext.GetRawType(alias);
+  ASSERT_EQ(astContext.GetRawType(rawType),
+            aliasPointerType->GetCanType().GetPtr());
+  ASSERT_EQ(astContext.GetRawType(rawType),
+            aliasPointerType->GetCanType().GetPtr());
+}
+
+TEST_F(ASTRefTest, RefsInDeclsDecode) {
+  auto moduleDecl =
+      ModuleDecl::Create(astContext.GetIdentifier("M"), astContext);
+  auto sourceFile = SourceFile::Create(SourceFileKind::Library, 0,
+                                       *moduleDecl, astContext);
+  moduleDecl->AddFile(*sourceFile);
+
+  auto structDecl = StructDecl::Create(DeclName(astContext.GetIdentifier("S")),
+                                       SrcLoc(), astContext, sourceFile);
+  sourceFile->AddTopLevelDecl(structDecl);
+
+  std::vector<Decl *> decls;
+  for (auto name : {"a", "b", "c"}) {
+    auto member =
+        StructDecl::Create(DeclName(astContext.GetIdentifier(name)),
+                           SrcLoc(), astContext, structDecl);
+    structDecl->AddMember(member);
+    decls.push_back(member);
+  }
+  // Each decl holds a reference to the one after it.
+  ASSERT_EQ(decls[1], decls[0]->GetNextDecl());
+  ASSERT_EQ(decls[2], decls[1]->GetNextDecl());
+  ASSERT_EQ(nullptr, decls[2]->GetNextDecl());
+}
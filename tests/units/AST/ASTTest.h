@@ -0,0 +1,34 @@
+#ifndef STONE_UNITTESTS_AST_ASTTEST_H
+#define STONE_UNITTESTS_AST_ASTTEST_H
+
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/ClangImporter.h"
+#include "stone/AST/Diagnostics.h"
+#include "stone/AST/SearchPath.h"
+#include "stone/AST/TypeCheckerOptions.h"
+#include "stone/Basic/LangOptions.h"
+#include "stone/Basic/SrcMgr.h"
+
+#include "gtest/gtest.h"
+
+namespace stone {
+
+/// A fixture that owns an ASTContext and everything it refers to.
+class ASTTest : public ::testing::Test {
+protected:
+  LangOptions langOpts;
+  SearchPathOptions searchPathOpts;
+  TypeCheckerOptions typeCheckerOpts;
+  ClangImporter clangImporter;
+  SrcMgr sm;
+  DiagnosticEngine de;
+  ASTContext astContext;
+
+protected:
+  ASTTest()
+      : de(sm), astContext(langOpts, searchPathOpts, typeCheckerOpts,
+                           clangImporter, de, nullptr) {}
+};
+
+} // namespace stone
+#endif
@@ -0,0 +1,95 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Availability.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/TypeChecker.h"
+
+using namespace stone;
+
+class AvailabilityTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+  StructDecl *structDecl;
+
+protected:
+  AvailabilityTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+    langOpts.DefaultTargetTriple = llvm::Triple("x86_64-apple-macosx10.9");
+
+    // struct S, available from 12 on.
+    structDecl = StructDecl::Create(DeclName(astContext.GetIdentifier("S")),
+                                    SrcLoc(), astContext, sourceFile);
+    sourceFile->AddTopLevelDecl(structDecl);
+    Annotate(structDecl, 12);
+  }
+
+  FunDecl *CreateFun(llvm::StringRef name, DeclContext *parent) {
+    return FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                           DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           Type(), parent);
+  }
+  FunDecl *CreateMember(llvm::StringRef name) {
+    auto funDecl = CreateFun(name, structDecl);
+    structDecl->AddMember(funDecl);
+    return funDecl;
+  }
+  void Annotate(Decl *decl, unsigned major) {
+    astContext.SetAnnotatedAvailability(
+        decl,
+        AvailabilityContext(VersionRange::allGTE(llvm::VersionTuple(major))));
+  }
+  static unsigned GetLowerMajor(const AvailabilityContext &available) {
+    return available.getOSVersion().getLowerEndpoint().getMajor();
+  }
+};
+
+TEST_F(AvailabilityTest, ContextsNarrowFromTheDeploymentTarget) {
+  auto plain = CreateMember("plain");
+  auto later = CreateMember("later");
+  Annotate(later, 13);
+
+  ASSERT_EQ(10u, GetLowerMajor(sourceFile->GetAvailabilityContext()));
+  ASSERT_EQ(12u, GetLowerMajor(structDecl->GetAvailabilityContext()));
+  ASSERT_EQ(12u, GetLowerMajor(plain->GetAvailabilityContext()));
+  ASSERT_EQ(13u, GetLowerMajor(later->GetAvailabilityContext()));
+}
+
+TEST_F(AvailabilityTest, ContextsAreRemembered) {
+  auto plain = CreateMember("plain");
+  auto &first = structDecl->GetAvailabilityContext();
+  ASSERT_EQ(&first, &structDecl->GetAvailabilityContext());
+
+  // A context that narrows nothing shares its parent's.
+  ASSERT_EQ(&first, &plain->GetAvailabilityContext());
+  ASSERT_EQ(&moduleDecl->GetAvailabilityContext(),
+            &sourceFile->GetAvailabilityContext());
+}
+
+TEST_F(AvailabilityTest, MemberMoreAvailableThanType) {
+  auto earlier = CreateMember("earlier");
+  Annotate(earlier, 11);
+  TypeChecker::CheckDecl(earlier);
+  ASSERT_TRUE(de.hadAnyError());
+}
+
+TEST_F(AvailabilityTest, MemberAsAvailableAsType) {
+  auto later = CreateMember("later");
+  Annotate(later, 13);
+  TypeChecker::CheckDecl(later);
+  TypeChecker::CheckDecl(structDecl);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(AvailabilityTest, BelowDeploymentTargetIsAllowed) {
+  auto old = CreateFun("old", sourceFile);
+  sourceFile->AddTopLevelDecl(old);
+  Annotate(old, 9);
+  TypeChecker::CheckDecl(old);
+  ASSERT_FALSE(de.hadAnyError());
+}
@@ -0,0 +1,77 @@
+#include "ASTTest.h"
+
+#include "stone/AST/ConformanceTable.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/Types.h"
+
+using namespace stone;
+
+class ConformanceTableTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  ConformanceTableTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  template <typename DeclTy> DeclTy *Create(llvm::StringRef name) {
+    auto decl = DeclTy::Create(DeclName(astContext.GetIdentifier(name)),
+                               SrcLoc(), astContext, sourceFile);
+    sourceFile->AddTopLevelDecl(decl);
+    return decl;
+  }
+};
+
+TEST_F(ConformanceTableTest, DeclaredTypeKnowsItsDecl) {
+  auto structDecl = Create<StructDecl>("S");
+  auto structType = structDecl->GetDeclaredType();
+  ASSERT_TRUE(llvm::isa<StructType>(structType));
+  ASSERT_EQ(structDecl, structType->GetDecl());
+  ASSERT_EQ(structType, structDecl->GetDeclaredType());
+
+  auto interfaceDecl = Create<InterfaceDecl>("I");
+  ASSERT_TRUE(llvm::isa<InterfaceType>(interfaceDecl->GetDeclaredType()));
+  ASSERT_EQ(interfaceDecl, interfaceDecl->GetDeclaredType()->GetDecl());
+}
+
+TEST_F(ConformanceTableTest, ImpliedInterfaces) {
+  auto base = Create<InterfaceDecl>("Base");
+  auto derived = Create<InterfaceDecl>("Derived");
+  derived->AddInheritedInterface(base, derived);
+  auto structDecl = Create<StructDecl>("S");
+  structDecl->AddInheritedInterface(derived, structDecl);
+
+  auto entry = structDecl->LookupConformance(base);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_EQ(derived, entry->impliedBy);
+  ASSERT_EQ(structDecl, entry->declaredIn);
+  ASSERT_FALSE(structDecl->LookupConformance(derived)->IsImplied());
+
+  Type structType(structDecl->GetDeclaredType());
+  ASSERT_TRUE(astContext.ConformsTo(structType, base));
+  ASSERT_TRUE(astContext.ConformsTo(structType, derived));
+  ASSERT_FALSE(astContext.ConformsTo(Type(base->GetDeclaredType()), derived));
+}
+
+TEST_F(ConformanceTableTest, InterfaceChangeReachesOtherTables) {
+  auto base = Create<InterfaceDecl>("Base");
+  auto derived = Create<InterfaceDecl>("Derived");
+  auto structDecl = Create<StructDecl>("S");
+  structDecl->AddInheritedInterface(derived, structDecl);
+
+  Type structType(structDecl->GetDeclaredType());
+  ASSERT_FALSE(astContext.ConformsTo(structType, base));
+  ASSERT_EQ(nullptr, structDecl->LookupConformance(base));
+
+  // Derived changes, not S, yet S now conforms to Base.
+  derived->AddInheritedInterface(base, derived);
+  ASSERT_NE(nullptr, structDecl->LookupConformance(base));
+  ASSERT_TRUE(astContext.ConformsTo(structType, base));
+}
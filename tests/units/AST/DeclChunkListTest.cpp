@@ -0,0 +1,88 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/DeclChunkList.h"
+#include "stone/AST/Module.h"
+
+using namespace stone;
+
+class DeclChunkListTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  DeclChunkListTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  FunDecl *CreateFun(llvm::StringRef name, DeclContext *parent) {
+    return FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                           DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           Type(), parent);
+  }
+  template <typename DeclTy>
+  DeclTy *Create(llvm::StringRef name, DeclContext *parent) {
+    return DeclTy::Create(DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                          astContext, parent);
+  }
+  template <typename RangeTy> static std::string Names(RangeTy &&decls) {
+    std::string names;
+    for (auto decl : decls) {
+      names += decl->GetBasicNameText();
+    }
+    return names;
+  }
+};
+
+TEST_F(DeclChunkListTest, KindsKeepSourceOrder) {
+  // struct S { fun a; struct B; fun c; class D; fun e }
+  auto structDecl = Create<StructDecl>("S", sourceFile);
+  sourceFile->AddTopLevelDecl(structDecl);
+  structDecl->AddMember(CreateFun("a", structDecl));
+  structDecl->AddMember(Create<StructDecl>("B", structDecl));
+  structDecl->AddMember(CreateFun("c", structDecl));
+  structDecl->AddMember(Create<ClassDecl>("D", structDecl));
+  structDecl->AddMember(CreateFun("e", structDecl));
+
+  ASSERT_EQ("ace", Names(structDecl->GetDecls(DeclKind::Fun)));
+  ASSERT_EQ("ace", Names(structDecl->GetFunctionDecls()));
+  ASSERT_EQ("B", Names(structDecl->GetDecls(DeclKind::Struct)));
+  ASSERT_TRUE(structDecl->GetDecls(DeclKind::Interface).empty());
+
+  // Grouped by kind, in DeclKind order: structs before classes.
+  ASSERT_EQ("BD", Names(structDecl->GetNominalTypeDecls()));
+
+  ASSERT_EQ("S", Names(sourceFile->GetNominalTypeDecls()));
+  ASSERT_TRUE(sourceFile->GetFunctionDecls().empty());
+}
+
+TEST_F(DeclChunkListTest, ChunksGrowGeometrically) {
+  DeclChunkList list;
+  std::string expected;
+  for (unsigned i = 0; i < 13; ++i) {
+    auto name = std::string(1, 'a' + i);
+    list.AddDecl(CreateFun(name, sourceFile), astContext);
+    expected += name;
+  }
+  list.AddDecl(Create<StructDecl>("S", sourceFile), astContext);
+
+  std::vector<std::pair<unsigned, unsigned>> chunks;
+  for (auto chunk = list.GetFirstChunk(DeclKind::Fun); chunk;
+       chunk = chunk->next) {
+    chunks.push_back({chunk->size, chunk->capacity});
+  }
+  std::vector<std::pair<unsigned, unsigned>> expectedChunks = {
+      {4, 4}, {8, 8}, {1, 16}};
+  ASSERT_EQ(expectedChunks, chunks);
+
+  ASSERT_EQ(expected, Names(DeclKindRange<>(&list, DeclKind::Fun,
+                                            DeclKind::Fun)));
+  // Only the kinds with members are kept.
+  ASSERT_EQ(2u, list.GetKinds(DeclKind::Struct, DeclKind::Fun).size());
+  ASSERT_EQ(nullptr, list.GetFirstChunk(DeclKind::Interface));
+}
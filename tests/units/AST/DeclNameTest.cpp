@@ -0,0 +1,63 @@
+#include "ASTTest.h"
+
+#include "stone/AST/DeclName.h"
+
+using namespace stone;
+
+class DeclNameTest : public ASTTest {
+protected:
+  DeclName RoundTrip(DeclName name) {
+    return DeclName::GetFromOpaqueValue(name.GetOpaqueValue());
+  }
+};
+
+TEST_F(DeclNameTest, DefaultIsBasic) {
+  DeclName name;
+  ASSERT_EQ(DeclNameKind::Basic, name.GetKind());
+  ASSERT_FALSE(name.GetDeclNameBase().IsValid());
+}
+
+TEST_F(DeclNameTest, RoundTripThroughOpaqueValue) {
+  auto plus = astContext.GetIdentifier("+");
+  auto f = astContext.GetIdentifier("f");
+  auto x = astContext.GetIdentifier("x");
+
+  DeclName basicName(f);
+  auto compoundName = astContext.GetCompoundName(f, {x});
+  auto operatorName =
+      astContext.GetSpecialName(DeclNameKind::Operator, plus);
+
+  ASSERT_EQ(basicName, RoundTrip(basicName));
+  ASSERT_EQ(DeclNameKind::Basic, RoundTrip(basicName).GetKind());
+  ASSERT_EQ(compoundName, RoundTrip(compoundName));
+  ASSERT_EQ(DeclNameKind::Compound, RoundTrip(compoundName).GetKind());
+  ASSERT_EQ(operatorName, RoundTrip(operatorName));
+  ASSERT_EQ(DeclNameKind::Operator, RoundTrip(operatorName).GetKind());
+  ASSERT_TRUE(RoundTrip(operatorName).IsSpecial());
+}
+
+TEST_F(DeclNameTest, NamesAreUniqued) {
+  auto f = astContext.GetIdentifier("f");
+  auto x = astContext.GetIdentifier("x");
+
+  ASSERT_EQ(astContext.GetCompoundName(f, {x}),
+            astContext.GetCompoundName(f, {x}));
+  ASSERT_EQ(astContext.GetSpecialName(DeclNameKind::Operator, f),
+            astContext.GetSpecialName(DeclNameKind::Operator, f));
+
+  // The same text with another kind is another name.
+  ASSERT_NE(DeclName(f), astContext.GetCompoundName(f, {}));
+  ASSERT_NE(astContext.GetSpecialName(DeclNameKind::Operator, f),
+            astContext.GetSpecialName(DeclNameKind::LiteralOperator, f));
+  ASSERT_NE(astContext.GetCompoundName(f, {}),
+            astContext.GetSpecialName(DeclNameKind::Operator, f));
+}
+
+TEST_F(DeclNameTest, CompoundNameIsNotSpecial) {
+  auto f = astContext.GetIdentifier("f");
+  auto x = astContext.GetIdentifier("x");
+  auto compoundName = astContext.GetCompoundName(f, {x});
+  ASSERT_TRUE(compoundName.IsCompound());
+  ASSERT_FALSE(compoundName.IsSpecial());
+  ASSERT_EQ(f, compoundName.GetDeclNameBaseIdentifier());
+}
@@ -0,0 +1,117 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Evaluator.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/TypeCheckRequests.h"
+
+using namespace stone;
+
+namespace {
+/// Asks the same request of the decl its subject follows, so that a loop of
+/// decls is a cycle of requests. The answer is the length of the chain. It
+/// borrows the kind of a real request, which these tests never ask.
+class FollowRequest final
+    : public SimpleRequest<FollowRequest, unsigned, Decl> {
+public:
+  static constexpr RequestKind kind = RequestKind::TypeCheckDecl;
+  using SimpleRequest::SimpleRequest;
+
+  static llvm::DenseMap<Decl *, Decl *> follows;
+
+  unsigned Evaluate(Evaluator &evaluator) const {
+    auto found = follows.find(GetSubject());
+    if (found == follows.end()) {
+      return 1;
+    }
+    return evaluator(FollowRequest(found->second)) + 1;
+  }
+};
+llvm::DenseMap<Decl *, Decl *> FollowRequest::follows;
+} // namespace
+
+class EvaluatorTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  EvaluatorTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+  ~EvaluatorTest() { FollowRequest::follows.clear(); }
+
+  FunDecl *CreateFun(llvm::StringRef name, DeclContext *parent) {
+    return FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                           DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           Type(), parent);
+  }
+  static Evaluator::RequestKey GetKey(Decl *decl) {
+    return {static_cast<unsigned>(RequestKind::TypeCheckDecl), decl};
+  }
+};
+
+TEST_F(EvaluatorTest, RecordsDependencies) {
+  auto a = CreateFun("a", sourceFile);
+  auto b = CreateFun("b", sourceFile);
+  auto c = CreateFun("c", sourceFile);
+  FollowRequest::follows[a] = b;
+  FollowRequest::follows[b] = c;
+
+  auto &evaluator = astContext.GetEvaluator();
+  ASSERT_EQ(3u, evaluator(FollowRequest(a)));
+  ASSERT_EQ((std::vector<Evaluator::RequestKey>{GetKey(b)}),
+            evaluator.GetDependencies(FollowRequest(a)).vec());
+  ASSERT_EQ((std::vector<Evaluator::RequestKey>{GetKey(c)}),
+            evaluator.GetDependencies(FollowRequest(b)).vec());
+  ASSERT_TRUE(evaluator.GetDependencies(FollowRequest(c)).empty());
+
+  // Asking again is a lookup.
+  ASSERT_EQ(2u, evaluator(FollowRequest(b)));
+  auto &counters = evaluator.GetCounters(RequestKind::TypeCheckDecl);
+  ASSERT_EQ(3u, counters.evaluations);
+  ASSERT_EQ(1u, counters.cacheHits);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(EvaluatorTest, CycleIsDiagnosed) {
+  auto a = CreateFun("a", sourceFile);
+  auto b = CreateFun("b", sourceFile);
+  FollowRequest::follows[a] = b;
+  FollowRequest::follows[b] = a;
+
+  // b gets the cycle result for a, 0, and answers 1.
+  auto &evaluator = astContext.GetEvaluator();
+  ASSERT_EQ(2u, evaluator(FollowRequest(a)));
+  ASSERT_TRUE(de.hadAnyError());
+  ASSERT_EQ(1u, evaluator(FollowRequest(b)));
+}
+
+TEST_F(EvaluatorTest, OverriddenDeclInJoin) {
+  auto base = ClassDecl::Create(DeclName(astContext.GetIdentifier("Base")),
+                                SrcLoc(), astContext, sourceFile);
+  auto baseF = CreateFun("f", base);
+  baseF->SetVirtual();
+  base->AddMember(baseF);
+
+  auto derived = ClassDecl::Create(
+      DeclName(astContext.GetIdentifier("Derived")), SrcLoc(), astContext,
+      sourceFile);
+  derived->SetSuperclass(base);
+
+  // Joins have no decl yet; a plain context holds their members.
+  DeclContext join(DeclContextKind::None, sourceFile);
+  derived->AddJoin(&join);
+  auto derivedF = CreateFun("f", &join);
+  derivedF->SetVirtual();
+  join.AddDecl(derivedF);
+  ASSERT_EQ(derived, join.GetSelfNominalTypeDecl());
+
+  auto &evaluator = astContext.GetEvaluator();
+  ASSERT_EQ(baseF, evaluator(OverriddenDeclRequest(derivedF)));
+  ASSERT_EQ(nullptr, evaluator(OverriddenDeclRequest(baseF)));
+}
@@ -0,0 +1,48 @@
+#include "ASTTest.h"
+
+#include "stone/AST/ImportCache.h"
+#include "stone/AST/Module.h"
+
+using namespace stone;
+
+class ImportCacheTest : public ASTTest {
+protected:
+  ModuleDecl *CreateModule(llvm::StringRef name) {
+    return ModuleDecl::Create(astContext.GetIdentifier(name), astContext);
+  }
+};
+
+TEST_F(ImportCacheTest, AddImportInvalidatesSets) {
+  auto a = CreateModule("A");
+  auto b = CreateModule("B");
+  auto c = CreateModule("C");
+  a->AddImport(ImportedModule(b));
+
+  auto &importCache = astContext.GetImportCache();
+  ASSERT_TRUE(importCache.IsImportedBy(b, a));
+  ASSERT_FALSE(importCache.IsImportedBy(c, a));
+
+  // A module that A reaches gains an import after A was queried.
+  b->AddImport(ImportedModule(c));
+  ASSERT_TRUE(importCache.IsImportedBy(c, a));
+}
+
+TEST_F(ImportCacheTest, ImportSetOwnsAccessPath) {
+  auto a = CreateModule("A");
+  ImportSet *importSet = nullptr;
+  {
+    Identifier path[] = {astContext.GetIdentifier("T")};
+    importSet =
+        &astContext.GetImportCache().GetImportSet(astContext,
+                                                  ImportedModule(a, path));
+    ASSERT_NE(path, importSet->GetTopLevelImports()[0].accessPath.data());
+  }
+  auto accessPath = importSet->GetTopLevelImports()[0].accessPath;
+  ASSERT_EQ(1u, accessPath.size());
+  ASSERT_EQ(astContext.GetIdentifier("T"), accessPath[0]);
+
+  // The same import from a different buffer finds the same set.
+  Identifier path[] = {astContext.GetIdentifier("T")};
+  ASSERT_EQ(importSet, &astContext.GetImportCache().GetImportSet(
+                           astContext, ImportedModule(a, path)));
+}
@@ -0,0 +1,89 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Mangle.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/Types.h"
+
+using namespace stone;
+
+class MangleTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  MangleTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("mod"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  FunDecl *CreateFun(llvm::StringRef name, llvm::ArrayRef<Type> paramTypes,
+                     DeclContext *parent) {
+    auto funType = astContext.GetFunType(
+        Type(astContext.GetBuiltin().BuiltinVoidType), paramTypes);
+    return FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                           DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           Type(funType), parent);
+  }
+  FunDecl *AddFun(llvm::StringRef name, llvm::ArrayRef<Type> paramTypes = {}) {
+    auto funDecl = CreateFun(name, paramTypes, sourceFile);
+    sourceFile->AddTopLevelDecl(funDecl);
+    return funDecl;
+  }
+  StructDecl *CreateStruct(llvm::StringRef name, DeclContext *parent) {
+    return StructDecl::Create(DeclName(astContext.GetIdentifier(name)),
+                              SrcLoc(), astContext, parent);
+  }
+  std::string Mangle(ValueDecl *decl) {
+    llvm::SmallString<64> out;
+    ItaniumMangleContext(astContext).MangleName(decl, out);
+    return out.str().str();
+  }
+};
+
+TEST_F(MangleTest, NestedName) {
+  ASSERT_EQ("_ZN3mod3fooEv", Mangle(AddFun("foo")));
+
+  auto &builtin = astContext.GetBuiltin();
+  ASSERT_EQ("_ZN3mod3barEib",
+            Mangle(AddFun("bar", {Type(builtin.BuiltinInt32Type),
+                                  Type(builtin.BuiltinBoolType)})));
+}
+
+TEST_F(MangleTest, BackReferences) {
+  // The module is S_ and the struct S0_.
+  auto structDecl = CreateStruct("S", sourceFile);
+  sourceFile->AddTopLevelDecl(structDecl);
+  Type structType(structDecl->GetDeclaredType());
+  ASSERT_EQ("_ZN3mod1fENS_1SES0_",
+            Mangle(AddFun("f", {structType, structType})));
+
+  // A repeated structural type is a candidate too.
+  Type pointerType(astContext.GetRawType(structType));
+  ASSERT_EQ("_ZN3mod1gEPNS_1SES1_",
+            Mangle(AddFun("g", {pointerType, pointerType})));
+}
+
+TEST_F(MangleTest, LocalTypesAreNamedByTheirFunction) {
+  auto g = AddFun("g");
+  auto k = AddFun("k");
+  auto inG = CreateStruct("L", g);
+  auto inK = CreateStruct("L", k);
+  auto hInG = CreateFun("h", {}, inG);
+  auto hInK = CreateFun("h", {}, inK);
+  inG->AddMember(hInG);
+  inK->AddMember(hInK);
+  ASSERT_EQ("_ZZN3mod1gEvEN1L1hEv", Mangle(hInG));
+  ASSERT_EQ("_ZZN3mod1kEvEN1L1hEv", Mangle(hInK));
+}
+
+TEST_F(MangleTest, MangledNamesAreRemembered) {
+  auto foo = AddFun("foo");
+  auto name = astContext.GetMangledName(foo);
+  ASSERT_EQ("_ZN3mod3fooEv", name);
+  ASSERT_EQ(name.data(), astContext.GetMangledName(foo).data());
+}
@@ -0,0 +1,77 @@
+#include "ASTTest.h"
+
+#include "stone/AST/ASTScope.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/NameLookup.h"
+
+using namespace stone;
+
+class NameLookupTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  ASTScope fileScope;
+  ASTScope bodyScope;
+  NameLookup nameLookup;
+
+protected:
+  NameLookupTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        fileScope(ASTScopeKind::File, de),
+        bodyScope(ASTScopeKind::FunctionBody, de, &fileScope),
+        nameLookup(astContext) {}
+
+  FunDecl *CreateFun(llvm::StringRef name) {
+    return FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                           DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           Type(), moduleDecl);
+  }
+  DeclNameBase GetName(llvm::StringRef name) {
+    return DeclNameBase(astContext.GetIdentifier(name));
+  }
+};
+
+TEST_F(NameLookupTest, AddDeclInvalidatesCachedResult) {
+  auto outer = CreateFun("f");
+  fileScope.AddDecl(outer);
+
+  auto results = nameLookup.LookupUnqualified(GetName("f"), &bodyScope);
+  ASSERT_EQ(1u, results.size());
+  ASSERT_EQ(outer, results[0]);
+
+  // A decl added to the inner scope shadows the cached outer one.
+  auto inner = CreateFun("f");
+  bodyScope.AddDecl(inner);
+  results = nameLookup.LookupUnqualified(GetName("f"), &bodyScope);
+  ASSERT_EQ(1u, results.size());
+  ASSERT_EQ(inner, results[0]);
+
+  bodyScope.RemoveDecl(inner);
+  results = nameLookup.LookupUnqualified(GetName("f"), &bodyScope);
+  ASSERT_EQ(1u, results.size());
+  ASSERT_EQ(outer, results[0]);
+}
+
+TEST_F(NameLookupTest, ParentChangeInvalidatesCachedResult) {
+  ASSERT_TRUE(nameLookup.LookupUnqualified(GetName("g"), &bodyScope).empty());
+
+  auto g = CreateFun("g");
+  fileScope.AddDecl(g);
+  auto results = nameLookup.LookupUnqualified(GetName("g"), &bodyScope);
+  ASSERT_EQ(1u, results.size());
+  ASSERT_EQ(g, results[0]);
+}
+
+TEST_F(NameLookupTest, ResultsInDeclarationOrder) {
+  llvm::SmallVector<FunDecl *, 8> overloads;
+  for (unsigned i = 0; i < 8; ++i) {
+    overloads.push_back(CreateFun("h"));
+    fileScope.AddDecl(overloads.back());
+  }
+  auto results = nameLookup.LookupUnqualified(GetName("h"), &fileScope);
+  ASSERT_EQ(overloads.size(), results.size());
+  for (unsigned i = 0; i < overloads.size(); ++i) {
+    EXPECT_EQ(overloads[i], results[i]) << i;
+  }
+}
@@ -0,0 +1,142 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/ParallelASTWalker.h"
+#include "stone/AST/Stmt.h"
+
+using namespace stone;
+
+namespace {
+/// Records the decls and bodies it sees, in the order it sees them.
+class RecordingWalker final : public ASTWalker {
+public:
+  std::vector<std::string> names;
+  unsigned numBodies = 0;
+  unsigned numBodiesPosted = 0;
+
+  /// Abort after the decl with this name.
+  llvm::StringRef abortAfter;
+  /// Do not walk into bodies.
+  bool skipBodies = false;
+
+public:
+  std::pair<bool, Stmt *> WalkToStmtPre(Stmt *S) override {
+    ++numBodies;
+    return {!skipBodies, S};
+  }
+  Stmt *WalkToStmtPost(Stmt *S) override {
+    ++numBodiesPosted;
+    return S;
+  }
+  bool WalkToDeclPost(Decl *D) override {
+    names.push_back(D->GetBasicNameText().str());
+    return D->GetBasicNameText() != abortAfter;
+  }
+};
+} // namespace
+
+class ParallelASTWalkTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  ParallelASTWalkTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  FunDecl *CreateFun(llvm::StringRef name, DeclContext *parent) {
+    auto funDecl = FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                                   DeclName(astContext.GetIdentifier(name)),
+                                   SrcLoc(), Type(), parent);
+    funDecl->SetBody(BraceStmt::Create(SrcLoc(), {}, SrcLoc(), astContext),
+                     FunctionDecl::BodyStatus::Parsed);
+    return funDecl;
+  }
+
+  /// fun f; struct S { fun a; fun b; fun c }; fun g
+  void BuildModule() {
+    sourceFile->AddTopLevelDecl(CreateFun("f", sourceFile));
+    auto structDecl = StructDecl::Create(
+        DeclName(astContext.GetIdentifier("S")), SrcLoc(), astContext,
+        sourceFile);
+    for (auto name : {"a", "b", "c"}) {
+      structDecl->AddMember(CreateFun(name, structDecl));
+    }
+    sourceFile->AddTopLevelDecl(structDecl);
+    sourceFile->AddTopLevelDecl(CreateFun("g", sourceFile));
+  }
+
+  std::vector<std::string> Reduce(unsigned chunkSize) {
+    ParallelASTWalk walk(*moduleDecl, chunkSize);
+    auto walkers = walk.Walk<RecordingWalker>(
+        [] { return std::make_unique<RecordingWalker>(); });
+    std::vector<std::string> names;
+    for (auto &walker : walkers) {
+      names.insert(names.end(), walker->names.begin(), walker->names.end());
+    }
+    return names;
+  }
+};
+
+TEST_F(ParallelASTWalkTest, FansOutMemberFunctions) {
+  BuildModule();
+  ParallelASTWalk walk(*moduleDecl, 1);
+  ASSERT_EQ(6u, walk.GetNumDecls());
+  ASSERT_EQ(6u, walk.GetNumChunks());
+
+  auto walkers = walk.Walk<RecordingWalker>(
+      [] { return std::make_unique<RecordingWalker>(); });
+  unsigned numBodies = 0;
+  for (auto &walker : walkers) {
+    numBodies += walker->numBodies;
+  }
+  // Every function body once; the struct itself has none.
+  ASSERT_EQ(5u, numBodies);
+}
+
+TEST_F(ParallelASTWalkTest, ReductionDoesNotDependOnChunkSize) {
+  BuildModule();
+  std::vector<std::string> expected = {"f", "S", "a", "b", "c", "g"};
+  for (unsigned chunkSize : {1U, 2U, 4U, ParallelASTWalk::DefaultChunkSize}) {
+    for (unsigned run = 0; run < 8; ++run) {
+      ASSERT_EQ(expected, Reduce(chunkSize)) << chunkSize;
+    }
+  }
+}
+
+TEST_F(ParallelASTWalkTest, AbortPropagates) {
+  BuildModule();
+  ParallelASTWalk walk(*moduleDecl, 2);
+  std::vector<RecordingWalker> walkers(walk.GetNumChunks());
+  for (auto &walker : walkers) {
+    walker.abortAfter = "a";
+  }
+  ASSERT_TRUE(walk.Run([&](unsigned chunk) -> ASTWalker & {
+    return walkers[chunk];
+  }));
+  // The chunk that aborted stops at the decl that aborted.
+  ASSERT_EQ((std::vector<std::string>{"a"}), walkers[1].names);
+
+  // Nothing aborts when no decl asks to.
+  std::vector<RecordingWalker> others(walk.GetNumChunks());
+  ASSERT_FALSE(walk.Run([&](unsigned chunk) -> ASTWalker & {
+    return others[chunk];
+  }));
+}
+
+TEST_F(ParallelASTWalkTest, SkippedBodyIsNotPosted) {
+  sourceFile->AddTopLevelDecl(CreateFun("f", sourceFile));
+  ParallelASTWalk walk(*moduleDecl);
+  RecordingWalker walker;
+  walker.skipBodies = true;
+  ASSERT_FALSE(walk.Run([&](unsigned) -> ASTWalker & { return walker; }));
+  ASSERT_EQ(1u, walker.numBodies);
+  ASSERT_EQ(0u, walker.numBodiesPosted);
+  ASSERT_EQ((std::vector<std::string>{"f"}), walker.names);
+}
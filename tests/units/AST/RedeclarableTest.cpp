@@ -0,0 +1,72 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/Stmt.h"
+
+using namespace stone;
+
+class RedeclarableTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  RedeclarableTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  FunDecl *AddFun(llvm::StringRef name, bool hasBody) {
+    auto funDecl = FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                                   DeclName(astContext.GetIdentifier(name)),
+                                   SrcLoc(), Type(), sourceFile);
+    if (hasBody) {
+      funDecl->SetBody(BraceStmt::Create(SrcLoc(), {}, SrcLoc(), astContext),
+                       FunctionDecl::BodyStatus::Parsed);
+    }
+    sourceFile->AddTopLevelDecl(funDecl);
+    return funDecl;
+  }
+};
+
+// The decls of tests/syntax/forward.stone, in source order:
+//
+//   internal forward fun Lanuch() -> bool;
+//   public fun TryLaunch() -> bool { ... }
+//   public fun Lanuch() -> void {}
+TEST_F(RedeclarableTest, ForwardDeclarationStartsTheChain) {
+  auto forward = AddFun("Lanuch", /*hasBody=*/false);
+  auto tryLaunch = AddFun("TryLaunch", /*hasBody=*/true);
+  auto definition = AddFun("Lanuch", /*hasBody=*/true);
+
+  ASSERT_TRUE(forward->IsFirstRedecl());
+  ASSERT_EQ(forward, definition->GetPreviousRedecl());
+  ASSERT_EQ(forward, definition->GetFirstRedecl());
+  ASSERT_EQ(definition, forward->GetMostRecentRedecl());
+
+  std::vector<FunctionDecl *> redecls(forward->GetRedecls().begin(),
+                                      forward->GetRedecls().end());
+  ASSERT_EQ((std::vector<FunctionDecl *>{forward, definition}), redecls);
+
+  // A function declared once has no chain.
+  ASSERT_TRUE(tryLaunch->IsFirstRedecl());
+  ASSERT_EQ(tryLaunch, tryLaunch->GetMostRecentRedecl());
+  ASSERT_EQ(1, std::distance(tryLaunch->GetRedecls().begin(),
+                             tryLaunch->GetRedecls().end()));
+}
+
+TEST_F(RedeclarableTest, LaterRedeclarationsJoinTheSameChain) {
+  auto first = AddFun("f", /*hasBody=*/false);
+  auto second = AddFun("f", /*hasBody=*/false);
+  auto third = AddFun("f", /*hasBody=*/true);
+
+  ASSERT_EQ(second, third->GetPreviousRedecl());
+  ASSERT_EQ(first, third->GetFirstRedecl());
+  for (auto decl : {first, second, third}) {
+    ASSERT_EQ(third, decl->GetMostRecentRedecl());
+  }
+}
@@ -0,0 +1,82 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/SerializedModule.h"
+#include "stone/AST/Types.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace stone;
+
+class SerializedModuleTest : public ASTTest {
+protected:
+  llvm::SmallString<128> path;
+
+protected:
+  ~SerializedModuleTest() {
+    if (!path.empty()) {
+      llvm::sys::fs::remove(path);
+    }
+  }
+
+  /// Write a module with the functions \p names, all of type (int32) -> int32.
+  void WriteModule(llvm::ArrayRef<llvm::StringRef> names) {
+    auto module =
+        ModuleDecl::Create(astContext.GetIdentifier("Lib"), astContext);
+    auto sourceFile =
+        SourceFile::Create(SourceFileKind::Library, 0, *module, astContext);
+    module->AddFile(*sourceFile);
+
+    Type intType(astContext.GetBuiltin().BuiltinInt32Type);
+    Type funType(astContext.GetFunType(intType, {intType}));
+    for (auto name : names) {
+      auto funDecl = FunDecl::Create(
+          astContext, SrcLoc(), SrcLoc(),
+          DeclName(astContext.GetIdentifier(name)), SrcLoc(), funType,
+          sourceFile);
+      funDecl->SetVisibilityLevel(VisibilityLevel::Public);
+      sourceFile->AddTopLevelDecl(funDecl);
+    }
+
+    int fd;
+    ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("SerializedModuleTest",
+                                                    "stonemodule", fd, path));
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    SerializeModule(*module, os);
+  }
+};
+
+TEST_F(SerializedModuleTest, RoundTrip) {
+  WriteModule({"Add", "Sub", "Add"});
+
+  auto loaded = astContext.LoadSerializedModule(path);
+  ASSERT_NE(nullptr, loaded);
+  ASSERT_EQ("Lib", loaded->GetBasicName().GetString());
+  auto file = llvm::cast<SerializedModuleFile>(loaded->GetFiles().front());
+  ASSERT_EQ(3u, file->GetNumDecls());
+  ASSERT_EQ(0u, file->GetNumDeclsLoaded());
+
+  // Only the decls that are looked up are materialized.
+  llvm::SmallVector<ValueDecl *, 2> results;
+  loaded->LookupValue(astContext.GetIdentifier("Add"), results);
+  ASSERT_EQ(2u, results.size());
+  ASSERT_EQ(2u, file->GetNumDeclsLoaded());
+  for (auto result : results) {
+    ASSERT_TRUE(llvm::isa<FunDecl>(result));
+    ASSERT_EQ("Add", result->GetBasicName().GetString());
+    ASSERT_EQ(VisibilityLevel::Public, result->GetVisibilityLevel());
+    auto funType = llvm::dyn_cast<FunType>(result->GetType().GetPtr());
+    ASSERT_NE(nullptr, funType);
+    ASSERT_EQ(1u, funType->GetParamTypes().size());
+  }
+
+  // Types are uniqued in the context, so both decls share one.
+  ASSERT_EQ(results[0]->GetType().GetPtr(), results[1]->GetType().GetPtr());
+
+  results.clear();
+  loaded->LookupValue(astContext.GetIdentifier("Mul"), results);
+  ASSERT_TRUE(results.empty());
+}
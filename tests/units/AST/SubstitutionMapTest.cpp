@@ -0,0 +1,113 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/SubstitutionMap.h"
+#include "stone/AST/Types.h"
+#include "stone/Support/Statistics.h"
+
+#include "llvm/Support/FileSystem.h"
+
+using namespace stone;
+
+class SubstitutionMapTest : public ASTTest {
+protected:
+  llvm::SmallString<128> statsDir;
+  std::unique_ptr<StatsReporter> stats;
+
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+  /// Stand-ins for template parameters T and U.
+  Type paramT;
+  Type paramU;
+  Type intType;
+  Type boolType;
+
+protected:
+  SubstitutionMapTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+    paramT = CreateStructType("T");
+    paramU = CreateStructType("U");
+    intType = astContext.GetBuiltin().BuiltinInt32Type;
+    boolType = astContext.GetBuiltin().BuiltinBoolType;
+  }
+  ~SubstitutionMapTest() override {
+    astContext.SetStats(nullptr);
+    if (!statsDir.empty()) {
+      llvm::sys::fs::remove_directories(statsDir);
+    }
+  }
+
+  Type CreateStructType(llvm::StringRef name) {
+    auto structDecl =
+        StructDecl::Create(DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           astContext, sourceFile);
+    return structDecl->GetDeclaredType();
+  }
+
+  StatsReporter::AlwaysOnFrontendCounters &EnableStats() {
+    EXPECT_FALSE(llvm::sys::fs::createUniqueDirectory("SubstitutionMapTest",
+                                                      statsDir));
+    stats = std::make_unique<StatsReporter>(
+        "stone", "M", "", "", "", "", statsDir, nullptr, nullptr,
+        /*TraceEvents=*/false, /*ProfileEvents=*/false,
+        /*ProfileEntities=*/false, /*WriteStatsFile=*/false);
+    astContext.SetStats(stats.get());
+    return stats->getFrontendCounters();
+  }
+};
+
+TEST_F(SubstitutionMapTest, EqualListsAreUniqued) {
+  auto subs = SubstitutionMap::Get(astContext, {paramT, paramU},
+                                   {intType, boolType});
+  ASSERT_EQ(subs, SubstitutionMap::Get(astContext, {paramT, paramU},
+                                       {intType, boolType}));
+  ASSERT_NE(subs, SubstitutionMap::Get(astContext, {paramT, paramU},
+                                       {boolType, intType}));
+  ASSERT_TRUE(SubstitutionMap::Get(astContext, {}, {}).IsEmpty());
+
+  // The parameters keep their parameter list order.
+  ASSERT_EQ(paramT.GetPtr(), subs.GetParams()[0].GetPtr());
+  ASSERT_EQ(paramU.GetPtr(), subs.GetParams()[1].GetPtr());
+  ASSERT_EQ(intType.GetPtr(), subs.LookupSubstitution(paramT).GetPtr());
+  ASSERT_EQ(boolType.GetPtr(), subs.LookupSubstitution(paramU).GetPtr());
+  ASSERT_FALSE(subs.LookupSubstitution(intType));
+}
+
+#ifndef NDEBUG
+TEST_F(SubstitutionMapTest, DuplicateParamIsRejected) {
+  // Other tests leave the thread pool running.
+  ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+  ASSERT_DEATH(SubstitutionMap::Get(astContext, {paramT, paramT},
+                                    {intType, boolType}),
+               "substituted twice");
+}
+#endif
+
+TEST_F(SubstitutionMapTest, SubstRebuildsAndRemembers) {
+  auto &counters = EnableStats();
+  auto subs = SubstitutionMap::Get(astContext, {paramT, paramU},
+                                   {intType, boolType});
+
+  // (T, U) -> *T
+  Type funType(astContext.GetFunType(astContext.GetRawType(paramT),
+                                     {paramT, paramU}));
+  auto substType = funType.Subst(subs);
+  Type expected(astContext.GetFunType(astContext.GetRawType(intType),
+                                      {intType, boolType}));
+  ASSERT_EQ(expected.GetPtr(), substType.GetPtr());
+  // T is reached twice, so the second visit is already a hit.
+  auto misses = counters.NumSubstitutionCacheMisses;
+  auto hits = counters.NumSubstitutionCacheHits;
+  ASSERT_EQ(1, hits);
+
+  // Doing it again is one lookup.
+  ASSERT_EQ(substType.GetPtr(), funType.Subst(subs).GetPtr());
+  ASSERT_EQ(misses, counters.NumSubstitutionCacheMisses);
+  ASSERT_EQ(hits + 1, counters.NumSubstitutionCacheHits);
+}
@@ -0,0 +1,181 @@
+#include "ASTTest.h"
+
+#include "stone/AST/SyntaxTree.h"
+
+using namespace stone;
+
+namespace {
+struct TestToken final {
+  tok kind;
+  llvm::StringRef text;
+};
+} // namespace
+
+class SyntaxTreeTest : public ASTTest {
+protected:
+  llvm::StringRef source = "fun F(int a) {\n"
+                           "  G(a); // call\n"
+                           "}\n";
+  std::vector<TestToken> tokens = {
+      {tok::kw_fun, "fun"},    {tok::identifier, "F"},
+      {tok::l_paren, "("},     {tok::kw_int, "int"},
+      {tok::identifier, "a"},  {tok::r_paren, ")"},
+      {tok::l_brace, "{"},     {tok::identifier, "G"},
+      {tok::l_paren, "("},     {tok::identifier, "a"},
+      {tok::r_paren, ")"},     {tok::semi, ";"},
+      {tok::r_brace, "}"},
+  };
+
+  /// The offset of each token in the source.
+  std::vector<uint32_t> offsets;
+
+protected:
+  SyntaxTreeTest() {
+    size_t from = 0;
+    for (const auto &token : tokens) {
+      from = source.find(token.text, from);
+      offsets.push_back(from);
+      from += token.text.size();
+    }
+  }
+
+  void AddTokens(SyntaxTreeBuilder &builder, unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      builder.AddToken(tokens[i].kind, offsets[i], tokens[i].text.size());
+    }
+  }
+
+  SyntaxTree *Build() {
+    SyntaxTreeBuilder builder(source);
+    builder.OpenNode(SyntaxKind::TopLevelDecl);
+    AddTokens(builder, 0, tokens.size());
+    builder.CloseNode();
+    return builder.Finish(astContext);
+  }
+};
+
+TEST_F(SyntaxTreeTest, Lossless) {
+  auto tree = Build();
+  ASSERT_EQ(source, tree->GetSourceText());
+  ASSERT_EQ(source, tree->GetRoot()->GetFullText());
+}
+
+TEST_F(SyntaxTreeTest, GroupsNest) {
+  auto tree = Build();
+  auto decl = tree->GetRoot()->GetChild(0);
+  ASSERT_EQ(SyntaxKind::TopLevelDecl, decl->GetKind());
+
+  // fun F (int a) {...}
+  ASSERT_EQ(4u, decl->GetNumChildren());
+  auto params = decl->GetChild(2);
+  ASSERT_EQ(SyntaxKind::ParenGroup, params->GetKind());
+  ASSERT_EQ("(int a)", params->GetText());
+
+  auto body = decl->GetChild(3);
+  ASSERT_EQ(SyntaxKind::BraceGroup, body->GetKind());
+  ASSERT_EQ("{\n  G(a); // call\n}", body->GetText());
+
+  // { G (a) ; }
+  ASSERT_EQ(5u, body->GetNumChildren());
+  auto args = body->GetChild(2);
+  ASSERT_EQ(SyntaxKind::ParenGroup, args->GetKind());
+  ASSERT_EQ("(a)", args->GetText());
+  ASSERT_EQ(body, args->GetParent());
+}
+
+TEST_F(SyntaxTreeTest, FindEnclosingNode) {
+  auto tree = Build();
+  auto argOffset = offsets[9];
+  auto found = tree->FindEnclosingNode(argOffset, 1);
+  ASSERT_EQ(SyntaxKind::ParenGroup, found->GetKind());
+  ASSERT_EQ("(a)", found->GetText());
+
+  // An edit that spans both groups of the decl belongs to the decl.
+  found = tree->FindEnclosingNode(offsets[4], argOffset - offsets[4]);
+  ASSERT_EQ(SyntaxKind::TopLevelDecl, found->GetKind());
+}
+
+TEST_F(SyntaxTreeTest, RewindMatchesStraightBuild) {
+  auto expected = Build();
+
+  // Go as far as the call argument, back up to the call, and continue.
+  SyntaxTreeBuilder builder(source);
+  builder.OpenNode(SyntaxKind::TopLevelDecl);
+  AddTokens(builder, 0, 10);
+  builder.Rewind(offsets[7]);
+  AddTokens(builder, 7, tokens.size());
+  builder.CloseNode();
+  auto tree = builder.Finish(astContext);
+
+  auto expectedNodes = expected->GetGreenNodes();
+  auto nodes = tree->GetGreenNodes();
+  ASSERT_EQ(expectedNodes.size(), nodes.size());
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    EXPECT_EQ(expectedNodes[i].GetKind(), nodes[i].GetKind()) << i;
+    EXPECT_EQ(expectedNodes[i].GetOffset(), nodes[i].GetOffset()) << i;
+    EXPECT_EQ(expectedNodes[i].GetLength(), nodes[i].GetLength()) << i;
+    EXPECT_EQ(expectedNodes[i].GetSubtreeSize(), nodes[i].GetSubtreeSize())
+        << i;
+  }
+}
+
+TEST_F(SyntaxTreeTest, RewindIntoClosedGroup) {
+  auto expected = Build();
+
+  // Back up from after the body to inside the closed parameter group.
+  SyntaxTreeBuilder builder(source);
+  builder.OpenNode(SyntaxKind::TopLevelDecl);
+  AddTokens(builder, 0, tokens.size());
+  builder.Rewind(offsets[4]);
+  AddTokens(builder, 4, tokens.size());
+  builder.CloseNode();
+  auto tree = builder.Finish(astContext);
+
+  ASSERT_EQ(source, tree->GetSourceText());
+  ASSERT_EQ(expected->GetGreenNodes().size(), tree->GetGreenNodes().size());
+  auto params = tree->GetRoot()->GetChild(0)->GetChild(2);
+  ASSERT_EQ("(int a)", params->GetText());
+}
+
+TEST_F(SyntaxTreeTest, RewindReopensParserNode) {
+  auto expected = Build();
+
+  // The parser backtracks to the start of the decl it is still parsing.
+  SyntaxTreeBuilder builder(source);
+  builder.OpenNode(SyntaxKind::TopLevelDecl);
+  AddTokens(builder, 0, 5);
+  builder.Rewind(offsets[0]);
+  AddTokens(builder, 0, tokens.size());
+  builder.CloseNode();
+  auto tree = builder.Finish(astContext);
+
+  ASSERT_EQ(source, tree->GetSourceText());
+  ASSERT_EQ(expected->GetGreenNodes().size(), tree->GetGreenNodes().size());
+  // The decl and the end-of-file token.
+  ASSERT_EQ(2u, tree->GetRoot()->GetNumChildren());
+}
+
+TEST_F(SyntaxTreeTest, BailOutKeepsTheRest) {
+  // The parser gives up inside the parameter list and never closes its
+  // nodes. Nothing lexed the rest, so it is the eof token's leading trivia.
+  SyntaxTreeBuilder builder(source);
+  builder.OpenNode(SyntaxKind::TopLevelDecl);
+  AddTokens(builder, 0, 4);
+  auto tree = builder.Finish(astContext);
+
+  ASSERT_EQ(source, tree->GetSourceText());
+  ASSERT_EQ(source, tree->GetRoot()->GetFullText());
+  ASSERT_EQ(2u, tree->GetRoot()->GetNumChildren());
+
+  auto decl = tree->GetRoot()->GetChild(0);
+  ASSERT_EQ(SyntaxKind::TopLevelDecl, decl->GetKind());
+  ASSERT_EQ("fun F(int", decl->GetText());
+  ASSERT_EQ("(int", decl->GetChild(2)->GetText());
+
+  auto eof = tree->GetRoot()->GetChild(1);
+  ASSERT_EQ(tok::eof, eof->GetTokenKind());
+  ASSERT_EQ("", eof->GetText());
+  ASSERT_EQ(source.substr(offsets[3] + 3), decl->GetTrailingTrivia().str() +
+                                               eof->GetLeadingTrivia().str());
+  ASSERT_TRUE(eof->GetLeadingTrivia().endswith("// call\n}\n"));
+}
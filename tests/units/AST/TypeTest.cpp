@@ -0,0 +1,60 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Types.h"
+
+using namespace stone;
+
+class TypeTest : public ASTTest {
+protected:
+  Type intType;
+  Type intPointerType;
+
+protected:
+  TypeTest()
+      : intType(astContext.GetBuiltin().BuiltinInt32Type),
+        intPointerType(astContext.GetRawType(intType)) {}
+
+  /// \return an alias whose underlying type is \p underlyingType.
+  AliasType *CreateAlias(Type underlyingType) {
+    return new (astContext) AliasType(nullptr, underlyingType, astContext);
+  }
+};
+
+TEST_F(TypeTest, AliasIsCanonicalizedOnce) {
+  ASSERT_TRUE(intPointerType->IsCanType());
+
+  auto alias = CreateAlias(intPointerType);
+  ASSERT_FALSE(alias->IsCanType());
+  ASSERT_FALSE(alias->HasCanType());
+
+  auto canType = alias->GetCanType();
+  ASSERT_EQ(intPointerType.GetPtr(), canType.GetPtr());
+  ASSERT_EQ(canType, intPointerType.GetCanType());
+
+  // The second call returns the node cached by the first.
+  ASSERT_TRUE(alias->HasCanType());
+  ASSERT_EQ(canType, alias->GetCanType());
+}
+
+TEST_F(TypeTest, StructuralSugarIsEqual) {
+  Type alias(CreateAlias(intType));
+  Type boolType(astContext.GetBuiltin().BuiltinBoolType);
+
+  // int* spelled through the alias is a different node but the same type.
+  Type aliasPointerType(astContext.GetRawType(alias));
+  ASSERT_NE(intPointerType.GetPtr(), aliasPointerType.GetPtr());
+  ASSERT_FALSE(aliasPointerType->IsCanType());
+  ASSERT_TRUE(aliasPointerType.IsEqual(intPointerType));
+  ASSERT_FALSE(aliasPointerType.IsEqual(astContext.GetRawType(boolType)));
+  ASSERT_FALSE(aliasPointerType.IsEqual(astContext.GetRefType(intType)));
+
+  Type aliasFunType(astContext.GetFunType(alias, {aliasPointerType}));
+  Type funType(astContext.GetFunType(intType, {intPointerType}));
+  ASSERT_TRUE(aliasFunType.IsEqual(funType));
+  ASSERT_EQ(funType.GetPtr(), aliasFunType.GetCanType().GetPtr());
+
+  auto constQuals = QualSpecs::GetFromOpaqueValue(QualSpecs::Const);
+  ASSERT_TRUE(astContext.GetQualifiedType(alias, constQuals)
+                  .IsEqual(astContext.GetQualifiedType(intType, constQuals)));
+  ASSERT_FALSE(astContext.GetQualifiedType(alias, constQuals).IsEqual(intType));
+}
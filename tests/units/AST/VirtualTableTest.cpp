@@ -0,0 +1,105 @@
+#include "ASTTest.h"
+
+#include "stone/AST/ConformanceTable.h"
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/VirtualTable.h"
+
+using namespace stone;
+
+class VirtualTableTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  VirtualTableTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  template <typename DeclTy> DeclTy *Create(llvm::StringRef name) {
+    auto decl = DeclTy::Create(DeclName(astContext.GetIdentifier(name)),
+                               SrcLoc(), astContext, sourceFile);
+    sourceFile->AddTopLevelDecl(decl);
+    return decl;
+  }
+  FunDecl *AddVirtual(ClassDecl *classDecl, llvm::StringRef name) {
+    auto funDecl = FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                                   DeclName(astContext.GetIdentifier(name)),
+                                   SrcLoc(), Type(), classDecl);
+    funDecl->SetVirtual();
+    classDecl->AddMember(funDecl);
+    return funDecl;
+  }
+};
+
+TEST_F(VirtualTableTest, OverridesKeepTheirSlot) {
+  auto base = Create<ClassDecl>("Base");
+  auto baseF = AddVirtual(base, "f");
+  auto baseG = AddVirtual(base, "g");
+  auto derived = Create<ClassDecl>("Derived");
+  ASSERT_TRUE(derived->SetSuperclass(base));
+  auto derivedG = AddVirtual(derived, "g");
+  auto derivedH = AddVirtual(derived, "h");
+
+  auto &table = derived->GetVirtualTable();
+  ASSERT_EQ(&base->GetVirtualTable(), table.GetParent());
+  ASSERT_EQ((std::vector<FunctionDecl *>{baseF, derivedG, derivedH}),
+            std::vector<FunctionDecl *>(table.GetSlots().begin(),
+                                        table.GetSlots().end()));
+  ASSERT_EQ(baseG, table.GetOverriddenDecl(derivedG));
+  ASSERT_EQ(nullptr, table.GetOverriddenDecl(derivedH));
+  ASSERT_EQ(0u, *table.GetSlotIndex(baseF));
+}
+
+TEST_F(VirtualTableTest, StaleLayoutIsRebuilt) {
+  auto base = Create<ClassDecl>("Base");
+  AddVirtual(base, "f");
+  auto derived = Create<ClassDecl>("Derived");
+  derived->SetSuperclass(base);
+  auto first = &derived->GetVirtualTable();
+  ASSERT_EQ(first, &derived->GetVirtualTable());
+  ASSERT_EQ(1u, first->GetNumSlots());
+
+  // A member added to the superclass reaches the subclass layout.
+  AddVirtual(base, "g");
+  auto &second = derived->GetVirtualTable();
+  ASSERT_NE(first, &second);
+  ASSERT_EQ(2u, second.GetNumSlots());
+
+  // So does a function that stops being virtual.
+  auto h = AddVirtual(derived, "h");
+  ASSERT_EQ(3u, derived->GetVirtualTable().GetNumSlots());
+  h->SetVirtual(false);
+  ASSERT_EQ(2u, derived->GetVirtualTable().GetNumSlots());
+}
+
+TEST_F(VirtualTableTest, SuperclassCycleIsRefused) {
+  auto a = Create<ClassDecl>("A");
+  auto b = Create<ClassDecl>("B");
+  AddVirtual(a, "f");
+  ASSERT_TRUE(b->SetSuperclass(a));
+  ASSERT_FALSE(a->SetSuperclass(b));
+  ASSERT_FALSE(a->SetSuperclass(a));
+  ASSERT_EQ(nullptr, a->GetSuperclass());
+  ASSERT_EQ(1u, b->GetVirtualTable().GetNumSlots());
+}
+
+TEST_F(VirtualTableTest, SubclassConformsThroughSuperclass) {
+  auto interface = Create<InterfaceDecl>("I");
+  auto base = Create<ClassDecl>("Base");
+  auto derived = Create<ClassDecl>("Derived");
+  derived->SetSuperclass(base);
+  Type derivedType(derived->GetDeclaredType());
+  ASSERT_FALSE(astContext.ConformsTo(derivedType, interface));
+
+  base->AddInheritedInterface(interface, base);
+  auto entry = derived->LookupConformance(interface);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_EQ(base, entry->declaredIn);
+  ASSERT_TRUE(astContext.ConformsTo(derivedType, interface));
+}
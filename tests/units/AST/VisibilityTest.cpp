@@ -0,0 +1,78 @@
+#include "ASTTest.h"
+
+#include "stone/AST/Decl.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/TypeChecker.h"
+#include "stone/AST/Types.h"
+
+using namespace stone;
+
+class VisibilityTest : public ASTTest {
+protected:
+  ModuleDecl *moduleDecl;
+  SourceFile *sourceFile;
+
+protected:
+  VisibilityTest()
+      : moduleDecl(
+            ModuleDecl::Create(astContext.GetIdentifier("M"), astContext)),
+        sourceFile(SourceFile::Create(SourceFileKind::Library, 0, *moduleDecl,
+                                      astContext)) {
+    moduleDecl->AddFile(*sourceFile);
+  }
+
+  StructDecl *CreateStruct(llvm::StringRef name, VisibilityLevel level) {
+    auto structDecl =
+        StructDecl::Create(DeclName(astContext.GetIdentifier(name)), SrcLoc(),
+                           astContext, sourceFile);
+    structDecl->SetVisibilityLevel(level);
+    sourceFile->AddTopLevelDecl(structDecl);
+    return structDecl;
+  }
+
+  /// fun name(param) -> int32
+  FunDecl *CreateFun(llvm::StringRef name, VisibilityLevel level,
+                     Type paramType) {
+    Type intType(astContext.GetBuiltin().BuiltinInt32Type);
+    Type funType(astContext.GetFunType(intType, {paramType}));
+    auto funDecl = FunDecl::Create(astContext, SrcLoc(), SrcLoc(),
+                                   DeclName(astContext.GetIdentifier(name)),
+                                   SrcLoc(), funType, sourceFile);
+    funDecl->SetVisibilityLevel(level);
+    sourceFile->AddTopLevelDecl(funDecl);
+    return funDecl;
+  }
+
+  VisibilityLevel GetEffectiveVisibility(Type type) {
+    return astContext.GetVisibilityCache().GetEffectiveVisibility(type);
+  }
+};
+
+TEST_F(VisibilityTest, NominalTypeTakesItsDeclVisibility) {
+  auto hidden = CreateStruct("Hidden", VisibilityLevel::Private);
+  auto shown = CreateStruct("Shown", VisibilityLevel::Public);
+  ASSERT_EQ(VisibilityLevel::Private,
+            GetEffectiveVisibility(hidden->GetDeclaredType()));
+  ASSERT_EQ(VisibilityLevel::Public,
+            GetEffectiveVisibility(shown->GetDeclaredType()));
+
+  // Types built from a nominal type are no wider than it.
+  Type pointerType(astContext.GetRawType(hidden->GetDeclaredType()));
+  ASSERT_EQ(VisibilityLevel::Private, GetEffectiveVisibility(pointerType));
+}
+
+TEST_F(VisibilityTest, PublicFunWithPrivateParamType) {
+  auto hidden = CreateStruct("Hidden", VisibilityLevel::Private);
+  auto funDecl =
+      CreateFun("f", VisibilityLevel::Public, hidden->GetDeclaredType());
+  TypeChecker::CheckDecl(funDecl);
+  ASSERT_TRUE(de.hadAnyError());
+}
+
+TEST_F(VisibilityTest, PrivateFunWithPrivateParamType) {
+  auto hidden = CreateStruct("Hidden", VisibilityLevel::Private);
+  auto funDecl =
+      CreateFun("f", VisibilityLevel::Private, hidden->GetDeclaredType());
+  TypeChecker::CheckDecl(funDecl);
+  ASSERT_FALSE(de.hadAnyError());
+}
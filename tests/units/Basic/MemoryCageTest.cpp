@@ -0,0 +1,59 @@
+#include "stone/Basic/MemoryCage.h"
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Allocator.h"
+#include "gtest/gtest.h"
+
+using namespace stone;
+
+#if defined(LLVM_ON_UNIX)
+
+class MemoryCageTest : public ::testing::Test {
+protected:
+  MemoryCagePtr cage;
+
+protected:
+  MemoryCageTest() : cage(MemoryCage::Create(nullptr)) {}
+};
+
+TEST_F(MemoryCageTest, ReleasedSlabIsReused) {
+  auto first = cage->AllocateSlab(4096, 16);
+  auto bytesAllocated = cage->GetBytesAllocated();
+  cage->DeallocateSlab(first, 4096);
+  ASSERT_EQ(4096u, cage->GetBytesFree());
+
+  ASSERT_EQ(first, cage->AllocateSlab(4096, 16));
+  ASSERT_EQ(bytesAllocated, cage->GetBytesAllocated());
+  ASSERT_EQ(0u, cage->GetBytesFree());
+}
+
+TEST_F(MemoryCageTest, LargerSlabIsSplit) {
+  auto slab = static_cast<char *>(cage->AllocateSlab(8192, 16));
+  cage->DeallocateSlab(slab, 8192);
+
+  ASSERT_EQ(slab, cage->AllocateSlab(4096, 16));
+  ASSERT_EQ(4096u, cage->GetBytesFree());
+  ASSERT_EQ(slab + 4096, cage->AllocateSlab(4096, 16));
+  ASSERT_EQ(0u, cage->GetBytesFree());
+}
+
+TEST_F(MemoryCageTest, ResetArenaDoesNotGrowCage) {
+  llvm::BumpPtrAllocatorImpl<MemoryCageSlabAllocator> arena(
+      MemoryCageSlabAllocator(cage.get()));
+  auto Fill = [&]() {
+    // Enough for several slabs, and one allocation that gets its own slab.
+    for (unsigned i = 0; i < 1024; ++i) {
+      arena.Allocate(64, 8);
+    }
+    arena.Allocate(1 << 16, 8);
+    arena.Reset();
+  };
+  Fill();
+  auto bytesAllocated = cage->GetBytesAllocated();
+  for (unsigned i = 0; i < 16; ++i) {
+    Fill();
+  }
+  ASSERT_EQ(bytesAllocated, cage->GetBytesAllocated());
+}
+
+#endif
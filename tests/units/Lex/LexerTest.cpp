@@ -1,58 +1,143 @@
-#include "stone/Parse/Lexer.h"
+#include "stone/AST/Diagnostics.h"
 #include "stone/Basic/LangOptions.h"
 #include "stone/Basic/SrcMgr.h"
-#include "stone/LangContext.h"
+#include "stone/Parse/Lexer.h"
 
 #include "gtest/gtest.h"
 
 using namespace stone;
-using namespace stone::syn;
 
 class LexerTest : public ::testing::Test {
 protected:
-  LangContext ctx;
+  SrcMgr sm;
+  DiagnosticEngine de;
+  LangOptions langOpts;
 
 protected:
-  LexerTest() {}
+  LexerTest() : de(sm) {}
 
 protected:
   std::unique_ptr<Lexer> CreateLexer(llvm::StringRef source) {
-
-    auto srcID = ctx.GetSrcMgr().addMemBufferCopy(source);
-    return std::make_unique<Lexer>(srcID, ctx.GetSrcMgr(),
-                                   &ctx.GetDiagUnit().GetDiagEngine(),
-                                   &ctx.GetStatEngine());
+    auto bufferID = sm.addMemBufferCopy(source, "LexerTest.stone");
+    return std::make_unique<Lexer>(bufferID, sm, &de, nullptr, &langOpts);
   }
-  std::vector<syn::Token> Lex(llvm::StringRef source) {
-
-    auto lexer = CreateLexer(source);
-    std::vector<syn::Token> tokens;
+  std::vector<Token> Lex(Lexer &lexer) {
+    std::vector<Token> tokens;
     while (true) {
-      syn::Token token;
-      lexer->Lex(token);
-      tokens.push_back(token);
+      Token token;
+      lexer.Lex(token);
       if (token.GetKind() == tok::eof) {
         break;
       }
+      tokens.push_back(token);
     }
     return tokens;
   }
+  std::vector<std::string> LexText(llvm::StringRef source) {
+    auto lexer = CreateLexer(source);
+    std::vector<std::string> texts;
+    for (auto &token : Lex(*lexer)) {
+      texts.push_back(token.GetText().str());
+    }
+    return texts;
+  }
 };
 
 TEST_F(LexerTest, GetNextToken) {
+  auto tokens = LexText("fun Main() -> int { return 0; }\n");
+  std::vector<std::string> expected = {"fun", "Main",   "(", ")", "->", "int",
+                                       "{",   "return", "0", ";", "}"};
+  ASSERT_EQ(expected, tokens);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(LexerTest, IfConfigSelectsActiveClause) {
+  langOpts.AddCustomConditionalCompilationFlag("DEBUG");
+  auto tokens = LexText("#if DEBUG\n"
+                        "a\n"
+                        "#else\n"
+                        "b\n"
+                        "#endif\n"
+                        "#if RELEASE\n"
+                        "c\n"
+                        "#elseif DEBUG\n"
+                        "d\n"
+                        "#endif\n");
+  std::vector<std::string> expected = {"a", "d"};
+  ASSERT_EQ(expected, tokens);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(LexerTest, IfConfigNested) {
+  langOpts.AddCustomConditionalCompilationFlag("DEBUG");
+  auto tokens = LexText("#if RELEASE\n"
+                        "#if DEBUG\n"
+                        "a\n"
+                        "#endif\n"
+                        "b\n"
+                        "#else\n"
+                        "#if DEBUG\n"
+                        "c\n"
+                        "#endif\n"
+                        "#endif\n");
+  std::vector<std::string> expected = {"c"};
+  ASSERT_EQ(expected, tokens);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(LexerTest, StrayIfConfigDirective) {
+  auto tokens = LexText("a\n"
+                        "#endif\n"
+                        "b\n");
+  std::vector<std::string> expected = {"a", "b"};
+  ASSERT_EQ(expected, tokens);
+  ASSERT_TRUE(de.hadAnyError());
+}
+
+TEST_F(LexerTest, InactiveClauseSkipsComments) {
+  auto tokens = LexText("#if RELEASE\n"
+                        "/*\n"
+                        "#endif\n"
+                        "*/\n"
+                        "// #endif\n"
+                        "a\n"
+                        "#endif\n"
+                        "b\n");
+  std::vector<std::string> expected = {"b"};
+  ASSERT_EQ(expected, tokens);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(LexerTest, InactiveClauseSkipsStrings) {
+  auto tokens = LexText("#if RELEASE\n"
+                        "let s = \"#endif\"\n"
+                        "\"\"\"\n"
+                        "#endif\n"
+                        "\"\"\"\n"
+                        "a\n"
+                        "#endif\n"
+                        "b\n");
+  std::vector<std::string> expected = {"b"};
+  ASSERT_EQ(expected, tokens);
+  ASSERT_FALSE(de.hadAnyError());
+}
+
+TEST_F(LexerTest, IfConfigAfterBacktracking) {
+  langOpts.AddCustomConditionalCompilationFlag("DEBUG");
+  auto lexer = CreateLexer("a\n"
+                           "#if DEBUG\n"
+                           "b\n"
+                           "#endif\n"
+                           "c\n");
+  auto tokens = Lex(*lexer);
+  ASSERT_EQ(3u, tokens.size());
 
-  llvm::StringRef source = "fun Main() -> int  { return 0;}\n";
-  auto tokens = Lex(source);
-
-  ASSERT_EQ(tok::kw_fun, tokens[0].GetKind());
-  ASSERT_EQ(tok::identifier, tokens[1].GetKind());
-  ASSERT_EQ(tok::l_paren, tokens[2].GetKind());
-  ASSERT_EQ(tok::r_paren, tokens[3].GetKind());
-  ASSERT_EQ(tok::arrow, tokens[4].GetKind());
-  ASSERT_EQ(tok::kw_int, tokens[5].GetKind());
-  ASSERT_EQ(tok::l_brace, tokens[6].GetKind());
-  ASSERT_EQ(tok::kw_return, tokens[7].GetKind());
-  ASSERT_EQ(tok::integer_literal, tokens[8].GetKind());
-  ASSERT_EQ(tok::semi, tokens[9].GetKind());
-  ASSERT_EQ(tok::r_brace, tokens[10].GetKind());
+  // Going back into the clause reopens its '#if', so the '#endif' that
+  // follows is not stray.
+  lexer->backtrackToState(lexer->getStateForBeginningOfToken(tokens[1]));
+  auto rest = Lex(*lexer);
+  ASSERT_EQ(2u, rest.size());
+  ASSERT_EQ("b", rest[0].GetText());
+  ASSERT_EQ("c", rest[1].GetText());
+  ASSERT_FALSE(de.hadAnyError());
 }
@@ -0,0 +1,459 @@
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/ClangImporter.h"
+#include "stone/AST/Diagnostics.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/SearchPath.h"
+#include "stone/AST/TypeCheckerOptions.h"
+#include "stone/Basic/LangOptions.h"
+#include "stone/Basic/LLVMInit.h"
+#include "stone/Basic/MainExecutablePath.h"
+#include "stone/Compile/Compile.h"
+#include "stone/Compile/CompilerInstance.h"
+#include "stone/Compile/CompilerInvocation.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace stone;
+
+static llvm::cl::list<std::string>
+    inputPaths(llvm::cl::Positional,
+               llvm::cl::desc("<.stone files or directories>"));
+
+static llvm::cl::opt<unsigned>
+    iterations("iterations", llvm::cl::init(10),
+               llvm::cl::desc("Number of times to parse each corpus"));
+
+static llvm::cl::list<unsigned> scales(
+    "scale", llvm::cl::CommaSeparated,
+    llvm::cl::desc("Sizes (in decls) of the generated corpora to parse"));
+
+static llvm::cl::opt<unsigned> importModules(
+    "import-modules", llvm::cl::init(0),
+    llvm::cl::desc("Number of modules in the generated import graph whose "
+                   "visibility queries are measured (0 to skip)"));
+
+static llvm::cl::opt<std::string>
+    outputPath("o", llvm::cl::init("-"),
+               llvm::cl::desc("Where to write the JSON report"));
+
+namespace {
+/// A named set of files that are parsed together as one module.
+struct ParseBenchCorpus final {
+  std::string name;
+  std::vector<std::string> files;
+  uint64_t bytes = 0;
+};
+
+/// The measurements of a single PerformParse over a corpus.
+struct ParseBenchSample final {
+  double seconds = 0;
+  uint64_t decls = 0;
+  uint64_t astBytes = 0;
+  bool hadError = false;
+};
+} // namespace
+
+/// \return the peak resident set size of this process in bytes, or 0 if the
+/// platform does not report it.
+static uint64_t GetPeakResidentSetSize() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  uint64_t peak = static_cast<uint64_t>(usage.ru_maxrss);
+#ifndef __APPLE__
+  // Apple systems report bytes; everything else reports KB.
+  peak <<= 10;
+#endif
+  return peak;
+#else
+  return 0;
+#endif
+}
+
+static bool AddCorpusFile(ParseBenchCorpus &corpus, llvm::StringRef path) {
+  uint64_t size = 0;
+  if (llvm::sys::fs::file_size(path, size)) {
+    llvm::errs() << "error: cannot read '" << path << "'\n";
+    return false;
+  }
+  corpus.files.push_back(path.str());
+  corpus.bytes += size;
+  return true;
+}
+
+/// Collect the .stone files under \p path, which may be a file or directory.
+static bool LoadCorpus(ParseBenchCorpus &corpus, llvm::StringRef path) {
+  if (!llvm::sys::fs::is_directory(path)) {
+    return AddCorpusFile(corpus, path);
+  }
+  std::error_code ec;
+  for (llvm::sys::fs::recursive_directory_iterator it(path, ec), end;
+       it != end && !ec; it.increment(ec)) {
+    if (llvm::sys::path::extension(it->path()) != ".stone") {
+      continue;
+    }
+    if (!AddCorpusFile(corpus, it->path())) {
+      return false;
+    }
+  }
+  // Keep the parse order stable across runs and file systems.
+  llvm::sort(corpus.files);
+  return !ec;
+}
+
+/// Write one generated decl. The parser only accepts empty functions today,
+/// and only resolves the int result types, so the decls vary in visibility and
+/// result type alone. Widen this as the parser learns more; a generated corpus
+/// must always parse without errors.
+static void GenerateDecl(llvm::raw_ostream &os, unsigned index) {
+  static const char *const visibilities[] = {"public ", "internal ", ""};
+  static const char *const resultTypes[] = {"int", "int8", "int16", "int32",
+                                            "int64"};
+  os << visibilities[index % 3] << "fun F" << index << "() -> "
+     << resultTypes[index % 5] << " {\n}\n\n";
+}
+
+/// Write a corpus of \p numDecls decls into \p directory.
+static bool GenerateCorpus(ParseBenchCorpus &corpus, llvm::StringRef directory,
+                           unsigned numDecls) {
+  llvm::SmallString<128> path(directory);
+  llvm::sys::path::append(path, "generated-" + std::to_string(numDecls) +
+                                    ".stone");
+  std::error_code ec;
+  llvm::raw_fd_ostream os(path, ec);
+  if (ec) {
+    llvm::errs() << "error: cannot write '" << path << "'\n";
+    return false;
+  }
+  for (unsigned i = 0; i < numDecls; ++i) {
+    GenerateDecl(os, i);
+  }
+  os << "fun Main() -> int {\n}\n";
+  os.close();
+  return AddCorpusFile(corpus, path);
+}
+
+static bool ParseCorpus(const ParseBenchCorpus &corpus,
+                        llvm::StringRef mainExecutablePath,
+                        llvm::StringRef mainExecutableName,
+                        ParseBenchSample &sample) {
+  CompilerInvocation invocation;
+  invocation.SetMainExecutablePath(mainExecutablePath);
+  invocation.SetMainExecutableName(mainExecutableName);
+
+  std::vector<const char *> args = {"-parse", "-module-name", "Bench"};
+  for (const auto &file : corpus.files) {
+    args.push_back(file.c_str());
+  }
+  if (invocation.ParseArgs(args).IsError()) {
+    return false;
+  }
+  CompilerInstance instance(invocation);
+  if (!instance.Setup()) {
+    return false;
+  }
+
+  // Only the parse itself is timed; setup and teardown are excluded.
+  auto start = std::chrono::steady_clock::now();
+  stone::PerformParse(instance, nullptr);
+  auto stop = std::chrono::steady_clock::now();
+
+  sample.seconds = std::chrono::duration<double>(stop - start).count();
+  sample.hadError = instance.HasError();
+  sample.astBytes = instance.GetASTContext().GetTotalMemoryAllocated();
+  instance.ForEachSourceFileInMainModule([&](SourceFile &sourceFile) {
+    sample.decls += sourceFile.GetTopLevelDecls().size();
+    return true;
+  });
+  return true;
+}
+
+/// Parse \p corpus once for every sample in \p samples.
+static bool ParseSamples(const ParseBenchCorpus &corpus,
+                         llvm::StringRef mainExecutablePath,
+                         llvm::StringRef mainExecutableName,
+                         llvm::MutableArrayRef<ParseBenchSample> samples) {
+  for (auto &sample : samples) {
+    if (!ParseCorpus(corpus, mainExecutablePath, mainExecutableName, sample)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Parse \p corpus for every sample in \p samples and report the peak RSS
+/// in \p peakRSS. Where the platform allows it, the parses run in a child
+/// process so that the peak belongs to this corpus alone and not to every
+/// corpus parsed before it.
+static bool MeasureCorpus(const ParseBenchCorpus &corpus,
+                          llvm::StringRef mainExecutablePath,
+                          llvm::StringRef mainExecutableName,
+                          llvm::MutableArrayRef<ParseBenchSample> samples,
+                          uint64_t &peakRSS) {
+#if defined(__unix__) || defined(__APPLE__)
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    return false;
+  }
+  // The child must not write out what the parent has buffered.
+  llvm::outs().flush();
+  llvm::errs().flush();
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return false;
+  }
+  if (pid == 0) {
+    ::close(fds[0]);
+    bool parsed =
+        ParseSamples(corpus, mainExecutablePath, mainExecutableName, samples);
+    uint64_t childPeakRSS = GetPeakResidentSetSize();
+    if (parsed) {
+      llvm::raw_fd_ostream out(fds[1], /*shouldClose=*/true);
+      out.write(reinterpret_cast<const char *>(samples.data()),
+                samples.size() * sizeof(ParseBenchSample));
+      out.write(reinterpret_cast<const char *>(&childPeakRSS),
+                sizeof(childPeakRSS));
+      out.flush();
+    }
+    ::_exit(parsed ? 0 : 1);
+  }
+  ::close(fds[1]);
+  std::string buffer;
+  char chunk[4096];
+  ssize_t count;
+  while ((count = ::read(fds[0], chunk, sizeof(chunk))) != 0) {
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    buffer.append(chunk, count);
+  }
+  ::close(fds[0]);
+  int status = 0;
+  while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  size_t samplesSize = samples.size() * sizeof(ParseBenchSample);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+      buffer.size() != samplesSize + sizeof(peakRSS)) {
+    return false;
+  }
+  std::memcpy(samples.data(), buffer.data(), samplesSize);
+  std::memcpy(&peakRSS, buffer.data() + samplesSize, sizeof(peakRSS));
+  return true;
+#else
+  if (!ParseSamples(corpus, mainExecutablePath, mainExecutableName, samples)) {
+    return false;
+  }
+  peakRSS = GetPeakResidentSetSize();
+  return true;
+#endif
+}
+
+static void ReportCorpus(llvm::json::OStream &json,
+                         const ParseBenchCorpus &corpus,
+                         llvm::ArrayRef<ParseBenchSample> samples,
+                         uint64_t peakRSS) {
+  double totalSeconds = 0;
+  double minSeconds = samples.front().seconds;
+  uint64_t maxASTBytes = 0;
+  bool hadError = false;
+  for (const auto &sample : samples) {
+    totalSeconds += sample.seconds;
+    minSeconds = std::min(minSeconds, sample.seconds);
+    maxASTBytes = std::max(maxASTBytes, sample.astBytes);
+    hadError |= sample.hadError;
+  }
+  double meanSeconds = totalSeconds / samples.size();
+  uint64_t decls = samples.front().decls;
+
+  json.object([&] {
+    json.attribute("name", corpus.name);
+    json.attribute("files", static_cast<int64_t>(corpus.files.size()));
+    json.attribute("bytes", static_cast<int64_t>(corpus.bytes));
+    json.attribute("decls", static_cast<int64_t>(decls));
+    json.attribute("iterations", static_cast<int64_t>(samples.size()));
+    json.attribute("mean_seconds", meanSeconds);
+    json.attribute("min_seconds", minSeconds);
+    json.attribute("decls_per_second",
+                   meanSeconds > 0 ? decls / meanSeconds : 0);
+    json.attribute("bytes_per_second",
+                   meanSeconds > 0 ? corpus.bytes / meanSeconds : 0);
+    json.attribute("ast_bytes_allocated", static_cast<int64_t>(maxASTBytes));
+    json.attribute("peak_rss_bytes", static_cast<int64_t>(peakRSS));
+    json.attribute("had_error", hadError);
+  });
+}
+
+/// Build a layered import graph of \p numModules modules, where each module
+/// imports the two before it, and time asking every module whether it can see
+/// the first one: once while the import sets are built and then from the
+/// import cache.
+static void ReportImports(llvm::json::OStream &json, unsigned numModules) {
+  LangOptions langOpts;
+  SearchPathOptions searchPathOpts;
+  TypeCheckerOptions typeCheckerOpts;
+  ClangImporter clangImporter;
+  SrcMgr sm;
+  DiagnosticEngine de(sm);
+  ASTContext astContext(langOpts, searchPathOpts, typeCheckerOpts,
+                        clangImporter, de, nullptr);
+
+  std::vector<ModuleDecl *> modules;
+  uint64_t edges = 0;
+  for (unsigned i = 0; i < numModules; ++i) {
+    auto module = ModuleDecl::Create(
+        astContext.GetIdentifier("M" + std::to_string(i)), astContext);
+    for (unsigned back = 1; back <= 2 && back <= i; ++back) {
+      module->AddImport(ImportedModule(modules[i - back]));
+      ++edges;
+    }
+    modules.push_back(module);
+  }
+
+  auto &importCache = astContext.GetImportCache();
+  auto QueryAll = [&]() {
+    unsigned visible = 0;
+    for (auto module : modules) {
+      visible += importCache.IsImportedBy(modules.front(), module);
+    }
+    return visible;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  unsigned visible = QueryAll();
+  auto firstStop = std::chrono::steady_clock::now();
+  unsigned rounds = std::max<unsigned>(1, iterations);
+  for (unsigned i = 0; i < rounds; ++i) {
+    visible = QueryAll();
+  }
+  auto cachedStop = std::chrono::steady_clock::now();
+
+  json.attributeObject("imports", [&] {
+    json.attribute("modules", static_cast<int64_t>(numModules));
+    json.attribute("edges", static_cast<int64_t>(edges));
+    json.attribute("visible", static_cast<int64_t>(visible));
+    json.attribute("first_query_seconds",
+                   std::chrono::duration<double>(firstStop - start).count());
+    json.attribute(
+        "cached_query_seconds",
+        std::chrono::duration<double>(cachedStop - firstStop).count() /
+            rounds);
+  });
+}
+
+int main(int argc, const char **args) {
+  START_LLVM_INIT(argc, args);
+  FINISH_LLVM_INIT();
+  llvm::cl::ParseCommandLineOptions(
+      argc, args, "stone parse benchmark\n\n"
+                  "Parses each corpus N times and reports the throughput, "
+                  "AST memory and peak RSS of each as JSON, along with the "
+                  "cost of import visibility queries if asked.\n");
+
+  // The invocation keeps references to these, so they outlive every parse.
+  std::string mainExecutablePath = stone::GetMainExecutablePath(args[0]);
+  llvm::StringRef mainExecutableName = llvm::sys::path::stem(args[0]);
+
+  std::vector<ParseBenchCorpus> corpora;
+
+  ParseBenchCorpus syntaxCorpus;
+  syntaxCorpus.name = "syntax";
+  if (inputPaths.empty()) {
+    inputPaths.push_back(STONE_PARSE_BENCH_CORPUS);
+  }
+  for (const auto &path : inputPaths) {
+    if (!LoadCorpus(syntaxCorpus, path)) {
+      return 1;
+    }
+  }
+  if (!syntaxCorpus.files.empty()) {
+    corpora.push_back(std::move(syntaxCorpus));
+  }
+
+  llvm::SmallString<128> generatedDir;
+  if (!scales.empty()) {
+    if (auto ec = llvm::sys::fs::createUniqueDirectory("stone-parse-bench",
+                                                       generatedDir)) {
+      llvm::errs() << "error: " << ec.message() << "\n";
+      return 1;
+    }
+  }
+  for (unsigned scale : scales) {
+    ParseBenchCorpus generatedCorpus;
+    generatedCorpus.name = "generated-" + std::to_string(scale);
+    if (!GenerateCorpus(generatedCorpus, generatedDir, scale)) {
+      return 1;
+    }
+    corpora.push_back(std::move(generatedCorpus));
+  }
+
+  std::error_code ec;
+  llvm::raw_fd_ostream os(outputPath, ec);
+  if (ec) {
+    llvm::errs() << "error: cannot write '" << outputPath << "'\n";
+    return 1;
+  }
+
+  int exitCode = 0;
+  llvm::json::OStream json(os, /*IndentSize=*/2);
+  json.object([&] {
+    json.attributeArray("corpora", [&] {
+      for (const auto &corpus : corpora) {
+        std::vector<ParseBenchSample> samples(
+            std::max<unsigned>(1, iterations));
+        uint64_t peakRSS = 0;
+        // Nothing may be buffered when a child process is forked.
+        os.flush();
+        if (!MeasureCorpus(corpus, mainExecutablePath, mainExecutableName,
+                           samples, peakRSS)) {
+          llvm::errs() << "error: cannot set up '" << corpus.name << "'\n";
+          exitCode = 1;
+          return;
+        }
+        ReportCorpus(json, corpus, samples, peakRSS);
+        // The generated corpora are meant to parse cleanly; an error means
+        // the generator and the parser have drifted apart.
+        bool hadError = llvm::any_of(
+            samples, [](const ParseBenchSample &s) { return s.hadError; });
+        if (hadError && llvm::StringRef(corpus.name).startswith("generated-")) {
+          llvm::errs() << "error: '" << corpus.name << "' did not parse\n";
+          exitCode = 1;
+        }
+      }
+    });
+    if (importModules > 0) {
+      ReportImports(json, importModules);
+    }
+  });
+  os << "\n";
+
+  if (!generatedDir.empty()) {
+    llvm::sys::fs::remove_directories(generatedDir);
+  }
+  return exitCode;
+}
@@ -0,0 +1,134 @@
+// A libFuzzer target over the Lexer and Parser.
+//
+// Each input is lexed to the end and then parsed as a library source file
+// with token collection and the syntax tree enabled. Besides crashes, the
+// fuzzer looks for performance cliffs without timing anything: the parser's
+// lexer counts every token it lexes, including tokens lexed again after
+// backtracking, and an input whose parse lexes far more tokens than the input
+// holds (unbounded lookahead, quadratic recovery) aborts so that libFuzzer
+// keeps it as an artifact. The count does not depend on the machine or its
+// load, so such an artifact reproduces every time.
+//
+// No configuration builds this target yet: the root CMakeLists does not add
+// tools/, and lib/CMakeLists skips Parse. It has not been built or run.
+//
+// Environment:
+//   STONE_PARSE_FUZZER_RELEX_RATIO  How many times the input's token count
+//                                   the parse may lex (default 16; 0 turns
+//                                   the check off).
+
+#include "stone/AST/ASTContext.h"
+#include "stone/AST/ClangImporter.h"
+#include "stone/AST/Module.h"
+#include "stone/AST/SearchPath.h"
+#include "stone/AST/SyntaxTree.h"
+#include "stone/AST/TypeCheckerOptions.h"
+#include "stone/Basic/LangOptions.h"
+#include "stone/Basic/SrcMgr.h"
+#include "stone/Parse/Lexer.h"
+#include "stone/Parse/Parser.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
+#include <memory>
+
+using namespace stone;
+
+namespace {
+/// The options shared by every input.
+struct ParseFuzzerOptions final {
+  LangOptions langOpts;
+  SearchPathOptions searchPathOpts;
+  TypeCheckerOptions typeCheckerOpts;
+  std::unique_ptr<ClangImporter> clangImporter;
+};
+
+/// Bounds the tokens a parse may lex relative to the tokens in its input.
+class ParseWorkMonitor final {
+  /// Lookahead lexes a few tokens more than once in any input, so tiny inputs
+  /// get this much on top of the ratio.
+  static constexpr unsigned slackTokens = 64;
+
+  unsigned relexRatio = 16;
+
+public:
+  ParseWorkMonitor() {
+    if (const char *ratio = std::getenv("STONE_PARSE_FUZZER_RELEX_RATIO")) {
+      relexRatio = std::atoi(ratio);
+    }
+  }
+
+  /// \return true if lexing \p lexedTokens while parsing an input of
+  /// \p inputTokens tokens is far more work than the input asks for.
+  bool IsTooMuchWork(unsigned inputTokens, unsigned lexedTokens) const {
+    if (relexRatio == 0) {
+      return false;
+    }
+    uint64_t budget =
+        static_cast<uint64_t>(inputTokens) * relexRatio + slackTokens;
+    if (lexedTokens <= budget) {
+      return false;
+    }
+    llvm::errs() << "stone-parse-fuzzer: slow input: " << lexedTokens
+                 << " tokens lexed to parse " << inputTokens
+                 << " tokens (budget " << budget << ")\n";
+    return true;
+  }
+};
+} // namespace
+
+static ParseFuzzerOptions *fuzzerOpts = nullptr;
+static ParseWorkMonitor *workMonitor = nullptr;
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  fuzzerOpts = new ParseFuzzerOptions();
+  fuzzerOpts->clangImporter = std::make_unique<ClangImporter>();
+  workMonitor = new ParseWorkMonitor();
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  llvm::StringRef input(reinterpret_cast<const char *>(data), size);
+
+  SrcMgr sm;
+  DiagnosticEngine de(sm);
+  unsigned bufferID = sm.addMemBufferCopy(input, "fuzz.stone");
+
+  // Lex the whole buffer on its own first, so lexer-only paths are covered
+  // even when the parser gives up early. This also counts the input's tokens.
+  Lexer lexer(bufferID, sm, &de, nullptr, &fuzzerOpts->langOpts);
+  Token token;
+  do {
+    lexer.Lex(token);
+  } while (token.IsNot(tok::eof));
+  unsigned inputTokens = lexer.getNumTokensLexed();
+
+  ASTContext astContext(fuzzerOpts->langOpts, fuzzerOpts->searchPathOpts,
+                        fuzzerOpts->typeCheckerOpts,
+                        *fuzzerOpts->clangImporter, de, nullptr);
+  auto *mainModule = ModuleDecl::CreateMainModule(
+      astContext.GetIdentifier("Fuzz"), astContext);
+  auto *sourceFile = SourceFile::Create(SourceFileKind::Library, bufferID,
+                                        *mainModule, astContext);
+  SourceFile::ParsingOptions parsingOpts;
+  parsingOpts |= SourceFile::ParsingFlags::CollectParsedTokens;
+  parsingOpts |= SourceFile::ParsingFlags::BuildSyntaxTree;
+  sourceFile->SetParsingOptions(parsingOpts);
+
+  Parser parser(*sourceFile, astContext);
+  parser.ParseTopLevelDecls();
+  unsigned lexedTokens = parser.GetLexer().getNumTokensLexed();
+
+  // The syntax tree must reproduce the input byte for byte.
+  if (auto *syntaxTree = sourceFile->GetSyntaxTree()) {
+    if (syntaxTree->GetSourceText() != input) {
+      llvm::errs() << "stone-parse-fuzzer: syntax tree is not lossless\n";
+      std::abort();
+    }
+  }
+  if (workMonitor->IsTooMuchWork(inputTokens, lexedTokens)) {
+    std::abort();
+  }
+  return 0;
+}